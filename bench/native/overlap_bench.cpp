@@ -0,0 +1,135 @@
+// Micro-benchmark for the window overlap search in native_stream.cpp.
+//
+// Compares token_overlap (KMP, linear) against the quadratic scan it replaced
+// on token lists of growing length, checking that both return the same
+// boundary. Build and run with `make bench-overlap`.
+
+#include "token_overlap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+using token = int32_t;
+
+// The previous find_common_prefix body, kept as the reference.
+size_t quadratic_overlap(const std::vector<token> &previous, const std::vector<token> &current) {
+    size_t best = 0;
+    for (size_t i = 0; i < previous.size(); ++i) {
+        size_t len = 0;
+        while (i + len < previous.size() && len < current.size() && previous[i + len] == current[len]) {
+            len++;
+        }
+        best = std::max(best, len);
+    }
+    return best;
+}
+
+struct workload {
+    std::vector<token> previous;
+    std::vector<token> current;
+};
+
+// A sliding window: current re-decodes the second half of previous and adds
+// as many new tokens.
+workload shifted_window(size_t n, std::mt19937 &rng) {
+    std::uniform_int_distribution<token> vocab(0, 50000);
+    workload w;
+    w.previous.resize(n);
+    for (auto &t : w.previous) {
+        t = vocab(rng);
+    }
+    w.current.assign(w.previous.begin() + static_cast<std::ptrdiff_t>(n / 2), w.previous.end());
+    for (size_t i = 0; i < n / 2; ++i) {
+        w.current.push_back(vocab(rng));
+    }
+    return w;
+}
+
+// Repeated tokens (silence, "the the the"), the quadratic scan's worst case.
+workload repeated_token(size_t n) {
+    workload w;
+    w.previous.assign(n, 42);
+    w.current.assign(n, 42);
+    w.current.back() = 7;
+    return w;
+}
+
+// Keeps the compiler from hoisting the pure overlap calls out of the loop.
+inline void clobber_memory() {
+    asm volatile("" ::: "memory");
+}
+
+template <typename F>
+double ns_per_call(F &&fn, size_t &result) {
+    using clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    for (;;) {
+        const auto start = clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            result = fn();
+            clobber_memory();
+        }
+        const double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        if (ns > 2e8 || iterations >= (1u << 24)) {
+            return ns / static_cast<double>(iterations);
+        }
+        iterations *= 2;
+    }
+}
+
+bool run(const char *name, const workload &w) {
+    std::vector<size_t> failure;
+    size_t linear = 0;
+    size_t quadratic = 0;
+    const double linear_ns = ns_per_call([&] { return token_overlap(w.previous, w.current, failure); }, linear);
+    const double quadratic_ns = ns_per_call([&] { return quadratic_overlap(w.previous, w.current); }, quadratic);
+    std::printf("%-10s %8zu %10zu %14.0f %14.0f %9.1fx%s\n",
+                name, w.previous.size(), linear, linear_ns, quadratic_ns,
+                quadratic_ns / linear_ns, linear == quadratic ? "" : "  MISMATCH");
+    return linear == quadratic;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(1234);
+    std::printf("%-10s %8s %10s %14s %14s %10s\n",
+                "workload", "tokens", "overlap", "kmp_ns", "quadratic_ns", "speedup");
+
+    bool ok = true;
+    for (size_t n = 64; n <= 16384; n *= 4) {
+        ok = run("shifted", shifted_window(n, rng)) && ok;
+    }
+    for (size_t n = 64; n <= 16384; n *= 4) {
+        ok = run("repeated", repeated_token(n)) && ok;
+    }
+
+    // Randomised equivalence check on small alphabets, where partial matches
+    // and failure-function fallbacks are frequent.
+    std::uniform_int_distribution<size_t> length(0, 40);
+    std::uniform_int_distribution<token> small_vocab(0, 2);
+    std::vector<size_t> failure;
+    for (int trial = 0; trial < 200000; ++trial) {
+        workload w;
+        w.previous.resize(length(rng));
+        w.current.resize(length(rng));
+        for (auto &t : w.previous) {
+            t = small_vocab(rng);
+        }
+        for (auto &t : w.current) {
+            t = small_vocab(rng);
+        }
+        if (token_overlap(w.previous, w.current, failure) != quadratic_overlap(w.previous, w.current)) {
+            std::printf("mismatch on random trial %d\n", trial);
+            ok = false;
+            break;
+        }
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,456 @@
+// Standalone benchmark for the native streaming layer (internal/engine/native_stream.cpp).
+//
+// Replays PCM16 WAV fixtures through whisper_stream in fixed-size chunks, either
+// paced at real time or as fast as possible, for every combination of the
+// requested weight formats, modes, beam sizes and GPU settings. Build and run with
+// `make bench-native`; see README.md for the flags.
+
+#include "native_stream.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+// Counts C++ heap allocations made anywhere in the process, whisper.cpp included.
+static std::atomic<uint64_t> g_allocations{0};
+
+void *operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr int kSampleRate = 16000;
+
+struct options {
+    std::string model_path;
+    std::vector<std::string> wavs;
+    std::vector<std::string> modes = {"sliding", "vad"};
+    std::vector<int> beams = {1, 5};
+    std::vector<bool> gpu = {false};
+    // "none" benchmarks the model file as given; q5_0/q8_0 quantize it into
+    // quant_dir first (once) and benchmark the copy.
+    std::vector<std::string> quants = {"none"};
+    std::string quant_dir = "/tmp";
+    int chunk_ms = 100;
+    int threads = 4;
+    // VAD-mode trailing silence; 0 keeps the native default. The vad-spec
+    // mode also decodes speculatively at the first sign of silence.
+    int endpoint_ms = 0;
+    bool realtime = false;
+    bool max_speed = true;
+};
+
+struct run_result {
+    std::vector<double> step_ms;
+    double flush_ms = 0.0;
+    double compute_ms = 0.0;
+    double wall_ms = 0.0;
+    double audio_ms = 0.0;
+    uint64_t allocations = 0;
+    int transcripts = 0;
+};
+
+double elapsed_ms(bench_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - since).count();
+}
+
+double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const size_t idx = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+    return values[std::min(idx, values.size() - 1)];
+}
+
+double peak_rss_mb() {
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+}
+
+uint32_t read_u32(const unsigned char *p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t read_u16(const unsigned char *p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+// Loads a mono 16 kHz PCM16 WAV file, mirroring loadPCM16LE in the Go tests.
+bool load_wav(const std::string &path, std::vector<int16_t> &samples, std::string &error) {
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<unsigned char> data;
+    unsigned char buf[65536];
+    size_t n = 0;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    std::fclose(f);
+
+    if (data.size() < 12 || std::memcmp(data.data(), "RIFF", 4) != 0 ||
+        std::memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        error = "invalid wav header in " + path;
+        return false;
+    }
+
+    uint16_t format = 0;
+    uint16_t channels = 0;
+    uint16_t bits = 0;
+    uint32_t rate = 0;
+    const unsigned char *pcm = nullptr;
+    size_t pcm_size = 0;
+    for (size_t offset = 12; offset + 8 <= data.size();) {
+        const unsigned char *chunk = data.data() + offset;
+        const size_t size = read_u32(chunk + 4);
+        const size_t start = offset + 8;
+        if (start + size > data.size()) {
+            error = "chunk out of range in " + path;
+            return false;
+        }
+        if (std::memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            format = read_u16(chunk + 8);
+            channels = read_u16(chunk + 10);
+            rate = read_u32(chunk + 12);
+            bits = read_u16(chunk + 22);
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            pcm = chunk + 8;
+            pcm_size = size;
+        }
+        offset = start + size + (size % 2);
+    }
+
+    if (format != 1 || channels != 1 || bits != 16 || rate != kSampleRate || pcm == nullptr) {
+        error = path + ": expected mono 16 kHz PCM16";
+        return false;
+    }
+    samples.resize(pcm_size / 2);
+    std::memcpy(samples.data(), pcm, samples.size() * sizeof(int16_t));
+    return true;
+}
+
+whisper_stream *create_stream(whisper_stream_model *model, const std::string &mode, int beam, const options &opts) {
+    const bool speculative = mode == "vad-spec";
+    const bool vad = mode == "vad" || speculative;
+    whisper_stream *stream = whisper_stream_create_from_model(model,
+                                            vad ? 0 : 3000, // step_ms
+                                            10000,          // length_ms
+                                            vad ? 0 : 200,  // keep_ms
+                                            opts.threads,
+                                            false, // translate
+                                            0.2f,  // temperature_inc
+                                            false, // disable_fallback
+                                            beam,
+                                            0,     // audio_ctx
+                                            vad,   // print_timestamps
+                                            false, // print_special
+                                            false, // keep_context
+                                            vad,
+                                            0.6f,   // vad_thold
+                                            100.0f, // freq_thold
+                                            0,      // max_tokens
+                                            false); // tinydiarize
+    if (stream != nullptr && vad && (opts.endpoint_ms > 0 || speculative)) {
+        whisper_stream_set_endpointing(stream, opts.endpoint_ms > 0 ? opts.endpoint_ms : 1000, 0, 0, speculative);
+    }
+    return stream;
+}
+
+// Feeds one fixture through a fresh stream. Audio is buffered with
+// whisper_stream_push_s16 and each ready window is timed around
+// whisper_stream_step, so step latency excludes the cheap buffering calls.
+bool replay(whisper_stream_model *model, const std::string &mode, int beam, const options &opts,
+            const std::vector<int16_t> &audio, bool realtime, run_result &out) {
+    whisper_stream *stream = create_stream(model, mode, beam, opts);
+    if (stream == nullptr) {
+        return false;
+    }
+    whisper_stream_set_language(stream, "en", false);
+
+    const size_t chunk = static_cast<size_t>(kSampleRate) * opts.chunk_ms / 1000;
+    const uint64_t allocations_before = g_allocations.load();
+    const auto start = bench_clock::now();
+    bool ok = true;
+
+    for (size_t offset = 0; offset < audio.size() && ok; offset += chunk) {
+        const size_t n = std::min(chunk, audio.size() - offset);
+        if (realtime) {
+            // Pace arrivals at wall-clock rate; a slow step delays later chunks
+            // exactly as it would on a live stream.
+            const auto due = start + std::chrono::microseconds(
+                static_cast<int64_t>(offset) * 1000000 / kSampleRate);
+            std::this_thread::sleep_until(due);
+        }
+
+        const int ready = whisper_stream_push_s16(stream, audio.data() + offset, static_cast<int32_t>(n));
+        if (ready < 0) {
+            ok = false;
+            break;
+        }
+        if (ready == 0) {
+            continue;
+        }
+
+        char *text = nullptr;
+        float confidence = 0.0f;
+        const auto step_start = bench_clock::now();
+        const int rc = whisper_stream_step(stream, &text, &confidence, nullptr, nullptr);
+        const double ms = elapsed_ms(step_start);
+        out.step_ms.push_back(ms);
+        out.compute_ms += ms;
+        if (rc < 0) {
+            ok = false;
+        } else if (rc == 1) {
+            out.transcripts++;
+        }
+        whisper_stream_free_text(text);
+    }
+
+    if (ok) {
+        char *text = nullptr;
+        float confidence = 0.0f;
+        const auto flush_start = bench_clock::now();
+        ok = whisper_stream_flush(stream, &text, &confidence) >= 0;
+        out.flush_ms = elapsed_ms(flush_start);
+        out.compute_ms += out.flush_ms;
+        whisper_stream_free_text(text);
+    }
+
+    out.wall_ms = elapsed_ms(start);
+    out.audio_ms = static_cast<double>(audio.size()) * 1000.0 / kSampleRate;
+    out.allocations = g_allocations.load() - allocations_before;
+    whisper_stream_free(stream);
+    return ok;
+}
+
+std::vector<std::string> split(const std::string &value) {
+    std::vector<std::string> parts;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            parts.push_back(item);
+        }
+    }
+    return parts;
+}
+
+void usage(const char *argv0) {
+    std::fprintf(stderr,
+                 "usage: %s --model PATH [--wav FILE]... [--modes sliding,vad,vad-spec] [--beams 1,5]\n"
+                 "          [--gpu off,on] [--pace max|realtime|both] [--chunk-ms 100] [--threads 4]\n"
+                 "          [--quant none,q8_0,q5_0] [--quant-dir /tmp] [--endpoint-ms 1000]\n",
+                 argv0);
+}
+
+bool parse_args(int argc, char **argv, options &opts) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return false;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--model") {
+            opts.model_path = value;
+        } else if (arg == "--wav") {
+            opts.wavs.push_back(value);
+        } else if (arg == "--modes") {
+            opts.modes = split(value);
+        } else if (arg == "--beams") {
+            opts.beams.clear();
+            for (const auto &beam : split(value)) {
+                opts.beams.push_back(std::max(1, std::atoi(beam.c_str())));
+            }
+        } else if (arg == "--gpu") {
+            opts.gpu.clear();
+            for (const auto &gpu : split(value)) {
+                opts.gpu.push_back(gpu == "on" || gpu == "1" || gpu == "true");
+            }
+        } else if (arg == "--pace") {
+            opts.realtime = value == "realtime" || value == "both";
+            opts.max_speed = value == "max" || value == "both";
+        } else if (arg == "--chunk-ms") {
+            opts.chunk_ms = std::max(10, std::atoi(value.c_str()));
+        } else if (arg == "--threads") {
+            opts.threads = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--quant") {
+            opts.quants = split(value);
+        } else if (arg == "--quant-dir") {
+            opts.quant_dir = value;
+        } else if (arg == "--endpoint-ms") {
+            opts.endpoint_ms = std::max(0, std::atoi(value.c_str()));
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opts.model_path.empty() || opts.wavs.empty() || opts.modes.empty() ||
+        opts.beams.empty() || opts.gpu.empty() || opts.quants.empty() || (!opts.realtime && !opts.max_speed)) {
+        usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+// Path of the model in the requested weight format, quantizing it on first
+// use; empty on failure.
+std::string variant_path(const options &opts, const std::string &quant) {
+    int32_t ftype = 0;
+    if (quant == "none") {
+        return opts.model_path;
+    } else if (quant == "q5_0") {
+        ftype = WHISPER_STREAM_FTYPE_Q5_0;
+    } else if (quant == "q8_0") {
+        ftype = WHISPER_STREAM_FTYPE_Q8_0;
+    } else {
+        std::fprintf(stderr, "unknown --quant %s\n", quant.c_str());
+        return "";
+    }
+    std::string name = opts.model_path.substr(opts.model_path.find_last_of('/') + 1);
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".bin") == 0) {
+        name.resize(name.size() - 4);
+    }
+    const std::string path = opts.quant_dir + "/" + name + "-" + quant + ".bin";
+    if (FILE *cached = std::fopen(path.c_str(), "rb")) {
+        std::fclose(cached);
+        return path;
+    }
+    const auto start = bench_clock::now();
+    const int rc = whisper_stream_model_quantize(opts.model_path.c_str(), path.c_str(), ftype, opts.threads);
+    if (rc < 0) {
+        std::fprintf(stderr, "failed to quantize %s to %s (rc=%d)\n", opts.model_path.c_str(), quant.c_str(), rc);
+        return "";
+    }
+    if (rc == 1) {
+        std::fprintf(stderr, "%s is already quantized; benchmarking it as %s\n", opts.model_path.c_str(), quant.c_str());
+        return opts.model_path;
+    }
+    std::fprintf(stderr, "quantized %s in %.0f ms\n", path.c_str(), elapsed_ms(start));
+    return path;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    options opts;
+    if (!parse_args(argc, argv, opts)) {
+        return 2;
+    }
+
+    std::vector<std::vector<int16_t>> fixtures;
+    for (const auto &path : opts.wavs) {
+        std::vector<int16_t> samples;
+        std::string error;
+        if (!load_wav(path, samples, error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        fixtures.push_back(std::move(samples));
+    }
+
+    std::printf("%-5s %-8s %-4s %-3s %-8s %-24s %6s %8s %8s %8s %8s %8s %7s %9s %9s %10s\n",
+                "quant", "mode", "beam", "gpu", "pace", "fixture", "steps", "p50_ms", "p90_ms", "p99_ms",
+                "max_ms", "flush_ms", "rtf", "model_mb", "rss_mb", "allocs/s");
+
+    int failures = 0;
+    for (const auto &quant : opts.quants) {
+        const std::string model_path = variant_path(opts, quant);
+        if (model_path.empty()) {
+            return 1;
+        }
+        for (const bool gpu : opts.gpu) {
+            whisper_stream_model *model = whisper_stream_model_load(model_path.c_str(), gpu, gpu);
+            if (model == nullptr) {
+                std::fprintf(stderr, "failed to load %s (gpu=%d)\n", model_path.c_str(), gpu);
+                return 1;
+            }
+            whisper_stream_model_info info{};
+            whisper_stream_model_get_info(model, &info);
+            const double model_mb = static_cast<double>(info.weight_bytes) / (1024.0 * 1024.0);
+            for (const auto &mode : opts.modes) {
+                for (const int beam : opts.beams) {
+                    for (int pace = 0; pace < 2; ++pace) {
+                        const bool realtime = pace == 1;
+                        if ((realtime && !opts.realtime) || (!realtime && !opts.max_speed)) {
+                            continue;
+                        }
+                        for (size_t i = 0; i < fixtures.size(); ++i) {
+                            run_result result;
+                            if (!replay(model, mode, beam, opts, fixtures[i], realtime, result)) {
+                                std::fprintf(stderr, "replay failed: %s mode=%s beam=%d\n",
+                                             opts.wavs[i].c_str(), mode.c_str(), beam);
+                                failures++;
+                                continue;
+                            }
+                            const std::string name = opts.wavs[i].substr(opts.wavs[i].find_last_of('/') + 1);
+                            std::printf("%-5s %-8s %-4d %-3s %-8s %-24s %6zu %8.1f %8.1f %8.1f %8.1f %8.1f %7.3f %9.1f %9.1f %10.0f\n",
+                                        quant.c_str(), mode.c_str(), beam, gpu ? "on" : "off",
+                                        realtime ? "realtime" : "max", name.c_str(),
+                                        result.step_ms.size(),
+                                        percentile(result.step_ms, 0.50),
+                                        percentile(result.step_ms, 0.90),
+                                        percentile(result.step_ms, 0.99),
+                                        percentile(result.step_ms, 1.0),
+                                        result.flush_ms,
+                                        result.compute_ms / result.audio_ms,
+                                        model_mb,
+                                        peak_rss_mb(),
+                                        static_cast<double>(result.allocations) * 1000.0 / result.wall_ms);
+                            std::fflush(stdout);
+                        }
+                    }
+                }
+            }
+            whisper_stream_model_free(model);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -69,6 +69,9 @@ func main() {
 		"use_gpu", logBoolField(cfg.UseGPU),
 		"flash_attention", logBoolField(cfg.FlashAttention),
 		"threads", logThreadsField(cfg.Threads),
+		"draft_model_variant", cfg.DraftModelVariant,
+		"gpu_devices", cfg.GPUDevices,
+		"model_routes", cfg.ModelRoutes,
 	)
 
 	recorder := telemetry.NewRecorder(logger)
@@ -125,6 +128,8 @@ func main() {
 		}
 	}()
 
+	engine.AttachObserver(eng, recorder)
+
 	// STEP 5: Activate the real STT service now that engine is ready
 	realService := server.New(cfg, logger, eng, recorder)
 	lazyService.setServer(realService)
@@ -174,6 +179,72 @@ func main() {
 			"total_bytes", snapshot.TotalBytes,
 			"total_flushes", snapshot.TotalFlushes,
 		)
+		if snapshot.TotalAdmitted+snapshot.TotalRejected > 0 {
+			logger.Info("admission queue totals",
+				"admitted", snapshot.TotalAdmitted,
+				"steps_skipped", snapshot.TotalStepsSkipped,
+				"rejected", snapshot.TotalRejected,
+				"peak_queue_depth", snapshot.PeakQueueDepth,
+				"interactive_wait_p99_ms", snapshot.QueueWaitInteractive.Quantile(0.99).Milliseconds(),
+				"batch_wait_p99_ms", snapshot.QueueWaitBatch.Quantile(0.99).Milliseconds(),
+			)
+		}
+		if snapshot.TotalMelFramesReused > 0 {
+			logger.Info("mel cache totals",
+				"frames_computed", snapshot.TotalMelFramesComputed,
+				"frames_reused", snapshot.TotalMelFramesReused,
+				"est_saved_ms", snapshot.MelMillisSaved(),
+			)
+		}
+		if snapshot.TotalSilentWindows > 0 || snapshot.TotalSilentSamples > 0 {
+			logger.Info("speech gate totals",
+				"silent_windows", snapshot.TotalSilentWindows,
+				"silent_seconds", snapshot.TotalSilentSamples/16000,
+				"decoded_seconds", snapshot.TotalWindowSamples/16000,
+			)
+		}
+		if snapshot.TotalEndpoints > 0 {
+			logger.Info("endpoint totals",
+				"endpoints", snapshot.TotalEndpoints,
+				"mean_wait_ms", snapshot.MeanEndpointWait().Milliseconds(),
+				"speculations", snapshot.TotalSpeculations,
+				"speculation_hits", snapshot.TotalSpeculationHits,
+			)
+		}
+		if memory := snapshot.StateMemory; memory.KVCrossBytes > 0 {
+			logger.Info("state memory",
+				"state_mb", memory.StateBytes>>20,
+				"kv_self_mb", memory.KVSelfBytes>>20,
+				"kv_cross_mb", memory.KVCrossBytes>>20,
+			)
+		}
+		if snapshot.TotalInferencePasses > 0 {
+			logger.Info("inference stage totals",
+				"passes", snapshot.TotalInferencePasses,
+				"fallbacks", snapshot.TotalFallbacks,
+				"audio_ctx_retries", snapshot.TotalAudioCtxRetries,
+				"repetition_loops", snapshot.TotalRepetitionLoops,
+				"repetition_cuts", snapshot.TotalRepetitionCuts,
+				"beam_reruns", snapshot.TotalBeamReruns,
+				"beam_rerun_rate", snapshot.BeamRerunRate(),
+				"language_detects", snapshot.TotalLanguageDetects,
+				"language_reuses", snapshot.TotalLanguageReuses,
+				"tokens", snapshot.TotalTokens,
+				"encode_p50_ms", snapshot.StageEncode.Quantile(0.5).Milliseconds(),
+				"encode_p99_ms", snapshot.StageEncode.Quantile(0.99).Milliseconds(),
+				"decode_p50_ms", snapshot.StageDecode.Quantile(0.5).Milliseconds(),
+				"decode_p99_ms", snapshot.StageDecode.Quantile(0.99).Milliseconds(),
+				"mel_p99_ms", snapshot.StageMel.Quantile(0.99).Milliseconds(),
+			)
+		}
+		for _, replica := range snapshot.Replicas {
+			logger.Info("model replica totals",
+				"replica", replica.Name,
+				"sessions", replica.TotalSessions,
+				"passes", replica.InferencePasses,
+				"inference_ms", replica.InferenceTime.Milliseconds(),
+			)
+		}
 	}
 
 	logger.Info("adapter stopped")
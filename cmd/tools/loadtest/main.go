@@ -0,0 +1,383 @@
+// Command loadtest drives a running adapter end to end over gRPC. It opens
+// --streams concurrent StreamTranscription calls, replays WAV recordings at
+// real-time pace, and writes a JSON report with time-to-first-partial,
+// time-to-final, per-segment latency, real-time factor (with --pace fast)
+// and the adapter's memory over the run. With --duration it becomes a soak test: each stream
+// replays recordings back to back and the report flags steady memory growth.
+package main
+
+import (
+	"context"
+	"encoding/json"
+	"errors"
+	"flag"
+	"fmt"
+	"log/slog"
+	"os"
+	"os/signal"
+	"path/filepath"
+	"sort"
+	"strings"
+	"sync"
+	"syscall"
+	"time"
+
+	"google.golang.org/grpc"
+	"google.golang.org/grpc/credentials/insecure"
+
+	napv1 "github.com/nupi-ai/nupi/api/nap/v1"
+)
+
+type listFlag []string
+
+func (l *listFlag) String() string     { return strings.Join(*l, ",") }
+func (l *listFlag) Set(v string) error { *l = append(*l, v); return nil }
+
+type options struct {
+	Addr           string            `json:"addr"`
+	Streams        int               `json:"streams"`
+	WAVs           []string          `json:"wav"`
+	SegmentMs      int               `json:"segment_ms"`
+	Pace           string            `json:"pace"`
+	Duration       time.Duration     `json:"duration_ns"`
+	Ramp           time.Duration     `json:"ramp_ns"`
+	Metadata       map[string]string `json:"metadata,omitempty"`
+	PID            int               `json:"pid,omitempty"`
+	VRAM           bool              `json:"vram"`
+	SampleInterval time.Duration     `json:"sample_interval_ns"`
+	SoakWarmup     time.Duration     `json:"soak_warmup_ns"`
+	MaxGrowthMBph  float64           `json:"max_growth_mb_per_hour"`
+}
+
+// latencySummary describes one set of latency samples in milliseconds.
+type latencySummary struct {
+	Count  int     `json:"count"`
+	MeanMs float64 `json:"mean_ms"`
+	P50Ms  float64 `json:"p50_ms"`
+	P90Ms  float64 `json:"p90_ms"`
+	P99Ms  float64 `json:"p99_ms"`
+}
+
+type rtfSummary struct {
+	Count int     `json:"count"`
+	Mean  float64 `json:"mean"`
+	P50   float64 `json:"p50"`
+	P90   float64 `json:"p90"`
+	Max   float64 `json:"max"`
+}
+
+type report struct {
+	Options           options           `json:"options"`
+	ElapsedSeconds    float64           `json:"elapsed_s"`
+	SessionsCompleted uint64            `json:"sessions_completed"`
+	SessionsFailed    uint64            `json:"sessions_failed"`
+	Errors            map[string]uint64 `json:"errors,omitempty"`
+	AudioSeconds      float64           `json:"audio_s"`
+	SegmentsSent      uint64            `json:"segments_sent"`
+	SegmentsAnswered  uint64            `json:"segments_answered"`
+	Partials          uint64            `json:"partials"`
+	Finals            uint64            `json:"finals"`
+	FirstPartial      latencySummary    `json:"time_to_first_partial"`
+	Final             latencySummary    `json:"time_to_final"`
+	Segment           latencySummary    `json:"segment_latency"`
+	RTF               *rtfSummary       `json:"rtf,omitempty"` // --pace fast only
+	Memory            []memorySample    `json:"memory,omitempty"`
+	MemoryTrend       *memoryTrend      `json:"memory_trend,omitempty"`
+}
+
+func main() {
+	logger := slog.New(slog.NewTextHandler(os.Stderr, nil))
+	opts, reportPath, err := parseFlags(os.Args[1:])
+	if err != nil {
+		logger.Error("invalid arguments", "error", err)
+		os.Exit(2)
+	}
+	recs := make([]recording, 0, len(opts.WAVs))
+	for _, path := range opts.WAVs {
+		rec, err := loadRecording(path)
+		if err != nil {
+			logger.Error("failed to load recording", "error", err)
+			os.Exit(1)
+		}
+		recs = append(recs, rec)
+	}
+
+	ctx, stop := signal.NotifyContext(context.Background(), os.Interrupt, syscall.SIGTERM)
+	defer stop()
+
+	conn, err := grpc.NewClient(opts.Addr, grpc.WithTransportCredentials(insecure.NewCredentials()))
+	if err != nil {
+		logger.Error("failed to create client", "addr", opts.Addr, "error", err)
+		os.Exit(1)
+	}
+	defer conn.Close()
+
+	rep := run(ctx, napv1.NewSpeechToTextServiceClient(conn), opts, recs, logger)
+	if err := writeReport(reportPath, rep); err != nil {
+		logger.Error("failed to write report", "error", err)
+		os.Exit(1)
+	}
+	logger.Info("load test finished",
+		"sessions", rep.SessionsCompleted,
+		"failed", rep.SessionsFailed,
+		"ttfp_p50_ms", rep.FirstPartial.P50Ms,
+		"ttf_p90_ms", rep.Final.P90Ms,
+		"segment_p99_ms", rep.Segment.P99Ms,
+	)
+	if rep.RTF != nil {
+		logger.Info("real-time factor", "mean", rep.RTF.Mean, "p90", rep.RTF.P90, "max", rep.RTF.Max)
+	}
+	if rep.MemoryTrend != nil && rep.MemoryTrend.GrowthSuspected {
+		logger.Warn("memory growth suspected",
+			"rss_mb_per_hour", rep.MemoryTrend.RSSMBPerHour,
+			"rss_kb_per_session", rep.MemoryTrend.RSSKBPerSession,
+			"vram_mb_per_hour", rep.MemoryTrend.VRAMMBPerHour,
+		)
+		os.Exit(3)
+	}
+	if rep.SessionsFailed > 0 {
+		os.Exit(1)
+	}
+}
+
+func parseFlags(args []string) (options, string, error) {
+	fs := flag.NewFlagSet("loadtest", flag.ContinueOnError)
+	var (
+		opts     options
+		wavs     listFlag
+		metadata listFlag
+		report   string
+	)
+	fs.StringVar(&opts.Addr, "addr", "127.0.0.1:50051", "adapter gRPC address")
+	fs.IntVar(&opts.Streams, "streams", 1, "concurrent streams")
+	fs.Var(&wavs, "wav", "16 kHz mono WAV to replay (repeatable; default testdata/*.wav)")
+	fs.IntVar(&opts.SegmentMs, "segment-ms", 100, "audio per segment in milliseconds")
+	fs.StringVar(&opts.Pace, "pace", "realtime", "segment pacing: realtime or fast")
+	fs.DurationVar(&opts.Duration, "duration", 0, "soak duration; 0 replays each recording once per stream")
+	fs.DurationVar(&opts.Ramp, "ramp", 0, "spread stream starts over this period")
+	fs.Var(&metadata, "metadata", "request metadata key=value (repeatable)")
+	fs.IntVar(&opts.PID, "pid", 0, "adapter process id to sample RSS from")
+	fs.BoolVar(&opts.VRAM, "vram", false, "also sample GPU memory via nvidia-smi (needs --pid)")
+	fs.DurationVar(&opts.SampleInterval, "sample-interval", 5*time.Second, "memory sampling interval")
+	fs.DurationVar(&opts.SoakWarmup, "soak-warmup", 2*time.Minute, "samples ignored before fitting memory growth")
+	fs.Float64Var(&opts.MaxGrowthMBph, "max-growth-mb-per-hour", 64, "memory growth reported as a leak")
+	fs.StringVar(&report, "report", "-", "JSON report path, - for stdout")
+	if err := fs.Parse(args); err != nil {
+		return options{}, "", err
+	}
+
+	if opts.Streams < 1 {
+		return options{}, "", fmt.Errorf("loadtest: streams must be >= 1, got %d", opts.Streams)
+	}
+	if opts.SegmentMs < 1 {
+		return options{}, "", fmt.Errorf("loadtest: segment-ms must be >= 1, got %d", opts.SegmentMs)
+	}
+	if opts.Pace != "realtime" && opts.Pace != "fast" {
+		return options{}, "", fmt.Errorf("loadtest: invalid value for pace: %q", opts.Pace)
+	}
+	if opts.VRAM && opts.PID == 0 {
+		return options{}, "", errors.New("loadtest: vram needs pid")
+	}
+	if opts.SampleInterval <= 0 {
+		opts.SampleInterval = 5 * time.Second
+	}
+	for _, kv := range metadata {
+		key, value, ok := strings.Cut(kv, "=")
+		if !ok || key == "" {
+			return options{}, "", fmt.Errorf("loadtest: invalid value for metadata: %q", kv)
+		}
+		if opts.Metadata == nil {
+			opts.Metadata = make(map[string]string)
+		}
+		opts.Metadata[key] = value
+	}
+	opts.WAVs = wavs
+	if len(opts.WAVs) == 0 {
+		matches, err := filepath.Glob("testdata/*.wav")
+		if err != nil {
+			return options{}, "", err
+		}
+		opts.WAVs = matches
+	}
+	if len(opts.WAVs) == 0 {
+		return options{}, "", errors.New("loadtest: no recordings; pass --wav")
+	}
+	return opts, report, nil
+}
+
+// run starts the streams and the memory sampler and waits for both.
+func run(ctx context.Context, client napv1.SpeechToTextServiceClient, opts options, recs []recording, logger *slog.Logger) report {
+	res := &results{errors: make(map[string]uint64)}
+	start := time.Now()
+
+	var sampler *memorySampler
+	samplerDone := make(chan struct{})
+	samplerCtx, stopSampler := context.WithCancel(context.Background())
+	if opts.PID > 0 {
+		sampler = &memorySampler{pid: opts.PID, vram: opts.VRAM, interval: opts.SampleInterval, sessions: res.completed}
+		go func() {
+			defer close(samplerDone)
+			sampler.run(samplerCtx, start)
+		}()
+	} else {
+		close(samplerDone)
+	}
+
+	runCtx := ctx
+	if opts.Duration > 0 {
+		var cancel context.CancelFunc
+		runCtx, cancel = context.WithTimeout(ctx, opts.Duration)
+		defer cancel()
+	}
+
+	var wg sync.WaitGroup
+	for i := 0; i < opts.Streams; i++ {
+		delay := time.Duration(0)
+		if opts.Streams > 1 {
+			delay = opts.Ramp * time.Duration(i) / time.Duration(opts.Streams-1)
+		}
+		wg.Add(1)
+		go func(worker int) {
+			defer wg.Done()
+			runWorker(runCtx, client, opts, recs, worker, delay, res, logger)
+		}(i)
+	}
+	wg.Wait()
+	if sampler != nil {
+		// A last sample after the streams drain shows what stays resident.
+		sampler.sample(start)
+	}
+	stopSampler()
+	<-samplerDone
+
+	return buildReport(opts, res, sampler, time.Since(start))
+}
+
+// runWorker replays recordings over one stream slot: once through every
+// recording, or back to back until ctx ends in soak mode. A session cut off
+// by the soak deadline is neither counted nor reported as a failure.
+func runWorker(ctx context.Context, client napv1.SpeechToTextServiceClient, opts options, recs []recording, worker int, delay time.Duration, res *results, logger *slog.Logger) {
+	select {
+	case <-time.After(delay):
+	case <-ctx.Done():
+		return
+	}
+	for n := 0; ; n++ {
+		if opts.Duration == 0 && n >= len(recs) {
+			return
+		}
+		if ctx.Err() != nil {
+			return
+		}
+		spec := sessionSpec{
+			id:       fmt.Sprintf("loadtest-%d-%d", worker, n),
+			streamID: fmt.Sprintf("mic-%d", worker),
+			rec:      recs[(worker+n)%len(recs)],
+			segment:  time.Duration(opts.SegmentMs) * time.Millisecond,
+			realtime: opts.Pace == "realtime",
+			metadata: opts.Metadata,
+		}
+		if err := runSession(ctx, client, spec, res); err != nil {
+			if ctx.Err() != nil {
+				return
+			}
+			res.recordError(err)
+			logger.Warn("session failed", "session_id", spec.id, "recording", spec.rec.name, "error", err)
+		}
+	}
+}
+
+func buildReport(opts options, res *results, sampler *memorySampler, elapsed time.Duration) report {
+	res.mu.Lock()
+	defer res.mu.Unlock()
+	rep := report{
+		Options:           opts,
+		ElapsedSeconds:    elapsed.Seconds(),
+		SessionsCompleted: res.sessions,
+		SessionsFailed:    res.failed,
+		Errors:            res.errors,
+		AudioSeconds:      res.audio.Seconds(),
+		SegmentsSent:      res.segmentsSent,
+		SegmentsAnswered:  res.segmentsAnswered,
+		Partials:          res.partials,
+		Finals:            res.finals,
+		FirstPartial:      summarize(res.firstPartial),
+		Final:             summarize(res.final),
+		Segment:           summarize(res.segment),
+	}
+	if len(res.rtf) > 0 {
+		rtf := summarizeRTF(res.rtf)
+		rep.RTF = &rtf
+	}
+	if sampler != nil {
+		rep.Memory = sampler.snapshot()
+		trend := fitTrend(rep.Memory, opts.SoakWarmup, opts.MaxGrowthMBph)
+		rep.MemoryTrend = &trend
+	}
+	return rep
+}
+
+func summarize(samples []time.Duration) latencySummary {
+	if len(samples) == 0 {
+		return latencySummary{}
+	}
+	ms := make([]float64, len(samples))
+	var sum float64
+	for i, d := range samples {
+		ms[i] = float64(d) / float64(time.Millisecond)
+		sum += ms[i]
+	}
+	sort.Float64s(ms)
+	return latencySummary{
+		Count:  len(ms),
+		MeanMs: sum / float64(len(ms)),
+		P50Ms:  percentile(ms, 0.5),
+		P90Ms:  percentile(ms, 0.9),
+		P99Ms:  percentile(ms, 0.99),
+	}
+}
+
+func summarizeRTF(values []float64) rtfSummary {
+	sorted := append([]float64(nil), values...)
+	sort.Float64s(sorted)
+	var sum float64
+	for _, v := range sorted {
+		sum += v
+	}
+	return rtfSummary{
+		Count: len(sorted),
+		Mean:  sum / float64(len(sorted)),
+		P50:   percentile(sorted, 0.5),
+		P90:   percentile(sorted, 0.9),
+		Max:   sorted[len(sorted)-1],
+	}
+}
+
+// percentile interpolates linearly between the closest ranks of sorted.
+func percentile(sorted []float64, q float64) float64 {
+	if len(sorted) == 0 {
+		return 0
+	}
+	rank := q * float64(len(sorted)-1)
+	lo := int(rank)
+	if lo+1 >= len(sorted) {
+		return sorted[len(sorted)-1]
+	}
+	return sorted[lo] + (sorted[lo+1]-sorted[lo])*(rank-float64(lo))
+}
+
+func writeReport(path string, rep report) error {
+	data, err := json.MarshalIndent(rep, "", "  ")
+	if err != nil {
+		return fmt.Errorf("loadtest: encode report: %w", err)
+	}
+	data = append(data, '\n')
+	if path == "-" {
+		_, err = os.Stdout.Write(data)
+		return err
+	}
+	if err := os.WriteFile(path, data, 0o644); err != nil {
+		return fmt.Errorf("loadtest: write report: %w", err)
+	}
+	return nil
+}
@@ -0,0 +1,32 @@
+package main
+
+import (
+	"testing"
+	"time"
+)
+
+func TestSummarizeReportsExactPercentiles(t *testing.T) {
+	var samples []time.Duration
+	for ms := 100; ms >= 1; ms-- {
+		samples = append(samples, time.Duration(ms)*time.Millisecond)
+	}
+	got := summarize(samples)
+	want := latencySummary{Count: 100, MeanMs: 50.5, P50Ms: 50.5, P90Ms: 90.1, P99Ms: 99.01}
+	const eps = 1e-9
+	for name, pair := range map[string][2]float64{
+		"mean": {got.MeanMs, want.MeanMs},
+		"p50":  {got.P50Ms, want.P50Ms},
+		"p90":  {got.P90Ms, want.P90Ms},
+		"p99":  {got.P99Ms, want.P99Ms},
+	} {
+		if d := pair[0] - pair[1]; d > eps || d < -eps {
+			t.Fatalf("%s: got %v, want %v", name, pair[0], pair[1])
+		}
+	}
+	if got.Count != want.Count {
+		t.Fatalf("count: got %d, want %d", got.Count, want.Count)
+	}
+	if empty := summarize(nil); empty != (latencySummary{}) {
+		t.Fatalf("expected an empty summary, got %+v", empty)
+	}
+}
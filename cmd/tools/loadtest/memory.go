@@ -0,0 +1,174 @@
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"context"
+	"fmt"
+	"os"
+	"os/exec"
+	"strconv"
+	"strings"
+	"sync"
+	"time"
+)
+
+// memorySample is the adapter's memory at one point of the run.
+type memorySample struct {
+	ElapsedSeconds float64 `json:"elapsed_s"`
+	RSSBytes       uint64  `json:"rss_bytes"`
+	VRAMBytes      uint64  `json:"vram_bytes,omitempty"`
+	Sessions       uint64  `json:"sessions_completed"`
+}
+
+// memoryTrend is the growth fitted over the samples taken after warm-up.
+type memoryTrend struct {
+	Samples             int     `json:"samples"`
+	RSSMBPerHour        float64 `json:"rss_mb_per_hour"`
+	RSSKBPerSession     float64 `json:"rss_kb_per_session"`
+	VRAMMBPerHour       float64 `json:"vram_mb_per_hour,omitempty"`
+	PeakRSSBytes        uint64  `json:"peak_rss_bytes"`
+	PeakVRAMBytes       uint64  `json:"peak_vram_bytes,omitempty"`
+	GrowthSuspected     bool    `json:"growth_suspected"`
+	GrowthThresholdMBph float64 `json:"growth_threshold_mb_per_hour"`
+}
+
+// memorySampler polls the adapter process's resident set and, optionally,
+// the GPU memory nvidia-smi attributes to it.
+type memorySampler struct {
+	pid      int
+	vram     bool
+	interval time.Duration
+	sessions func() uint64
+
+	mu      sync.Mutex
+	samples []memorySample
+}
+
+func (m *memorySampler) run(ctx context.Context, start time.Time) {
+	ticker := time.NewTicker(m.interval)
+	defer ticker.Stop()
+	for {
+		m.sample(start)
+		select {
+		case <-ctx.Done():
+			return
+		case <-ticker.C:
+		}
+	}
+}
+
+func (m *memorySampler) sample(start time.Time) {
+	s := memorySample{
+		ElapsedSeconds: time.Since(start).Seconds(),
+		Sessions:       m.sessions(),
+	}
+	if rss, err := processRSS(m.pid); err == nil {
+		s.RSSBytes = rss
+	}
+	if m.vram {
+		if used, err := processVRAM(m.pid); err == nil {
+			s.VRAMBytes = used
+		}
+	}
+	m.mu.Lock()
+	m.samples = append(m.samples, s)
+	m.mu.Unlock()
+}
+
+func (m *memorySampler) snapshot() []memorySample {
+	m.mu.Lock()
+	defer m.mu.Unlock()
+	return append([]memorySample(nil), m.samples...)
+}
+
+// processRSS reads VmRSS from /proc/<pid>/status (Linux only).
+func processRSS(pid int) (uint64, error) {
+	data, err := os.ReadFile(fmt.Sprintf("/proc/%d/status", pid))
+	if err != nil {
+		return 0, err
+	}
+	scanner := bufio.NewScanner(bytes.NewReader(data))
+	for scanner.Scan() {
+		fields := strings.Fields(scanner.Text())
+		if len(fields) >= 2 && fields[0] == "VmRSS:" {
+			kb, err := strconv.ParseUint(fields[1], 10, 64)
+			if err != nil {
+				return 0, err
+			}
+			return kb << 10, nil
+		}
+	}
+	return 0, fmt.Errorf("loadtest: no VmRSS for pid %d", pid)
+}
+
+// processVRAM sums the GPU memory nvidia-smi reports for pid across devices.
+func processVRAM(pid int) (uint64, error) {
+	out, err := exec.Command("nvidia-smi", "--query-compute-apps=pid,used_memory",
+		"--format=csv,noheader,nounits").Output()
+	if err != nil {
+		return 0, err
+	}
+	var total uint64
+	for _, line := range strings.Split(string(out), "\n") {
+		fields := strings.Split(line, ",")
+		if len(fields) != 2 || strings.TrimSpace(fields[0]) != strconv.Itoa(pid) {
+			continue
+		}
+		mib, err := strconv.ParseUint(strings.TrimSpace(fields[1]), 10, 64)
+		if err != nil {
+			return 0, err
+		}
+		total += mib << 20
+	}
+	return total, nil
+}
+
+// fitTrend fits a least-squares line through the samples taken after warmup.
+// Leaks in per-stream state, such as native buffers that outlive the session
+// pool or metrics kept per finished stream, show up as steady growth per
+// completed session once the pools have filled.
+func fitTrend(samples []memorySample, warmup time.Duration, thresholdMBph float64) memoryTrend {
+	trend := memoryTrend{GrowthThresholdMBph: thresholdMBph}
+	var steady []memorySample
+	for _, s := range samples {
+		trend.PeakRSSBytes = max(trend.PeakRSSBytes, s.RSSBytes)
+		trend.PeakVRAMBytes = max(trend.PeakVRAMBytes, s.VRAMBytes)
+		if s.ElapsedSeconds >= warmup.Seconds() && s.RSSBytes > 0 {
+			steady = append(steady, s)
+		}
+	}
+	trend.Samples = len(steady)
+	if len(steady) < 3 {
+		return trend
+	}
+	x := func(s memorySample) float64 { return s.ElapsedSeconds }
+	rssPerSecond := slope(steady, x, func(s memorySample) float64 { return float64(s.RSSBytes) })
+	trend.RSSMBPerHour = rssPerSecond * 3600 / (1 << 20)
+	trend.VRAMMBPerHour = slope(steady, x, func(s memorySample) float64 { return float64(s.VRAMBytes) }) * 3600 / (1 << 20)
+	sessions := slope(steady, func(s memorySample) float64 { return float64(s.Sessions) },
+		func(s memorySample) float64 { return float64(s.RSSBytes) })
+	trend.RSSKBPerSession = sessions / (1 << 10)
+	// Ten samples keep a single allocation spike from reading as a trend.
+	trend.GrowthSuspected = len(steady) >= 10 &&
+		(trend.RSSMBPerHour > thresholdMBph || trend.VRAMMBPerHour > thresholdMBph)
+	return trend
+}
+
+// slope returns the least-squares slope of y over x; 0 when x is constant.
+func slope(samples []memorySample, x, y func(memorySample) float64) float64 {
+	n := float64(len(samples))
+	var sx, sy, sxx, sxy float64
+	for _, s := range samples {
+		xv, yv := x(s), y(s)
+		sx += xv
+		sy += yv
+		sxx += xv * xv
+		sxy += xv * yv
+	}
+	denom := n*sxx - sx*sx
+	if denom == 0 {
+		return 0
+	}
+	return (n*sxy - sx*sy) / denom
+}
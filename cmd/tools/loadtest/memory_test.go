@@ -0,0 +1,50 @@
+package main
+
+import (
+	"math"
+	"testing"
+	"time"
+)
+
+func TestFitTrendFlagsSteadyGrowth(t *testing.T) {
+	var samples []memorySample
+	for i := 0; i < 20; i++ {
+		samples = append(samples, memorySample{
+			ElapsedSeconds: float64(i * 60),
+			// 2 MiB per minute after warm-up, a spike during it.
+			RSSBytes: uint64(100<<20 + i*2<<20),
+			Sessions: uint64(i * 4),
+		})
+	}
+	samples[1].RSSBytes = 900 << 20
+
+	trend := fitTrend(samples, 2*time.Minute, 64)
+	if trend.Samples != 18 {
+		t.Fatalf("expected 18 steady samples, got %d", trend.Samples)
+	}
+	if math.Abs(trend.RSSMBPerHour-120) > 0.01 {
+		t.Fatalf("expected 120 MB/h, got %f", trend.RSSMBPerHour)
+	}
+	if math.Abs(trend.RSSKBPerSession-512) > 0.01 {
+		t.Fatalf("expected 512 KB per session, got %f", trend.RSSKBPerSession)
+	}
+	if !trend.GrowthSuspected {
+		t.Fatalf("expected growth to be flagged: %+v", trend)
+	}
+	if trend.PeakRSSBytes != 900<<20 {
+		t.Fatalf("expected the warm-up spike as peak, got %d", trend.PeakRSSBytes)
+	}
+}
+
+func TestFitTrendIgnoresFlatAndShortRuns(t *testing.T) {
+	var flat []memorySample
+	for i := 0; i < 20; i++ {
+		flat = append(flat, memorySample{ElapsedSeconds: float64(i * 60), RSSBytes: 100 << 20, Sessions: uint64(i)})
+	}
+	if trend := fitTrend(flat, 0, 64); trend.GrowthSuspected || trend.RSSMBPerHour != 0 {
+		t.Fatalf("expected no growth for flat RSS, got %+v", trend)
+	}
+	if trend := fitTrend(flat[:5], 0, 0); trend.GrowthSuspected {
+		t.Fatalf("expected too few samples to be inconclusive, got %+v", trend)
+	}
+}
@@ -0,0 +1,186 @@
+package main
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"io"
+	"sync"
+	"time"
+
+	"google.golang.org/grpc/status"
+
+	napv1 "github.com/nupi-ai/nupi/api/nap/v1"
+)
+
+// results aggregates measurements across every session of the run. Latencies
+// are kept as raw samples so the report's percentiles are exact.
+type results struct {
+	mu               sync.Mutex
+	firstPartial     []time.Duration
+	final            []time.Duration
+	segment          []time.Duration
+	rtf              []float64
+	sessions         uint64
+	failed           uint64
+	errors           map[string]uint64
+	audio            time.Duration
+	segmentsSent     uint64
+	segmentsAnswered uint64
+	partials         uint64
+	finals           uint64
+}
+
+func (r *results) completed() uint64 {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	return r.sessions
+}
+
+func (r *results) recordError(err error) {
+	code := "unknown"
+	if s, ok := status.FromError(err); ok {
+		code = s.Code().String()
+	}
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.failed++
+	r.errors[code]++
+}
+
+// sessionSpec describes one replay of a recording over a fresh gRPC stream.
+type sessionSpec struct {
+	id       string
+	streamID string
+	rec      recording
+	segment  time.Duration
+	realtime bool
+	metadata map[string]string
+}
+
+// runSession streams one recording and records its latencies. Segment
+// latency is measured from a segment's send to the first transcript carrying
+// its sequence; segments the adapter merged into a later step are answered
+// by that step's transcript.
+func runSession(ctx context.Context, client napv1.SpeechToTextServiceClient, spec sessionSpec, res *results) error {
+	ctx, cancel := context.WithCancel(ctx)
+	defer cancel()
+	stream, err := client.StreamTranscription(ctx)
+	if err != nil {
+		return fmt.Errorf("loadtest: open stream: %w", err)
+	}
+
+	var (
+		mu           sync.Mutex
+		sent         = make(map[uint64]time.Time)
+		flushedAt    time.Time
+		firstPartial time.Duration
+		finalAt      time.Time
+		latencies    []time.Duration
+		partials     uint64
+		finals       uint64
+	)
+	// start is set before the receiver runs, so it reads it without mu.
+	start := time.Now()
+	recvDone := make(chan error, 1)
+	go func() {
+		for {
+			tr, err := stream.Recv()
+			if err != nil {
+				if errors.Is(err, io.EOF) {
+					err = nil
+				}
+				recvDone <- err
+				return
+			}
+			now := time.Now()
+			mu.Lock()
+			if sentAt, ok := sent[tr.GetSequence()]; ok {
+				latencies = append(latencies, now.Sub(sentAt))
+			}
+			for seq := range sent {
+				if seq <= tr.GetSequence() {
+					delete(sent, seq)
+				}
+			}
+			if tr.GetFinal() {
+				finals++
+				finalAt = now
+			} else {
+				partials++
+				if firstPartial == 0 {
+					firstPartial = now.Sub(start)
+				}
+			}
+			mu.Unlock()
+		}
+	}()
+
+	chunks := spec.rec.chunks(spec.segment)
+	for i, chunk := range chunks {
+		if spec.realtime {
+			if wait := time.Until(start.Add(time.Duration(i) * spec.segment)); wait > 0 {
+				select {
+				case <-time.After(wait):
+				case <-ctx.Done():
+					return ctx.Err()
+				}
+			}
+		}
+		seq := uint64(i + 1)
+		req := &napv1.StreamTranscriptionRequest{
+			SessionId: spec.id,
+			StreamId:  spec.streamID,
+			Segment:   &napv1.Segment{Sequence: seq, Audio: chunk},
+		}
+		if i == 0 {
+			req.Format = &napv1.AudioFormat{Encoding: "pcm_s16le", SampleRate: sampleRate, Channels: 1}
+			req.Metadata = spec.metadata
+		}
+		mu.Lock()
+		sent[seq] = time.Now()
+		mu.Unlock()
+		if err := stream.Send(req); err != nil {
+			return fmt.Errorf("loadtest: send segment %d: %w", seq, err)
+		}
+	}
+	mu.Lock()
+	flushedAt = time.Now()
+	mu.Unlock()
+	if err := stream.Send(&napv1.StreamTranscriptionRequest{SessionId: spec.id, StreamId: spec.streamID, Flush: true}); err != nil {
+		return fmt.Errorf("loadtest: send flush: %w", err)
+	}
+	if err := stream.CloseSend(); err != nil {
+		return fmt.Errorf("loadtest: close send: %w", err)
+	}
+	if err := <-recvDone; err != nil {
+		return err
+	}
+
+	mu.Lock()
+	defer mu.Unlock()
+	audio := spec.rec.duration()
+	// Measurements land only once the session completes, so a session cut
+	// off by the soak deadline leaves no partial samples behind.
+	res.mu.Lock()
+	defer res.mu.Unlock()
+	if firstPartial > 0 {
+		res.firstPartial = append(res.firstPartial, firstPartial)
+	}
+	res.segment = append(res.segment, latencies...)
+	if !finalAt.IsZero() {
+		res.final = append(res.final, finalAt.Sub(flushedAt))
+		// Real-time pacing alone holds the wall time at the audio length, so
+		// RTF only measures the adapter when audio is sent as fast as it goes.
+		if !spec.realtime && audio > 0 {
+			res.rtf = append(res.rtf, finalAt.Sub(start).Seconds()/audio.Seconds())
+		}
+	}
+	res.sessions++
+	res.audio += audio
+	res.segmentsSent += uint64(len(chunks))
+	res.segmentsAnswered += uint64(len(latencies))
+	res.partials += partials
+	res.finals += finals
+	return nil
+}
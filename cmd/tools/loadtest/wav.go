@@ -0,0 +1,86 @@
+package main
+
+import (
+	"encoding/binary"
+	"fmt"
+	"os"
+	"time"
+)
+
+// sampleRate is the only rate the adapter accepts: 16 kHz mono s16le.
+const sampleRate = 16000
+
+// recording is one WAV file's PCM payload.
+type recording struct {
+	name string
+	pcm  []byte
+}
+
+func (r recording) duration() time.Duration {
+	return time.Duration(len(r.pcm)/2) * time.Second / sampleRate
+}
+
+// chunks splits the recording into segments of segment audio each.
+func (r recording) chunks(segment time.Duration) [][]byte {
+	size := int(segment*sampleRate/time.Second) * 2
+	if size <= 0 {
+		size = 2
+	}
+	var out [][]byte
+	for start := 0; start < len(r.pcm); start += size {
+		end := min(start+size, len(r.pcm))
+		out = append(out, r.pcm[start:end])
+	}
+	return out
+}
+
+// loadRecording reads a 16 kHz mono 16-bit PCM WAV file.
+func loadRecording(path string) (recording, error) {
+	data, err := os.ReadFile(path)
+	if err != nil {
+		return recording{}, fmt.Errorf("loadtest: read wav: %w", err)
+	}
+	if len(data) < 12 || string(data[0:4]) != "RIFF" || string(data[8:12]) != "WAVE" {
+		return recording{}, fmt.Errorf("loadtest: %s: invalid wav header", path)
+	}
+
+	var (
+		rate          int
+		audioFormat   uint16
+		channels      uint16
+		bitsPerSample uint16
+		pcm           []byte
+	)
+	for offset := 12; offset+8 <= len(data); {
+		chunkID := string(data[offset : offset+4])
+		chunkSize := int(binary.LittleEndian.Uint32(data[offset+4 : offset+8]))
+		chunkStart := offset + 8
+		chunkEnd := chunkStart + chunkSize
+		if chunkEnd > len(data) {
+			return recording{}, fmt.Errorf("loadtest: %s: chunk %s out of range", path, chunkID)
+		}
+		switch chunkID {
+		case "fmt ":
+			if chunkSize < 16 {
+				return recording{}, fmt.Errorf("loadtest: %s: fmt chunk too small", path)
+			}
+			audioFormat = binary.LittleEndian.Uint16(data[chunkStart : chunkStart+2])
+			channels = binary.LittleEndian.Uint16(data[chunkStart+2 : chunkStart+4])
+			rate = int(binary.LittleEndian.Uint32(data[chunkStart+4 : chunkStart+8]))
+			bitsPerSample = binary.LittleEndian.Uint16(data[chunkStart+14 : chunkStart+16])
+		case "data":
+			pcm = data[chunkStart:chunkEnd]
+		}
+		// Chunks are word aligned.
+		offset = chunkEnd + chunkSize%2
+	}
+
+	if audioFormat != 1 || channels != 1 || bitsPerSample != 16 || rate != sampleRate {
+		return recording{}, fmt.Errorf("loadtest: %s: need 16 kHz mono 16-bit PCM, got format=%d channels=%d bits=%d rate=%d",
+			path, audioFormat, channels, bitsPerSample, rate)
+	}
+	if len(pcm) == 0 {
+		return recording{}, fmt.Errorf("loadtest: %s: no data chunk found", path)
+	}
+	return recording{name: path, pcm: pcm}, nil
+}
@@ -17,11 +17,11 @@ const (
 // Config captures bootstrap configuration extracted from environment variables
 // or injected JSON payload (`NUPI_ADAPTER_CONFIG`).
 type Config struct {
-	ListenAddr     string
+	ListenAddr   string
 	ModelVariant string
 	// Language mode: "client" (default), "auto", or ISO 639-1 code
 	// (e.g. "pl", "en"). Passed to whisper.cpp for transcription hints.
-	Language string
+	Language       string
 	LogLevel       string
 	DataDir        string
 	ModelPath      string
@@ -30,6 +30,89 @@ type Config struct {
 	FlashAttention *bool
 	Threads        *int
 	BeamSize       *int
+	// MaxDecoders caps the decoders, each with its own copy of the text KV
+	// cache, a pass allocates on temperature fallback; 0 keeps whisper's
+	// default. It must cover BeamSize.
+	MaxDecoders *int
+	// MelCache reuses mel-spectrogram frames between overlapping windows.
+	MelCache *bool
+	// AudioCtxAuto sizes the encoder context to each window.
+	AudioCtxAuto *bool
+	// AdaptiveBeam decodes greedily first and falls back to beam search on
+	// windows whose confidence is under AdaptiveBeamMinConfidence.
+	AdaptiveBeam              *bool
+	AdaptiveBeamMinConfidence *float64
+	// TokenTimestamps returns per-token timings with each segment.
+	TokenTimestamps *bool
+	// DTWTimestamps aligns token timings with cross-attention DTW.
+	DTWTimestamps *bool
+	// DraftModelVariant names a smaller model (e.g. "tiny") that emits fast
+	// draft partials between full passes; empty disables drafts.
+	DraftModelVariant string
+	// DraftIntervalMs is how often the draft model runs.
+	DraftIntervalMs *int
+	// WarmupMs is the synthetic clip length decoded once at startup; 0
+	// disables warm-up.
+	WarmupMs *int
+	// RepetitionThreshold is how many repeats of a looping n-gram stop
+	// decoding; 0 disables the repetition guard.
+	RepetitionThreshold *int
+	// LanguagePinWindows is how many agreeing auto-detect windows pin the
+	// stream's language (0 detects every window); LanguageMinProbability is
+	// the detection confidence that counts, and LanguageRecheckWindows how
+	// often a pinned language is checked again (0 never).
+	LanguagePinWindows     *int
+	LanguageMinProbability *float64
+	LanguageRecheckWindows *int
+	// BatchWorkers is how many chunks a batch-mode stream decodes in
+	// parallel; 0 picks one worker per 4 threads.
+	BatchWorkers *int
+	// SessionPoolSize is how many finished stream sessions are kept, reset,
+	// for new streams to reuse instead of allocating; 0 disables reuse.
+	SessionPoolSize *int
+	// VADMode transcribes whole utterances cut at trailing silence instead of
+	// sliding windows. EndpointSilenceMs is the silence that ends one
+	// (default 1000); with EndpointAdaptMs it shrinks towards
+	// EndpointMinSilenceMs as an utterance grows to that length.
+	// EndpointSpeculative decodes as soon as silence begins and keeps that
+	// text when no speech follows.
+	VADMode              *bool
+	EndpointSilenceMs    *int
+	EndpointMinSilenceMs *int
+	EndpointAdaptMs      *int
+	EndpointSpeculative  *bool
+	// CPUPinning is "none" (default) or "numa", which keeps each stream's
+	// inference threads on the cores of one NUMA node.
+	CPUPinning string
+	// ModelQuantization loads the model as "q5_0" or "q8_0", quantizing an
+	// f16 artefact into the data directory on first use; "none" (default)
+	// loads the file as it is.
+	ModelQuantization string
+	// SpeechGate skips inference on silent sliding windows: "off" (default),
+	// "energy", or "silero" for whisper.cpp's Silero VAD model.
+	SpeechGate string
+	// VADModelPath overrides the Silero model location (default
+	// <data_dir>/models/ggml-silero-v5.1.2.bin).
+	VADModelPath string
+	// GPUDevices loads one model replica per listed GPU and spreads streams
+	// across them by load; empty uses the backend's default device.
+	GPUDevices []int
+	// ModelRoutes maps ISO 639-1 codes to model variants (e.g. "en" to
+	// "base.en"); streams in a routed language are served by that variant
+	// and all others by ModelVariant.
+	ModelRoutes map[string]string
+	// AdmissionMaxInflight caps concurrent inference calls across streams;
+	// further calls queue by stream priority. 0 disables admission control.
+	AdmissionMaxInflight *int
+	// AdmissionQueueDepth bounds each priority's queue.
+	AdmissionQueueDepth *int
+	// AdmissionMaxDelayMs is how long a call may queue before live steps are
+	// merged into the next segment and batch calls are rejected.
+	AdmissionMaxDelayMs *int
+	// PipelineMaxLagMs is how much audio a live stream may queue behind its
+	// inference worker before the backlog is merged into one call; 0 merges
+	// any backlog.
+	PipelineMaxLagMs *int
 }
 
 // Validate applies defaults, checks required fields, and rejects out-of-range
@@ -60,5 +143,96 @@ func (c *Config) Validate() error {
 	if c.BeamSize != nil && *c.BeamSize < 1 {
 		return fmt.Errorf("config: beam_size must be >= 1, got %d", *c.BeamSize)
 	}
+	if c.MaxDecoders != nil && *c.MaxDecoders < 0 {
+		return fmt.Errorf("config: max_decoders must be >= 0, got %d", *c.MaxDecoders)
+	}
+	if c.MaxDecoders != nil && *c.MaxDecoders > 0 && c.BeamSize != nil && *c.BeamSize > *c.MaxDecoders {
+		return fmt.Errorf("config: max_decoders must be >= beam_size (%d), got %d", *c.BeamSize, *c.MaxDecoders)
+	}
+	if c.DraftIntervalMs != nil && *c.DraftIntervalMs < 0 {
+		return fmt.Errorf("config: draft_interval_ms must be >= 0, got %d", *c.DraftIntervalMs)
+	}
+	if c.WarmupMs != nil && *c.WarmupMs < 0 {
+		return fmt.Errorf("config: warmup_ms must be >= 0, got %d", *c.WarmupMs)
+	}
+	if c.AdaptiveBeamMinConfidence != nil && (*c.AdaptiveBeamMinConfidence < 0 || *c.AdaptiveBeamMinConfidence > 1) {
+		return fmt.Errorf("config: adaptive_beam_min_confidence must be within [0, 1], got %g", *c.AdaptiveBeamMinConfidence)
+	}
+	if c.RepetitionThreshold != nil && *c.RepetitionThreshold < 0 {
+		return fmt.Errorf("config: repetition_threshold must be >= 0, got %d", *c.RepetitionThreshold)
+	}
+	if c.LanguagePinWindows != nil && *c.LanguagePinWindows < 0 {
+		return fmt.Errorf("config: language_pin_windows must be >= 0, got %d", *c.LanguagePinWindows)
+	}
+	if c.LanguageMinProbability != nil && (*c.LanguageMinProbability < 0 || *c.LanguageMinProbability > 1) {
+		return fmt.Errorf("config: language_min_probability must be within [0, 1], got %g", *c.LanguageMinProbability)
+	}
+	if c.LanguageRecheckWindows != nil && *c.LanguageRecheckWindows < 0 {
+		return fmt.Errorf("config: language_recheck_windows must be >= 0, got %d", *c.LanguageRecheckWindows)
+	}
+	if c.BatchWorkers != nil && *c.BatchWorkers < 0 {
+		return fmt.Errorf("config: batch_workers must be >= 0, got %d", *c.BatchWorkers)
+	}
+	if c.SessionPoolSize != nil && *c.SessionPoolSize < 0 {
+		return fmt.Errorf("config: session_pool_size must be >= 0, got %d", *c.SessionPoolSize)
+	}
+	if c.EndpointSilenceMs != nil && (*c.EndpointSilenceMs < 100 || *c.EndpointSilenceMs > 5000) {
+		return fmt.Errorf("config: endpoint_silence_ms must be within [100, 5000], got %d", *c.EndpointSilenceMs)
+	}
+	if c.EndpointMinSilenceMs != nil && *c.EndpointMinSilenceMs < 0 {
+		return fmt.Errorf("config: endpoint_min_silence_ms must be >= 0, got %d", *c.EndpointMinSilenceMs)
+	}
+	if c.EndpointAdaptMs != nil && *c.EndpointAdaptMs < 0 {
+		return fmt.Errorf("config: endpoint_adapt_ms must be >= 0, got %d", *c.EndpointAdaptMs)
+	}
+	c.CPUPinning = strings.ToLower(strings.TrimSpace(c.CPUPinning))
+	if c.CPUPinning != "" && c.CPUPinning != "none" && c.CPUPinning != "numa" {
+		return fmt.Errorf("config: cpu_pinning must be 'none' or 'numa', got %q", c.CPUPinning)
+	}
+	c.ModelQuantization = strings.ToLower(strings.TrimSpace(c.ModelQuantization))
+	if c.ModelQuantization != "" && c.ModelQuantization != "none" && c.ModelQuantization != "q5_0" && c.ModelQuantization != "q8_0" {
+		return fmt.Errorf("config: model_quantization must be 'none', 'q5_0', or 'q8_0', got %q", c.ModelQuantization)
+	}
+	c.SpeechGate = strings.ToLower(strings.TrimSpace(c.SpeechGate))
+	if c.SpeechGate != "" && c.SpeechGate != "off" && c.SpeechGate != "energy" && c.SpeechGate != "silero" {
+		return fmt.Errorf("config: speech_gate must be 'off', 'energy', or 'silero', got %q", c.SpeechGate)
+	}
+	seenDevices := make(map[int]bool, len(c.GPUDevices))
+	for _, device := range c.GPUDevices {
+		if device < 0 {
+			return fmt.Errorf("config: gpu_devices must be >= 0, got %d", device)
+		}
+		if seenDevices[device] {
+			return fmt.Errorf("config: gpu_devices lists device %d more than once", device)
+		}
+		seenDevices[device] = true
+	}
+	if len(c.ModelRoutes) > 0 {
+		routes := make(map[string]string, len(c.ModelRoutes))
+		for lang, variant := range c.ModelRoutes {
+			lang = strings.ToLower(strings.TrimSpace(lang))
+			variant = strings.TrimSpace(variant)
+			if lang == "" || lang == "client" || lang == "auto" || len(lang) > 8 {
+				return fmt.Errorf("config: model_routes keys must be short ISO 639-1 codes, got %q", lang)
+			}
+			if variant == "" {
+				return fmt.Errorf("config: model_routes entry for %q needs a model variant", lang)
+			}
+			routes[lang] = variant
+		}
+		c.ModelRoutes = routes
+	}
+	if c.AdmissionMaxInflight != nil && *c.AdmissionMaxInflight < 0 {
+		return fmt.Errorf("config: admission_max_inflight must be >= 0, got %d", *c.AdmissionMaxInflight)
+	}
+	if c.AdmissionQueueDepth != nil && *c.AdmissionQueueDepth < 0 {
+		return fmt.Errorf("config: admission_queue_depth must be >= 0, got %d", *c.AdmissionQueueDepth)
+	}
+	if c.AdmissionMaxDelayMs != nil && *c.AdmissionMaxDelayMs < 0 {
+		return fmt.Errorf("config: admission_max_delay_ms must be >= 0, got %d", *c.AdmissionMaxDelayMs)
+	}
+	if c.PipelineMaxLagMs != nil && *c.PipelineMaxLagMs < 0 {
+		return fmt.Errorf("config: pipeline_max_lag_ms must be >= 0, got %d", *c.PipelineMaxLagMs)
+	}
 	return nil
 }
@@ -38,6 +38,11 @@ func (l Loader) Load() (Config, error) {
 	overrideString(l.Lookup, "NUPI_LANGUAGE_HINT", &cfg.Language)
 	overrideString(l.Lookup, "NUPI_ADAPTER_DATA_DIR", &cfg.DataDir)
 	overrideString(l.Lookup, "NUPI_MODEL_PATH", &cfg.ModelPath)
+	overrideString(l.Lookup, "NUPI_DRAFT_MODEL_VARIANT", &cfg.DraftModelVariant)
+	overrideString(l.Lookup, "WHISPERCPP_CPU_PINNING", &cfg.CPUPinning)
+	overrideString(l.Lookup, "WHISPERCPP_MODEL_QUANTIZATION", &cfg.ModelQuantization)
+	overrideString(l.Lookup, "WHISPERCPP_SPEECH_GATE", &cfg.SpeechGate)
+	overrideString(l.Lookup, "NUPI_VAD_MODEL_PATH", &cfg.VADModelPath)
 	if err := overrideBool(l.Lookup, "NUPI_ADAPTER_USE_STUB_ENGINE", &cfg.UseStubEngine); err != nil {
 		return Config{}, err
 	}
@@ -69,6 +74,188 @@ func (l Loader) Load() (Config, error) {
 		}
 		assignIntPtr(&cfg.BeamSize, parsed)
 	}
+	if value, ok := l.Lookup("WHISPERCPP_MAX_DECODERS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_MAX_DECODERS: %w", err)
+		}
+		setIntPtr(&cfg.MaxDecoders, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_MEL_CACHE"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseBool(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_MEL_CACHE: %w", err)
+		}
+		assignBoolPtr(&cfg.MelCache, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_AUDIO_CTX_AUTO"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseBool(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_AUDIO_CTX_AUTO: %w", err)
+		}
+		assignBoolPtr(&cfg.AudioCtxAuto, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_ADAPTIVE_BEAM"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseBool(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_ADAPTIVE_BEAM: %w", err)
+		}
+		assignBoolPtr(&cfg.AdaptiveBeam, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_ADAPTIVE_BEAM_MIN_CONFIDENCE"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseFloat(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_ADAPTIVE_BEAM_MIN_CONFIDENCE: %w", err)
+		}
+		setFloatPtr(&cfg.AdaptiveBeamMinConfidence, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_TOKEN_TIMESTAMPS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseBool(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_TOKEN_TIMESTAMPS: %w", err)
+		}
+		assignBoolPtr(&cfg.TokenTimestamps, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_DTW_TIMESTAMPS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseBool(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_DTW_TIMESTAMPS: %w", err)
+		}
+		assignBoolPtr(&cfg.DTWTimestamps, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_DRAFT_INTERVAL_MS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_DRAFT_INTERVAL_MS: %w", err)
+		}
+		assignIntPtr(&cfg.DraftIntervalMs, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_WARMUP_MS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_WARMUP_MS: %w", err)
+		}
+		setIntPtr(&cfg.WarmupMs, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_REPETITION_THRESHOLD"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_REPETITION_THRESHOLD: %w", err)
+		}
+		setIntPtr(&cfg.RepetitionThreshold, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_LANGUAGE_PIN_WINDOWS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_LANGUAGE_PIN_WINDOWS: %w", err)
+		}
+		setIntPtr(&cfg.LanguagePinWindows, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_LANGUAGE_MIN_PROBABILITY"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseFloat(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_LANGUAGE_MIN_PROBABILITY: %w", err)
+		}
+		setFloatPtr(&cfg.LanguageMinProbability, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_LANGUAGE_RECHECK_WINDOWS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_LANGUAGE_RECHECK_WINDOWS: %w", err)
+		}
+		setIntPtr(&cfg.LanguageRecheckWindows, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_BATCH_WORKERS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_BATCH_WORKERS: %w", err)
+		}
+		setIntPtr(&cfg.BatchWorkers, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_SESSION_POOL_SIZE"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_SESSION_POOL_SIZE: %w", err)
+		}
+		setIntPtr(&cfg.SessionPoolSize, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_VAD_MODE"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseBool(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_VAD_MODE: %w", err)
+		}
+		assignBoolPtr(&cfg.VADMode, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_ENDPOINT_SILENCE_MS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_ENDPOINT_SILENCE_MS: %w", err)
+		}
+		setIntPtr(&cfg.EndpointSilenceMs, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_ENDPOINT_MIN_SILENCE_MS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_ENDPOINT_MIN_SILENCE_MS: %w", err)
+		}
+		setIntPtr(&cfg.EndpointMinSilenceMs, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_ENDPOINT_ADAPT_MS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_ENDPOINT_ADAPT_MS: %w", err)
+		}
+		setIntPtr(&cfg.EndpointAdaptMs, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_ENDPOINT_SPECULATIVE"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseBool(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_ENDPOINT_SPECULATIVE: %w", err)
+		}
+		assignBoolPtr(&cfg.EndpointSpeculative, parsed)
+	}
+	if value, ok := l.Lookup("WHISPERCPP_GPU_DEVICES"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseIntList(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for WHISPERCPP_GPU_DEVICES: %w", err)
+		}
+		cfg.GPUDevices = parsed
+	}
+	if value, ok := l.Lookup("NUPI_MODEL_ROUTES"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseRoutes(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for NUPI_MODEL_ROUTES: %w", err)
+		}
+		cfg.ModelRoutes = parsed
+	}
+	if value, ok := l.Lookup("NUPI_ADMISSION_MAX_INFLIGHT"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for NUPI_ADMISSION_MAX_INFLIGHT: %w", err)
+		}
+		assignIntPtr(&cfg.AdmissionMaxInflight, parsed)
+	}
+	if value, ok := l.Lookup("NUPI_ADMISSION_QUEUE_DEPTH"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for NUPI_ADMISSION_QUEUE_DEPTH: %w", err)
+		}
+		assignIntPtr(&cfg.AdmissionQueueDepth, parsed)
+	}
+	if value, ok := l.Lookup("NUPI_ADMISSION_MAX_DELAY_MS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for NUPI_ADMISSION_MAX_DELAY_MS: %w", err)
+		}
+		assignIntPtr(&cfg.AdmissionMaxDelayMs, parsed)
+	}
+	if value, ok := l.Lookup("NUPI_PIPELINE_MAX_LAG_MS"); ok && strings.TrimSpace(value) != "" {
+		parsed, err := parseInt(value)
+		if err != nil {
+			return Config{}, fmt.Errorf("config: invalid value for NUPI_PIPELINE_MAX_LAG_MS: %w", err)
+		}
+		setIntPtr(&cfg.PipelineMaxLagMs, parsed)
+	}
 
 	if err := cfg.Validate(); err != nil {
 		return Config{}, err
@@ -78,17 +265,48 @@ func (l Loader) Load() (Config, error) {
 
 func applyJSON(raw string, cfg *Config) error {
 	type jsonConfig struct {
-		ListenAddr     string `json:"listen_addr"`
-		ModelVariant   string `json:"model_variant"`
-		Language       string `json:"language"`
-		LogLevel       string `json:"log_level"`
-		DataDir        string `json:"data_dir"`
-		ModelPath      string `json:"model_path"`
-		UseStubEngine  *bool  `json:"use_stub_engine"`
-		UseGPU         *bool  `json:"use_gpu"`
-		FlashAttention *bool  `json:"flash_attention"`
-		Threads        *int   `json:"threads"`
-		BeamSize       *int   `json:"beam_size"`
+		ListenAddr           string            `json:"listen_addr"`
+		ModelVariant         string            `json:"model_variant"`
+		Language             string            `json:"language"`
+		LogLevel             string            `json:"log_level"`
+		DataDir              string            `json:"data_dir"`
+		ModelPath            string            `json:"model_path"`
+		UseStubEngine        *bool             `json:"use_stub_engine"`
+		UseGPU               *bool             `json:"use_gpu"`
+		FlashAttention       *bool             `json:"flash_attention"`
+		Threads              *int              `json:"threads"`
+		BeamSize             *int              `json:"beam_size"`
+		MaxDecoders          *int              `json:"max_decoders"`
+		MelCache             *bool             `json:"mel_cache"`
+		AudioCtxAuto         *bool             `json:"audio_ctx_auto"`
+		AdaptiveBeam         *bool             `json:"adaptive_beam"`
+		AdaptiveBeamMinConf  *float64          `json:"adaptive_beam_min_confidence"`
+		TokenTimestamps      *bool             `json:"token_timestamps"`
+		DTWTimestamps        *bool             `json:"dtw_timestamps"`
+		DraftModelVariant    string            `json:"draft_model_variant"`
+		DraftIntervalMs      *int              `json:"draft_interval_ms"`
+		WarmupMs             *int              `json:"warmup_ms"`
+		RepetitionThreshold  *int              `json:"repetition_threshold"`
+		BatchWorkers         *int              `json:"batch_workers"`
+		SessionPoolSize      *int              `json:"session_pool_size"`
+		VADMode              *bool             `json:"vad_mode"`
+		EndpointSilenceMs    *int              `json:"endpoint_silence_ms"`
+		EndpointMinSilenceMs *int              `json:"endpoint_min_silence_ms"`
+		EndpointAdaptMs      *int              `json:"endpoint_adapt_ms"`
+		EndpointSpeculative  *bool             `json:"endpoint_speculative"`
+		LanguagePinWindows   *int              `json:"language_pin_windows"`
+		LanguageMinProb      *float64          `json:"language_min_probability"`
+		LanguageRecheck      *int              `json:"language_recheck_windows"`
+		CPUPinning           string            `json:"cpu_pinning"`
+		ModelQuantization    string            `json:"model_quantization"`
+		SpeechGate           string            `json:"speech_gate"`
+		VADModelPath         string            `json:"vad_model_path"`
+		GPUDevices           []int             `json:"gpu_devices"`
+		ModelRoutes          map[string]string `json:"model_routes"`
+		AdmissionMaxInflight *int              `json:"admission_max_inflight"`
+		AdmissionQueueDepth  *int              `json:"admission_queue_depth"`
+		AdmissionMaxDelayMs  *int              `json:"admission_max_delay_ms"`
+		PipelineMaxLagMs     *int              `json:"pipeline_max_lag_ms"`
 	}
 	var payload jsonConfig
 	if err := json.Unmarshal([]byte(raw), &payload); err != nil {
@@ -127,6 +345,99 @@ func applyJSON(raw string, cfg *Config) error {
 	if payload.BeamSize != nil {
 		assignIntPtr(&cfg.BeamSize, *payload.BeamSize)
 	}
+	if payload.MaxDecoders != nil {
+		setIntPtr(&cfg.MaxDecoders, *payload.MaxDecoders)
+	}
+	if payload.MelCache != nil {
+		assignBoolPtr(&cfg.MelCache, *payload.MelCache)
+	}
+	if payload.AudioCtxAuto != nil {
+		assignBoolPtr(&cfg.AudioCtxAuto, *payload.AudioCtxAuto)
+	}
+	if payload.AdaptiveBeam != nil {
+		assignBoolPtr(&cfg.AdaptiveBeam, *payload.AdaptiveBeam)
+	}
+	if payload.AdaptiveBeamMinConf != nil {
+		setFloatPtr(&cfg.AdaptiveBeamMinConfidence, *payload.AdaptiveBeamMinConf)
+	}
+	if payload.TokenTimestamps != nil {
+		assignBoolPtr(&cfg.TokenTimestamps, *payload.TokenTimestamps)
+	}
+	if payload.DTWTimestamps != nil {
+		assignBoolPtr(&cfg.DTWTimestamps, *payload.DTWTimestamps)
+	}
+	if payload.DraftModelVariant != "" {
+		cfg.DraftModelVariant = payload.DraftModelVariant
+	}
+	if payload.DraftIntervalMs != nil {
+		assignIntPtr(&cfg.DraftIntervalMs, *payload.DraftIntervalMs)
+	}
+	if payload.WarmupMs != nil {
+		setIntPtr(&cfg.WarmupMs, *payload.WarmupMs)
+	}
+	if payload.RepetitionThreshold != nil {
+		setIntPtr(&cfg.RepetitionThreshold, *payload.RepetitionThreshold)
+	}
+	if payload.BatchWorkers != nil {
+		setIntPtr(&cfg.BatchWorkers, *payload.BatchWorkers)
+	}
+	if payload.LanguagePinWindows != nil {
+		setIntPtr(&cfg.LanguagePinWindows, *payload.LanguagePinWindows)
+	}
+	if payload.LanguageMinProb != nil {
+		setFloatPtr(&cfg.LanguageMinProbability, *payload.LanguageMinProb)
+	}
+	if payload.LanguageRecheck != nil {
+		setIntPtr(&cfg.LanguageRecheckWindows, *payload.LanguageRecheck)
+	}
+	if payload.SessionPoolSize != nil {
+		setIntPtr(&cfg.SessionPoolSize, *payload.SessionPoolSize)
+	}
+	if payload.VADMode != nil {
+		assignBoolPtr(&cfg.VADMode, *payload.VADMode)
+	}
+	if payload.EndpointSilenceMs != nil {
+		setIntPtr(&cfg.EndpointSilenceMs, *payload.EndpointSilenceMs)
+	}
+	if payload.EndpointMinSilenceMs != nil {
+		setIntPtr(&cfg.EndpointMinSilenceMs, *payload.EndpointMinSilenceMs)
+	}
+	if payload.EndpointAdaptMs != nil {
+		setIntPtr(&cfg.EndpointAdaptMs, *payload.EndpointAdaptMs)
+	}
+	if payload.EndpointSpeculative != nil {
+		assignBoolPtr(&cfg.EndpointSpeculative, *payload.EndpointSpeculative)
+	}
+	if payload.CPUPinning != "" {
+		cfg.CPUPinning = payload.CPUPinning
+	}
+	if payload.ModelQuantization != "" {
+		cfg.ModelQuantization = payload.ModelQuantization
+	}
+	if payload.SpeechGate != "" {
+		cfg.SpeechGate = payload.SpeechGate
+	}
+	if payload.VADModelPath != "" {
+		cfg.VADModelPath = payload.VADModelPath
+	}
+	if len(payload.GPUDevices) > 0 {
+		cfg.GPUDevices = payload.GPUDevices
+	}
+	if len(payload.ModelRoutes) > 0 {
+		cfg.ModelRoutes = payload.ModelRoutes
+	}
+	if payload.AdmissionMaxInflight != nil {
+		assignIntPtr(&cfg.AdmissionMaxInflight, *payload.AdmissionMaxInflight)
+	}
+	if payload.AdmissionQueueDepth != nil {
+		assignIntPtr(&cfg.AdmissionQueueDepth, *payload.AdmissionQueueDepth)
+	}
+	if payload.AdmissionMaxDelayMs != nil {
+		assignIntPtr(&cfg.AdmissionMaxDelayMs, *payload.AdmissionMaxDelayMs)
+	}
+	if payload.PipelineMaxLagMs != nil {
+		setIntPtr(&cfg.PipelineMaxLagMs, *payload.PipelineMaxLagMs)
+	}
 	return nil
 }
 
@@ -161,6 +472,43 @@ func parseInt(value string) (int, error) {
 	return strconv.Atoi(strings.TrimSpace(value))
 }
 
+func parseFloat(value string) (float64, error) {
+	return strconv.ParseFloat(strings.TrimSpace(value), 64)
+}
+
+// parseIntList parses a comma-separated list such as "0,1".
+func parseIntList(value string) ([]int, error) {
+	var out []int
+	for _, field := range strings.Split(value, ",") {
+		if strings.TrimSpace(field) == "" {
+			continue
+		}
+		parsed, err := parseInt(field)
+		if err != nil {
+			return nil, err
+		}
+		out = append(out, parsed)
+	}
+	return out, nil
+}
+
+// parseRoutes parses comma-separated lang=variant pairs such as
+// "en=base.en,de=medium".
+func parseRoutes(value string) (map[string]string, error) {
+	routes := make(map[string]string)
+	for _, field := range strings.Split(value, ",") {
+		if strings.TrimSpace(field) == "" {
+			continue
+		}
+		lang, variant, ok := strings.Cut(field, "=")
+		if !ok {
+			return nil, fmt.Errorf("expected lang=variant, got %q", strings.TrimSpace(field))
+		}
+		routes[strings.TrimSpace(lang)] = strings.TrimSpace(variant)
+	}
+	return routes, nil
+}
+
 func assignBoolPtr(target **bool, value bool) {
 	v := value
 	*target = &v
@@ -174,3 +522,15 @@ func assignIntPtr(target **int, value int) {
 	v := value
 	*target = &v
 }
+
+// setIntPtr keeps zero and negative values so options where 0 means "off"
+// survive, and Validate can reject the rest.
+func setIntPtr(target **int, value int) {
+	v := value
+	*target = &v
+}
+
+func setFloatPtr(target **float64, value float64) {
+	v := value
+	*target = &v
+}
@@ -324,3 +324,449 @@ func TestValidateNegativeThreads(t *testing.T) {
 		t.Errorf("error should mention threads, got: %v", err)
 	}
 }
+
+func TestLoaderMelCache(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":  `{"mel_cache":false}`,
+		"WHISPERCPP_MEL_CACHE": "true",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertBoolPtr(t, true, cfg.MelCache, "mel_cache env override")
+}
+
+func TestLoaderAudioCtxAuto(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG": `{"audio_ctx_auto":true}`,
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertBoolPtr(t, true, cfg.AudioCtxAuto, "audio_ctx_auto from JSON")
+}
+
+func TestLoaderAdaptiveBeam(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":                     `{"adaptive_beam":true,"adaptive_beam_min_confidence":0.4}`,
+		"WHISPERCPP_ADAPTIVE_BEAM_MIN_CONFIDENCE": "0.7",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertBoolPtr(t, true, cfg.AdaptiveBeam, "adaptive_beam from JSON")
+	if cfg.AdaptiveBeamMinConfidence == nil || *cfg.AdaptiveBeamMinConfidence != 0.7 {
+		t.Fatalf("expected adaptive_beam_min_confidence env override 0.7, got %v", cfg.AdaptiveBeamMinConfidence)
+	}
+
+	env["WHISPERCPP_ADAPTIVE_BEAM_MIN_CONFIDENCE"] = "1.5"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected adaptive_beam_min_confidence above 1 to be rejected")
+	}
+}
+
+func TestLoaderTokenTimestamps(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":       `{"token_timestamps":true,"dtw_timestamps":true}`,
+		"WHISPERCPP_DTW_TIMESTAMPS": "false",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertBoolPtr(t, true, cfg.TokenTimestamps, "token_timestamps from JSON")
+	assertBoolPtr(t, false, cfg.DTWTimestamps, "dtw_timestamps env override")
+}
+
+func TestLoaderDraftModel(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":          `{"draft_model_variant":"base","draft_interval_ms":400}`,
+		"NUPI_DRAFT_MODEL_VARIANT":     "tiny",
+		"WHISPERCPP_DRAFT_INTERVAL_MS": "250",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	if cfg.DraftModelVariant != "tiny" {
+		t.Fatalf("draft_model_variant: got %q, want %q", cfg.DraftModelVariant, "tiny")
+	}
+	assertIntPtr(t, 250, cfg.DraftIntervalMs, "draft_interval_ms env override")
+}
+
+func TestLoaderModelStartup(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":  `{"warmup_ms":2000}`,
+		"WHISPERCPP_WARMUP_MS": "0",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertIntPtr(t, 0, cfg.WarmupMs, "warmup_ms env override")
+
+	env["WHISPERCPP_WARMUP_MS"] = "-1"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected negative warmup_ms to be rejected")
+	}
+}
+
+func TestLoaderRepetitionThreshold(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":             `{"repetition_threshold":6}`,
+		"WHISPERCPP_REPETITION_THRESHOLD": "0",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertIntPtr(t, 0, cfg.RepetitionThreshold, "repetition_threshold env override")
+
+	env["WHISPERCPP_REPETITION_THRESHOLD"] = "-1"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected negative repetition_threshold to be rejected")
+	}
+}
+
+func TestLoaderBatchWorkers(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":      `{"batch_workers":2}`,
+		"WHISPERCPP_BATCH_WORKERS": "3",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertIntPtr(t, 3, cfg.BatchWorkers, "batch_workers env override")
+
+	env["WHISPERCPP_BATCH_WORKERS"] = "-2"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected negative batch_workers to be rejected")
+	}
+}
+
+func TestLoaderCPUPinning(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":    `{"cpu_pinning":"none"}`,
+		"WHISPERCPP_CPU_PINNING": " NUMA ",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	if cfg.CPUPinning != "numa" {
+		t.Fatalf("cpu_pinning: got %q, want %q", cfg.CPUPinning, "numa")
+	}
+
+	env["WHISPERCPP_CPU_PINNING"] = "socket"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected an unknown cpu_pinning policy to be rejected")
+	}
+}
+
+func TestLoaderModelQuantization(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":           `{"model_quantization":"q8_0"}`,
+		"WHISPERCPP_MODEL_QUANTIZATION": "Q5_0",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	if cfg.ModelQuantization != "q5_0" {
+		t.Fatalf("expected env override q5_0, got %q", cfg.ModelQuantization)
+	}
+
+	env["WHISPERCPP_MODEL_QUANTIZATION"] = "q4_k"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected an unsupported model_quantization to be rejected")
+	}
+}
+
+func TestLoaderSpeechGate(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":    `{"speech_gate":"energy","vad_model_path":"/models/silero.bin"}`,
+		"WHISPERCPP_SPEECH_GATE": "Silero",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	if cfg.SpeechGate != "silero" || cfg.VADModelPath != "/models/silero.bin" {
+		t.Fatalf("unexpected speech gate config: gate=%q path=%q", cfg.SpeechGate, cfg.VADModelPath)
+	}
+
+	env["WHISPERCPP_SPEECH_GATE"] = "webrtc"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected an unknown speech_gate to be rejected")
+	}
+}
+
+func TestLoaderAdmission(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":         `{"admission_max_inflight":2,"admission_queue_depth":8,"admission_max_delay_ms":1500}`,
+		"NUPI_ADMISSION_MAX_DELAY_MS": "750",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertIntPtr(t, 2, cfg.AdmissionMaxInflight, "admission_max_inflight from JSON")
+	assertIntPtr(t, 8, cfg.AdmissionQueueDepth, "admission_queue_depth from JSON")
+	assertIntPtr(t, 750, cfg.AdmissionMaxDelayMs, "admission_max_delay_ms env override")
+}
+
+func TestLoaderLanguageCache(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":                 `{"language_pin_windows":3,"language_min_probability":0.7,"language_recheck_windows":10}`,
+		"WHISPERCPP_LANGUAGE_RECHECK_WINDOWS": "0",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	if cfg.LanguagePinWindows == nil || *cfg.LanguagePinWindows != 3 {
+		t.Fatalf("unexpected LanguagePinWindows: %v", cfg.LanguagePinWindows)
+	}
+	if cfg.LanguageMinProbability == nil || *cfg.LanguageMinProbability != 0.7 {
+		t.Fatalf("unexpected LanguageMinProbability: %v", cfg.LanguageMinProbability)
+	}
+	if cfg.LanguageRecheckWindows == nil || *cfg.LanguageRecheckWindows != 0 {
+		t.Fatalf("expected env override to keep 0 (never recheck), got %v", cfg.LanguageRecheckWindows)
+	}
+
+	env["WHISPERCPP_LANGUAGE_MIN_PROBABILITY"] = "1.5"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected language_min_probability above 1 to be rejected")
+	}
+}
+
+func TestLoaderSessionPoolSize(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":          `{"session_pool_size":8}`,
+		"WHISPERCPP_SESSION_POOL_SIZE": "0",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertIntPtr(t, 0, cfg.SessionPoolSize, "session_pool_size env override")
+
+	env["WHISPERCPP_SESSION_POOL_SIZE"] = "-2"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected negative session_pool_size to be rejected")
+	}
+}
+
+func TestLoaderEndpointing(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":             `{"vad_mode":true,"endpoint_silence_ms":800,"endpoint_min_silence_ms":300,"endpoint_adapt_ms":6000}`,
+		"WHISPERCPP_ENDPOINT_SPECULATIVE": "true",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	if cfg.VADMode == nil || !*cfg.VADMode || cfg.EndpointSpeculative == nil || !*cfg.EndpointSpeculative {
+		t.Fatalf("expected VAD mode with speculative endpoints, got %v %v", cfg.VADMode, cfg.EndpointSpeculative)
+	}
+	assertIntPtr(t, 800, cfg.EndpointSilenceMs, "endpoint_silence_ms")
+	assertIntPtr(t, 300, cfg.EndpointMinSilenceMs, "endpoint_min_silence_ms")
+	assertIntPtr(t, 6000, cfg.EndpointAdaptMs, "endpoint_adapt_ms")
+
+	env["WHISPERCPP_ENDPOINT_SILENCE_MS"] = "50"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected endpoint_silence_ms below 100 to be rejected")
+	}
+}
+
+func TestLoaderPlacement(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":    `{"gpu_devices":[0],"model_routes":{"EN":"base.en"}}`,
+		"WHISPERCPP_GPU_DEVICES": "0, 1",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	if len(cfg.GPUDevices) != 2 || cfg.GPUDevices[0] != 0 || cfg.GPUDevices[1] != 1 {
+		t.Fatalf("expected env override [0 1], got %v", cfg.GPUDevices)
+	}
+	if cfg.ModelRoutes["en"] != "base.en" || len(cfg.ModelRoutes) != 1 {
+		t.Fatalf("unexpected model routes: %v", cfg.ModelRoutes)
+	}
+
+	env["NUPI_MODEL_ROUTES"] = "pl=medium, de = small"
+	cfg, err = loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	if cfg.ModelRoutes["pl"] != "medium" || cfg.ModelRoutes["de"] != "small" || len(cfg.ModelRoutes) != 2 {
+		t.Fatalf("unexpected env model routes: %v", cfg.ModelRoutes)
+	}
+
+	env["NUPI_MODEL_ROUTES"] = "pl"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected a route without a variant to be rejected")
+	}
+	delete(env, "NUPI_MODEL_ROUTES")
+	env["WHISPERCPP_GPU_DEVICES"] = "1,1"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected a repeated gpu device to be rejected")
+	}
+}
+
+func TestLoaderPipelineMaxLag(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":      `{"pipeline_max_lag_ms":500}`,
+		"NUPI_PIPELINE_MAX_LAG_MS": "0",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertIntPtr(t, 0, cfg.PipelineMaxLagMs, "pipeline_max_lag_ms env override")
+
+	delete(env, "NUPI_PIPELINE_MAX_LAG_MS")
+	if cfg, err = loader.Load(); err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertIntPtr(t, 500, cfg.PipelineMaxLagMs, "pipeline_max_lag_ms from JSON")
+
+	env["NUPI_PIPELINE_MAX_LAG_MS"] = "-1"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected negative pipeline_max_lag_ms to be rejected")
+	}
+}
+
+func TestLoaderMaxDecoders(t *testing.T) {
+	env := map[string]string{
+		"NUPI_ADAPTER_CONFIG":     `{"beam_size":4,"max_decoders":6}`,
+		"WHISPERCPP_MAX_DECODERS": "4",
+	}
+	loader := config.Loader{
+		Lookup: func(key string) (string, bool) {
+			v, ok := env[key]
+			return v, ok
+		},
+	}
+	cfg, err := loader.Load()
+	if err != nil {
+		t.Fatalf("Load() returned error: %v", err)
+	}
+	assertIntPtr(t, 4, cfg.MaxDecoders, "max_decoders env override")
+
+	env["WHISPERCPP_MAX_DECODERS"] = "2"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected max_decoders below beam_size to be rejected")
+	}
+	env["WHISPERCPP_MAX_DECODERS"] = "-1"
+	if _, err := loader.Load(); err == nil {
+		t.Fatal("expected negative max_decoders to be rejected")
+	}
+}
@@ -0,0 +1,283 @@
+package engine
+
+import (
+	"container/heap"
+	"context"
+	"errors"
+	"strings"
+	"sync"
+	"time"
+)
+
+// Priority selects the admission queue an inference call waits in. Lower
+// values are served first.
+type Priority int
+
+const (
+	// PriorityInteractive is live audio whose partials a user is watching.
+	PriorityInteractive Priority = iota
+	// PriorityBatch is offline work that tolerates delay and may be shed.
+	PriorityBatch
+
+	numPriorities
+)
+
+// PriorityMetadataKey is the stream metadata key that selects a Priority.
+const PriorityMetadataKey = "priority"
+
+// Defaults applied by NewAdmissionQueue to non-positive arguments.
+const (
+	DefaultAdmissionQueueDepth = 16
+	DefaultAdmissionMaxDelay   = time.Second
+)
+
+var (
+	// ErrQueueFull is returned when the priority's queue has no free slot.
+	ErrQueueFull = errors.New("engine: inference queue full")
+	// ErrQueueTimeout is returned when a batch call waited longer than the
+	// maximum queue delay.
+	ErrQueueTimeout = errors.New("engine: inference queue delay exceeded")
+	// ErrStepSkipped tells the caller to merge a delayed step's audio into
+	// its next call instead of running inference for it now.
+	ErrStepSkipped = errors.New("engine: inference step skipped")
+)
+
+// ParsePriority maps stream metadata to a Priority; anything other than
+// "batch" is interactive.
+func ParsePriority(value string) Priority {
+	if strings.EqualFold(strings.TrimSpace(value), "batch") {
+		return PriorityBatch
+	}
+	return PriorityInteractive
+}
+
+func (p Priority) String() string {
+	if p == PriorityBatch {
+		return "batch"
+	}
+	return "interactive"
+}
+
+// AdmissionObserver receives queue events from an AdmissionQueue. depth is
+// the number of calls still queued across all priorities after the event.
+type AdmissionObserver interface {
+	RecordAdmission(priority, outcome string, wait time.Duration, depth int)
+}
+
+// Admission outcomes passed to AdmissionObserver.
+const (
+	AdmissionAdmitted = "admitted"
+	AdmissionSkipped  = "skipped"
+	AdmissionRejected = "rejected"
+)
+
+// AdmissionQueue bounds how many inference calls run at once. Calls beyond
+// the limit wait in bounded per-priority queues ordered by deadline, and
+// interactive calls always go before batch calls. A queued call that reaches
+// its deadline is rejected when batch, skipped when mergeable, and otherwise
+// keeps waiting, so a live stream's final result is never dropped.
+type AdmissionQueue struct {
+	maxInflight int
+	maxDepth    int
+	maxDelay    time.Duration
+
+	mu       sync.Mutex
+	inflight int
+	queues   [numPriorities]waiterQueue
+	observer AdmissionObserver
+}
+
+type admissionWaiter struct {
+	priority  Priority
+	mergeable bool
+	enqueued  time.Time
+	deadline  time.Time
+	granted   chan struct{}
+	index     int // position in its queue; -1 once granted or removed
+}
+
+// NewAdmissionQueue admits up to maxInflight concurrent calls and queues at
+// most maxDepth more per priority for up to maxDelay each.
+func NewAdmissionQueue(maxInflight, maxDepth int, maxDelay time.Duration) *AdmissionQueue {
+	if maxInflight < 1 {
+		maxInflight = 1
+	}
+	if maxDepth <= 0 {
+		maxDepth = DefaultAdmissionQueueDepth
+	}
+	if maxDelay <= 0 {
+		maxDelay = DefaultAdmissionMaxDelay
+	}
+	return &AdmissionQueue{
+		maxInflight: maxInflight,
+		maxDepth:    maxDepth,
+		maxDelay:    maxDelay,
+	}
+}
+
+// SetObserver installs the sink for queue metrics; nil disables reporting.
+func (q *AdmissionQueue) SetObserver(observer AdmissionObserver) {
+	q.mu.Lock()
+	q.observer = observer
+	q.mu.Unlock()
+}
+
+// Acquire blocks until the call may run and returns the function that frees
+// its slot. mergeable marks calls whose work can be folded into the caller's
+// next call; interactive ones return ErrStepSkipped once the queue delay
+// passes, while batch calls return ErrQueueTimeout either way. The
+// deadline of a queued call is the earlier of ctx's deadline and the maximum
+// queue delay.
+func (q *AdmissionQueue) Acquire(ctx context.Context, priority Priority, mergeable bool) (func(), error) {
+	if err := ctx.Err(); err != nil {
+		return nil, err
+	}
+	if priority < 0 || priority >= numPriorities {
+		priority = PriorityInteractive
+	}
+
+	now := time.Now()
+	q.mu.Lock()
+	if q.inflight < q.maxInflight && q.queuedLocked() == 0 {
+		q.inflight++
+		q.reportLocked(priority, AdmissionAdmitted, 0)
+		q.mu.Unlock()
+		return q.release, nil
+	}
+	if q.queues[priority].Len() >= q.maxDepth {
+		q.reportLocked(priority, AdmissionRejected, 0)
+		q.mu.Unlock()
+		return nil, ErrQueueFull
+	}
+	w := &admissionWaiter{
+		priority:  priority,
+		mergeable: mergeable,
+		enqueued:  now,
+		deadline:  now.Add(q.maxDelay),
+		granted:   make(chan struct{}),
+	}
+	if d, ok := ctx.Deadline(); ok && d.Before(w.deadline) {
+		w.deadline = d
+	}
+	heap.Push(&q.queues[priority], w)
+	q.mu.Unlock()
+
+	timer := time.NewTimer(time.Until(w.deadline))
+	defer timer.Stop()
+	expired := timer.C
+	for {
+		select {
+		case <-w.granted:
+			return q.release, nil
+		case <-ctx.Done():
+			if q.cancel(w, AdmissionRejected) {
+				return nil, ctx.Err()
+			}
+			// Granted concurrently: hand the slot straight back.
+			<-w.granted
+			q.release()
+			return nil, ctx.Err()
+		case <-expired:
+			expired = nil
+			switch {
+			case w.priority == PriorityBatch:
+				if q.cancel(w, AdmissionRejected) {
+					return nil, ErrQueueTimeout
+				}
+			case w.mergeable:
+				if q.cancel(w, AdmissionSkipped) {
+					return nil, ErrStepSkipped
+				}
+			}
+			// Interactive calls that cannot be merged keep their place.
+		}
+	}
+}
+
+// Depth reports how many calls are queued at priority.
+func (q *AdmissionQueue) Depth(priority Priority) int {
+	q.mu.Lock()
+	defer q.mu.Unlock()
+	if priority < 0 || priority >= numPriorities {
+		return 0
+	}
+	return q.queues[priority].Len()
+}
+
+// release frees a slot and grants it to the most urgent queued call.
+func (q *AdmissionQueue) release() {
+	q.mu.Lock()
+	defer q.mu.Unlock()
+	q.inflight--
+	for p := range q.queues {
+		if q.queues[p].Len() == 0 {
+			continue
+		}
+		w := heap.Pop(&q.queues[p]).(*admissionWaiter)
+		q.inflight++
+		q.reportLocked(w.priority, AdmissionAdmitted, time.Since(w.enqueued))
+		close(w.granted)
+		return
+	}
+}
+
+// cancel removes w from its queue and reports outcome. It returns false
+// when w was granted a slot first.
+func (q *AdmissionQueue) cancel(w *admissionWaiter, outcome string) bool {
+	q.mu.Lock()
+	defer q.mu.Unlock()
+	if w.index < 0 {
+		return false
+	}
+	heap.Remove(&q.queues[w.priority], w.index)
+	q.reportLocked(w.priority, outcome, time.Since(w.enqueued))
+	return true
+}
+
+func (q *AdmissionQueue) queuedLocked() int {
+	n := 0
+	for p := range q.queues {
+		n += q.queues[p].Len()
+	}
+	return n
+}
+
+func (q *AdmissionQueue) reportLocked(priority Priority, outcome string, wait time.Duration) {
+	if q.observer != nil {
+		q.observer.RecordAdmission(priority.String(), outcome, wait, q.queuedLocked())
+	}
+}
+
+// waiterQueue is a heap of waiters ordered by deadline, then arrival.
+type waiterQueue []*admissionWaiter
+
+func (wq waiterQueue) Len() int { return len(wq) }
+
+func (wq waiterQueue) Less(i, j int) bool {
+	if !wq[i].deadline.Equal(wq[j].deadline) {
+		return wq[i].deadline.Before(wq[j].deadline)
+	}
+	return wq[i].enqueued.Before(wq[j].enqueued)
+}
+
+func (wq waiterQueue) Swap(i, j int) {
+	wq[i], wq[j] = wq[j], wq[i]
+	wq[i].index = i
+	wq[j].index = j
+}
+
+func (wq *waiterQueue) Push(x any) {
+	w := x.(*admissionWaiter)
+	w.index = len(*wq)
+	*wq = append(*wq, w)
+}
+
+func (wq *waiterQueue) Pop() any {
+	old := *wq
+	n := len(old)
+	w := old[n-1]
+	old[n-1] = nil
+	w.index = -1
+	*wq = old[:n-1]
+	return w
+}
@@ -0,0 +1,193 @@
+package engine
+
+import (
+	"context"
+	"errors"
+	"sync"
+	"testing"
+	"time"
+)
+
+type admissionRecorder struct {
+	mu       sync.Mutex
+	outcomes []string
+}
+
+func (r *admissionRecorder) RecordAdmission(priority, outcome string, wait time.Duration, depth int) {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	r.outcomes = append(r.outcomes, priority+":"+outcome)
+}
+
+func (r *admissionRecorder) snapshot() []string {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	return append([]string(nil), r.outcomes...)
+}
+
+// waitQueued polls until priority has n queued calls.
+func waitQueued(t *testing.T, q *AdmissionQueue, priority Priority, n int) {
+	t.Helper()
+	deadline := time.Now().Add(time.Second)
+	for q.Depth(priority) != n {
+		if time.Now().After(deadline) {
+			t.Fatalf("expected %d queued %s calls, got %d", n, priority, q.Depth(priority))
+		}
+		time.Sleep(time.Millisecond)
+	}
+}
+
+func TestAdmissionQueueServesInteractiveBeforeBatch(t *testing.T) {
+	q := NewAdmissionQueue(1, 4, time.Minute)
+	release, err := q.Acquire(context.Background(), PriorityInteractive, false)
+	if err != nil {
+		t.Fatalf("Acquire returned error: %v", err)
+	}
+
+	var (
+		mu    sync.Mutex
+		order []Priority
+		wg    sync.WaitGroup
+	)
+	acquire := func(p Priority) {
+		defer wg.Done()
+		done, err := q.Acquire(context.Background(), p, false)
+		if err != nil {
+			t.Errorf("Acquire(%s) returned error: %v", p, err)
+			return
+		}
+		mu.Lock()
+		order = append(order, p)
+		mu.Unlock()
+		done()
+	}
+	wg.Add(2)
+	go acquire(PriorityBatch)
+	waitQueued(t, q, PriorityBatch, 1)
+	go acquire(PriorityInteractive)
+	waitQueued(t, q, PriorityInteractive, 1)
+
+	release()
+	wg.Wait()
+	if len(order) != 2 || order[0] != PriorityInteractive || order[1] != PriorityBatch {
+		t.Fatalf("expected interactive before batch, got %v", order)
+	}
+}
+
+func TestAdmissionQueueRejectsWhenFull(t *testing.T) {
+	q := NewAdmissionQueue(1, 1, time.Minute)
+	observer := &admissionRecorder{}
+	q.SetObserver(observer)
+	release, err := q.Acquire(context.Background(), PriorityInteractive, false)
+	if err != nil {
+		t.Fatalf("Acquire returned error: %v", err)
+	}
+	defer release()
+
+	ctx, cancel := context.WithCancel(context.Background())
+	errc := make(chan error, 1)
+	go func() {
+		_, err := q.Acquire(ctx, PriorityBatch, false)
+		errc <- err
+	}()
+	waitQueued(t, q, PriorityBatch, 1)
+
+	if _, err := q.Acquire(context.Background(), PriorityBatch, false); !errors.Is(err, ErrQueueFull) {
+		t.Fatalf("expected ErrQueueFull, got %v", err)
+	}
+	cancel()
+	if err := <-errc; !errors.Is(err, context.Canceled) {
+		t.Fatalf("expected context.Canceled, got %v", err)
+	}
+	if q.Depth(PriorityBatch) != 0 {
+		t.Fatalf("cancelled call should leave the queue")
+	}
+	want := []string{"interactive:admitted", "batch:rejected", "batch:rejected"}
+	if got := observer.snapshot(); len(got) != len(want) || got[0] != want[0] || got[1] != want[1] || got[2] != want[2] {
+		t.Fatalf("unexpected outcomes: %v", got)
+	}
+}
+
+func TestAdmissionQueueDelayExpiry(t *testing.T) {
+	q := NewAdmissionQueue(1, 4, 10*time.Millisecond)
+	release, err := q.Acquire(context.Background(), PriorityInteractive, false)
+	if err != nil {
+		t.Fatalf("Acquire returned error: %v", err)
+	}
+
+	if _, err := q.Acquire(context.Background(), PriorityInteractive, true); !errors.Is(err, ErrStepSkipped) {
+		t.Fatalf("expected mergeable step to be skipped, got %v", err)
+	}
+	if _, err := q.Acquire(context.Background(), PriorityBatch, true); !errors.Is(err, ErrQueueTimeout) {
+		t.Fatalf("expected batch call to time out, got %v", err)
+	}
+
+	// A final interactive call outlives the delay and runs once a slot frees.
+	errc := make(chan error, 1)
+	go func() {
+		done, err := q.Acquire(context.Background(), PriorityInteractive, false)
+		if err == nil {
+			done()
+		}
+		errc <- err
+	}()
+	waitQueued(t, q, PriorityInteractive, 1)
+	time.Sleep(30 * time.Millisecond)
+	select {
+	case err := <-errc:
+		t.Fatalf("final interactive call returned before a slot freed: %v", err)
+	default:
+	}
+	release()
+	if err := <-errc; err != nil {
+		t.Fatalf("final interactive call failed: %v", err)
+	}
+}
+
+func TestAdmissionQueueOrdersByDeadline(t *testing.T) {
+	q := NewAdmissionQueue(1, 4, time.Minute)
+	release, err := q.Acquire(context.Background(), PriorityInteractive, false)
+	if err != nil {
+		t.Fatalf("Acquire returned error: %v", err)
+	}
+
+	var (
+		mu    sync.Mutex
+		order []string
+		wg    sync.WaitGroup
+	)
+	acquire := func(name string, ctx context.Context) {
+		defer wg.Done()
+		done, err := q.Acquire(ctx, PriorityInteractive, false)
+		if err != nil {
+			t.Errorf("Acquire(%s) returned error: %v", name, err)
+			return
+		}
+		mu.Lock()
+		order = append(order, name)
+		mu.Unlock()
+		done()
+	}
+	urgent, cancel := context.WithTimeout(context.Background(), 10*time.Second)
+	defer cancel()
+	wg.Add(2)
+	go acquire("relaxed", context.Background())
+	waitQueued(t, q, PriorityInteractive, 1)
+	go acquire("urgent", urgent)
+	waitQueued(t, q, PriorityInteractive, 2)
+
+	release()
+	wg.Wait()
+	if len(order) != 2 || order[0] != "urgent" {
+		t.Fatalf("expected the earlier deadline first, got %v", order)
+	}
+}
+
+func TestParsePriority(t *testing.T) {
+	if ParsePriority(" Batch ") != PriorityBatch {
+		t.Fatalf("expected batch priority")
+	}
+	if ParsePriority("") != PriorityInteractive || ParsePriority("interactive") != PriorityInteractive {
+		t.Fatalf("expected interactive by default")
+	}
+}
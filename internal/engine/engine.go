@@ -1,6 +1,9 @@
 package engine
 
-import "context"
+import (
+	"context"
+	"time"
+)
 
 // Engine exposes a streaming transcription interface backed by whisper.cpp or a stub implementation.
 type Engine interface {
@@ -12,6 +15,44 @@ type Engine interface {
 	Close() error
 }
 
+// SessionFactory is implemented by engines that can isolate decoding state per
+// stream. Sessions share the engine's model but run independently; callers must
+// Close each session when its stream ends.
+type SessionFactory interface {
+	NewSession() (Engine, error)
+}
+
+// LanguageSessionFactory is implemented by engines that pick the model
+// serving a stream by its language, such as EngineGroup. lang is the
+// resolved ISO 639-1 code, or "auto" when it is unknown.
+type LanguageSessionFactory interface {
+	NewSessionForLanguage(lang string) (Engine, error)
+}
+
+// SessionPool is implemented by engines that recycle sessions. Acquire
+// returns a fresh or reset session; Release takes it back when its stream
+// ends, in place of Close, and may keep it for a later Acquire.
+type SessionPool interface {
+	Acquire() (Engine, error)
+	Release(session Engine)
+}
+
+// BatchTranscriber is implemented by engines that can transcribe a complete
+// recording in one call. The audio is split into long chunks at silences and
+// decoded in parallel, trading partial results for throughput; the single
+// Final result carries timed segments for the whole recording.
+type BatchTranscriber interface {
+	TranscribeBatch(ctx context.Context, audio []byte, opts Options) ([]Result, error)
+}
+
+// ModeMetadataKey is the stream metadata key that selects the stream mode.
+// ModeBatch buffers the stream's audio and transcribes it with
+// BatchTranscriber on flush instead of emitting partials.
+const (
+	ModeMetadataKey = "mode"
+	ModeBatch       = "batch"
+)
+
 // Options configures decoding for a segment or flush call.
 type Options struct {
 	Language string
@@ -26,4 +67,35 @@ type Result struct {
 	Text       string
 	Confidence float32
 	Final      bool
+	// Draft marks a fast, unstable partial from the draft model; the next
+	// non-draft result replaces it.
+	Draft bool
+	// Segments breaks Text down into timed whisper segments, when the engine
+	// provides them. Times are measured from the start of the stream.
+	Segments []Segment
+}
+
+// NoTimestamp marks a Token time the engine did not compute.
+const NoTimestamp time.Duration = -1
+
+// Segment is one whisper segment of a Result.
+type Segment struct {
+	Text       string
+	Start      time.Duration
+	End        time.Duration
+	Confidence float32
+	// Tokens holds the segment's text tokens in decode order.
+	Tokens []Token
+}
+
+// Token is a decoded text token with its timing. Start and End need token
+// timestamps enabled and DTW needs DTW alignment; each is NoTimestamp when not
+// computed.
+type Token struct {
+	Text        string
+	ID          int32
+	Probability float32
+	Start       time.Duration
+	End         time.Duration
+	DTW         time.Duration
 }
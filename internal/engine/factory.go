@@ -3,6 +3,10 @@ package engine
 import (
 	"context"
 	"errors"
+	"fmt"
+	"os"
+	"path/filepath"
+	"sort"
 	"strings"
 
 	"log/slog"
@@ -11,6 +15,10 @@ import (
 	"github.com/nupi-ai/plugin-stt-local-whisper/internal/models"
 )
 
+// defaultVADModelFile is whisper.cpp's Silero VAD model, looked up under the
+// data directory's models folder when no path is configured.
+const defaultVADModelFile = "ggml-silero-v5.1.2.bin"
+
 // ErrNativeEngineUnavailable indicates that a real native backend is not yet wired in.
 var ErrNativeEngineUnavailable = errors.New("engine: native backend unavailable")
 
@@ -97,7 +105,85 @@ func newEngineWithOptions(cfg config.Config, manager *models.Manager, logger *sl
 		if cfg.BeamSize != nil && *cfg.BeamSize > 0 {
 			nativeOptions.BeamSize = cfg.BeamSize
 		}
-		native, nativeErr := NewNativeEngine(modelPath, nativeOptions)
+		if cfg.MaxDecoders != nil && *cfg.MaxDecoders > 0 {
+			nativeOptions.MaxDecoders = cfg.MaxDecoders
+		}
+		if cfg.MelCache != nil {
+			nativeOptions.MelCache = cfg.MelCache
+		}
+		if cfg.AudioCtxAuto != nil {
+			nativeOptions.AudioCtxAuto = cfg.AudioCtxAuto
+		}
+		if cfg.AdaptiveBeam != nil {
+			nativeOptions.AdaptiveBeam = cfg.AdaptiveBeam
+		}
+		if cfg.AdaptiveBeamMinConfidence != nil {
+			minConf := float32(*cfg.AdaptiveBeamMinConfidence)
+			nativeOptions.AdaptiveBeamMinConfidence = &minConf
+		}
+		if cfg.TokenTimestamps != nil {
+			nativeOptions.TokenTimestamps = cfg.TokenTimestamps
+		}
+		if cfg.DTWTimestamps != nil {
+			nativeOptions.DTWTimestamps = cfg.DTWTimestamps
+		}
+		if draft := strings.TrimSpace(cfg.DraftModelVariant); draft != "" {
+			draftPath, draftErr := manager.EnsureVariant(context.Background(), draft, models.EnsureOptions{Manifest: opts.ensure.Manifest})
+			if draftErr != nil {
+				logger.Warn("draft model ensure failed; continuing without draft partials", "error", draftErr, "variant", draft)
+			} else {
+				nativeOptions.DraftModelPath = draftPath
+			}
+		}
+		if cfg.DraftIntervalMs != nil && *cfg.DraftIntervalMs > 0 {
+			nativeOptions.DraftIntervalMs = cfg.DraftIntervalMs
+		}
+		if cfg.WarmupMs != nil {
+			nativeOptions.WarmupMs = cfg.WarmupMs
+		}
+		if cfg.RepetitionThreshold != nil {
+			nativeOptions.RepetitionThreshold = cfg.RepetitionThreshold
+		}
+		if cfg.LanguagePinWindows != nil {
+			nativeOptions.LanguagePinWindows = cfg.LanguagePinWindows
+		}
+		if cfg.LanguageRecheckWindows != nil {
+			nativeOptions.LanguageRecheckWindows = cfg.LanguageRecheckWindows
+		}
+		if cfg.LanguageMinProbability != nil {
+			minProb := float32(*cfg.LanguageMinProbability)
+			nativeOptions.LanguageMinProbability = &minProb
+		}
+		if cfg.BatchWorkers != nil && *cfg.BatchWorkers > 0 {
+			nativeOptions.BatchWorkers = cfg.BatchWorkers
+		}
+		if cfg.SessionPoolSize != nil {
+			nativeOptions.SessionPoolSize = cfg.SessionPoolSize
+		}
+		nativeOptions.UseVAD = cfg.VADMode
+		nativeOptions.EndpointSilenceMs = cfg.EndpointSilenceMs
+		nativeOptions.EndpointMinSilenceMs = cfg.EndpointMinSilenceMs
+		nativeOptions.EndpointAdaptMs = cfg.EndpointAdaptMs
+		nativeOptions.SpeculativeEndpoint = cfg.EndpointSpeculative
+		nativeOptions.CPUPinning = cfg.CPUPinning
+		nativeOptions.Quantization = cfg.ModelQuantization
+		if cfg.ModelQuantization != "" && cfg.ModelQuantization != QuantizationNone {
+			nativeOptions.QuantizedModelDir = filepath.Join(cfg.DataDir, "models", "quantized")
+		}
+		nativeOptions.SpeechGate = cfg.SpeechGate
+		if cfg.SpeechGate == SpeechGateSilero {
+			vadPath := strings.TrimSpace(cfg.VADModelPath)
+			if vadPath == "" {
+				vadPath = filepath.Join(cfg.DataDir, "models", defaultVADModelFile)
+			}
+			if _, statErr := os.Stat(vadPath); statErr != nil {
+				logger.Warn("silero VAD model unavailable; gating on energy instead", "error", statErr, "vad_model_path", vadPath)
+				nativeOptions.SpeechGate = SpeechGateEnergy
+			} else {
+				nativeOptions.VADModelPath = vadPath
+			}
+		}
+		native, nativeErr := newPlacedEngine(cfg, manager, opts, modelPath, nativeOptions, logger)
 		if nativeErr != nil {
 			logger.Error("native engine initialisation failed; using stub", "error", nativeErr, "model_path", modelPath)
 			return NewStubEngine(logger, cfg.ModelVariant), modelPath, nativeErr
@@ -130,3 +216,99 @@ func newEngineWithOptions(cfg config.Config, manager *models.Manager, logger *sl
 	}
 	return engine, modelPath, ErrNativeEngineUnavailable
 }
+
+// newPlacedEngine loads the native model once per configured GPU device and
+// once more per device for every routed model variant, grouping the replicas
+// so streams are spread by load and language. Without extra devices or
+// routes it returns a single NativeEngine.
+func newPlacedEngine(cfg config.Config, manager *models.Manager, opts engineOptions, modelPath string, base NativeOptions, logger *slog.Logger) (Engine, error) {
+	devices := cfg.GPUDevices
+	if len(devices) > 0 && cfg.UseGPU != nil && !*cfg.UseGPU {
+		logger.Warn("gpu_devices ignored while use_gpu is disabled", "gpu_devices", devices)
+		devices = nil
+	}
+	if len(devices) <= 1 && len(cfg.ModelRoutes) == 0 {
+		if len(devices) == 1 {
+			base.GPUDevice = &devices[0]
+		}
+		return NewNativeEngine(modelPath, base)
+	}
+
+	type variantPlacement struct {
+		variant   string
+		path      string
+		languages []string
+	}
+	placements := []variantPlacement{{variant: cfg.ModelVariant, path: modelPath}}
+	routed := make(map[string][]string)
+	for lang, variant := range cfg.ModelRoutes {
+		if variant == cfg.ModelVariant {
+			continue
+		}
+		routed[variant] = append(routed[variant], lang)
+	}
+	variants := make([]string, 0, len(routed))
+	for variant := range routed {
+		variants = append(variants, variant)
+	}
+	sort.Strings(variants)
+	for _, variant := range variants {
+		path, err := manager.EnsureVariant(context.Background(), variant, models.EnsureOptions{Manifest: opts.ensure.Manifest})
+		if err != nil {
+			logger.Warn("routed model ensure failed; its languages use the default model", "error", err, "variant", variant)
+			continue
+		}
+		languages := routed[variant]
+		sort.Strings(languages)
+		placements = append(placements, variantPlacement{variant: variant, path: path, languages: languages})
+	}
+
+	var replicas []Replica
+	closeAll := func() {
+		for _, replica := range replicas {
+			_ = replica.Engine.Close()
+		}
+	}
+	load := func(placement variantPlacement, device *int) error {
+		replicaOpts := base
+		replicaOpts.GPUDevice = device
+		name := placement.variant
+		if device != nil {
+			name = fmt.Sprintf("%s@gpu%d", placement.variant, *device)
+		}
+		if len(replicas) > 0 {
+			if first, ok := replicas[0].Engine.(*NativeEngine); ok {
+				replicaOpts.ThreadBudget = first.ThreadBudget()
+			}
+		}
+		replica, err := NewNativeEngine(placement.path, replicaOpts)
+		if err != nil {
+			return fmt.Errorf("engine: replica %s: %w", name, err)
+		}
+		replicas = append(replicas, Replica{Name: name, Engine: replica, Languages: placement.languages})
+		logger.Info("model replica loaded", "replica", name, "model_path", placement.path, "languages", placement.languages)
+		return nil
+	}
+	for _, placement := range placements {
+		if len(devices) == 0 {
+			if err := load(placement, nil); err != nil {
+				closeAll()
+				return nil, err
+			}
+			continue
+		}
+		for i := range devices {
+			if err := load(placement, &devices[i]); err != nil {
+				closeAll()
+				return nil, err
+			}
+		}
+	}
+
+	group, err := NewEngineGroup(replicas)
+	if err != nil {
+		closeAll()
+		return nil, err
+	}
+	return group, nil
+}
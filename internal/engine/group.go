@@ -0,0 +1,277 @@
+package engine
+
+import (
+	"context"
+	"errors"
+	"fmt"
+	"strings"
+	"sync"
+	"time"
+
+	"github.com/nupi-ai/plugin-stt-local-whisper/internal/telemetry"
+)
+
+// Replica is one engine of an EngineGroup, typically a model loaded on one
+// GPU. A replica with Languages only serves streams in those languages (an
+// English-only model, say); one without serves any stream.
+type Replica struct {
+	Name      string
+	Engine    Engine
+	Languages []string
+}
+
+// ReplicaObserver receives per-replica load and inference counters from an
+// EngineGroup; telemetry.Recorder implements it.
+type ReplicaObserver interface {
+	RecordReplicaStartup(replica string, load, warmup time.Duration, memory telemetry.ModelMemory)
+	RecordReplicaSession(replica string, opened bool)
+	RecordReplicaStages(replica string, stages telemetry.InferenceStages)
+}
+
+// EngineGroup spreads streams over several engines. Each new session goes to
+// the least loaded replica that serves the stream's language, falling back
+// to the unrestricted replicas, then to any replica.
+type EngineGroup struct {
+	mu       sync.Mutex
+	replicas []*groupReplica
+	observer ReplicaObserver
+}
+
+type groupReplica struct {
+	Replica
+	languages map[string]bool
+	active    int
+	opened    uint64
+}
+
+// NewEngineGroup builds a group from replicas. The first replica also serves
+// callers that drive the group as a single Engine.
+func NewEngineGroup(replicas []Replica) (*EngineGroup, error) {
+	if len(replicas) == 0 {
+		return nil, errors.New("engine: group needs at least one replica")
+	}
+	g := &EngineGroup{}
+	seen := make(map[string]bool, len(replicas))
+	for _, replica := range replicas {
+		if replica.Engine == nil {
+			return nil, fmt.Errorf("engine: replica %q has no engine", replica.Name)
+		}
+		if seen[replica.Name] {
+			return nil, fmt.Errorf("engine: duplicate replica name %q", replica.Name)
+		}
+		seen[replica.Name] = true
+		r := &groupReplica{Replica: replica}
+		if len(replica.Languages) > 0 {
+			r.languages = make(map[string]bool, len(replica.Languages))
+			for _, lang := range replica.Languages {
+				r.languages[strings.ToLower(strings.TrimSpace(lang))] = true
+			}
+		}
+		g.replicas = append(g.replicas, r)
+	}
+	return g, nil
+}
+
+// NewSession opens a session for a stream of unknown language.
+func (g *EngineGroup) NewSession() (Engine, error) {
+	return g.NewSessionForLanguage("")
+}
+
+// NewSessionForLanguage opens a session on the replica chosen for lang. The
+// caller must Close the session when its stream ends.
+func (g *EngineGroup) NewSessionForLanguage(lang string) (Engine, error) {
+	g.mu.Lock()
+	replica := g.pickLocked(strings.ToLower(strings.TrimSpace(lang)))
+	replica.active++
+	replica.opened++
+	observer := g.observer
+	g.mu.Unlock()
+
+	var (
+		session Engine
+		closer  func() error
+		err     error
+	)
+	if pool, ok := replica.Engine.(SessionPool); ok {
+		session, err = pool.Acquire()
+		closer = func() error {
+			pool.Release(session)
+			return nil
+		}
+	} else if factory, ok := replica.Engine.(SessionFactory); ok {
+		session, err = factory.NewSession()
+		closer = func() error { return session.Close() }
+	} else {
+		// Engines without sessions are shared; closing the stream must not
+		// close them.
+		session = replica.Engine
+		closer = func() error { return nil }
+	}
+	if err != nil {
+		g.mu.Lock()
+		replica.active--
+		g.mu.Unlock()
+		return nil, fmt.Errorf("engine: replica %s: %w", replica.Name, err)
+	}
+	batch, _ := session.(BatchTranscriber)
+	if observer != nil {
+		observer.RecordReplicaSession(replica.Name, true)
+	}
+
+	wrapped := &groupSession{Engine: session, close: closer, release: func() {
+		g.mu.Lock()
+		replica.active--
+		observer := g.observer
+		g.mu.Unlock()
+		if observer != nil {
+			observer.RecordReplicaSession(replica.Name, false)
+		}
+	}}
+	if batch != nil {
+		return groupBatchSession{groupSession: wrapped, batch: batch}, nil
+	}
+	return wrapped, nil
+}
+
+// pickLocked returns the replica with the fewest open sessions among those
+// that serve lang. Ties go to the replica that has opened fewer sessions so
+// far, then to the earlier one.
+func (g *EngineGroup) pickLocked(lang string) *groupReplica {
+	candidates := func(match func(*groupReplica) bool) *groupReplica {
+		var best *groupReplica
+		for _, r := range g.replicas {
+			if !match(r) {
+				continue
+			}
+			if best == nil || r.active < best.active || (r.active == best.active && r.opened < best.opened) {
+				best = r
+			}
+		}
+		return best
+	}
+	if lang != "" {
+		if best := candidates(func(r *groupReplica) bool { return r.languages[lang] }); best != nil {
+			return best
+		}
+	}
+	if best := candidates(func(r *groupReplica) bool { return r.languages == nil }); best != nil {
+		return best
+	}
+	return candidates(func(*groupReplica) bool { return true })
+}
+
+func (g *EngineGroup) primary() Engine {
+	return g.replicas[0].Engine
+}
+
+func (g *EngineGroup) TranscribeSegment(ctx context.Context, audio []byte, opts Options) ([]Result, error) {
+	return g.primary().TranscribeSegment(ctx, audio, opts)
+}
+
+func (g *EngineGroup) Flush(ctx context.Context, opts Options) ([]Result, error) {
+	return g.primary().Flush(ctx, opts)
+}
+
+// TranscribeBatch implements BatchTranscriber on the first replica.
+func (g *EngineGroup) TranscribeBatch(ctx context.Context, audio []byte, opts Options) ([]Result, error) {
+	batch, ok := g.primary().(BatchTranscriber)
+	if !ok {
+		return nil, fmt.Errorf("engine: replica %s does not support batch transcription", g.replicas[0].Name)
+	}
+	return batch.TranscribeBatch(ctx, audio, opts)
+}
+
+// Close releases every replica. Sessions still open keep their replica's
+// model alive until they are closed.
+func (g *EngineGroup) Close() error {
+	var errs []error
+	for _, r := range g.replicas {
+		if err := r.Engine.Close(); err != nil {
+			errs = append(errs, fmt.Errorf("engine: replica %s: %w", r.Name, err))
+		}
+	}
+	return errors.Join(errs...)
+}
+
+// SetDefaultLanguage forwards the hint to the replicas that serve any
+// language; language-restricted replicas keep their own.
+func (g *EngineGroup) SetDefaultLanguage(lang string) {
+	for _, r := range g.replicas {
+		if r.languages != nil {
+			continue
+		}
+		if setter, ok := r.Engine.(languageHintSetter); ok {
+			setter.SetDefaultLanguage(lang)
+		}
+	}
+}
+
+// SetObserver attaches observer to every replica. The group-wide startup
+// figures come from the first replica; when observer also implements
+// ReplicaObserver each replica's startup, sessions and stages are reported
+// under its name as well.
+func (g *EngineGroup) SetObserver(observer Observer) {
+	replicaObs, _ := observer.(ReplicaObserver)
+	g.mu.Lock()
+	g.observer = replicaObs
+	g.mu.Unlock()
+	for i, r := range g.replicas {
+		var attached Observer
+		if observer != nil {
+			attached = groupObserver{Observer: observer, replica: replicaObs, name: r.Name, primary: i == 0}
+		}
+		AttachObserver(r.Engine, attached)
+	}
+}
+
+// groupObserver tags one replica's reports with its name.
+type groupObserver struct {
+	Observer
+	replica ReplicaObserver
+	name    string
+	primary bool
+}
+
+func (o groupObserver) RecordStartup(load, warmup time.Duration, memory telemetry.ModelMemory) {
+	if o.primary {
+		o.Observer.RecordStartup(load, warmup, memory)
+	}
+	if o.replica != nil {
+		o.replica.RecordReplicaStartup(o.name, load, warmup, memory)
+	}
+}
+
+func (o groupObserver) RecordStages(stages telemetry.InferenceStages) {
+	o.Observer.RecordStages(stages)
+	if o.replica != nil {
+		o.replica.RecordReplicaStages(o.name, stages)
+	}
+}
+
+// groupSession closes or returns its session and releases its replica's
+// slot once the stream closes; later Close calls do nothing.
+type groupSession struct {
+	Engine
+	once    sync.Once
+	close   func() error
+	release func()
+}
+
+func (s *groupSession) Close() error {
+	var err error
+	s.once.Do(func() {
+		err = s.close()
+		s.release()
+	})
+	return err
+}
+
+// groupBatchSession is a groupSession whose engine supports batch mode.
+type groupBatchSession struct {
+	*groupSession
+	batch BatchTranscriber
+}
+
+func (s groupBatchSession) TranscribeBatch(ctx context.Context, audio []byte, opts Options) ([]Result, error) {
+	return s.batch.TranscribeBatch(ctx, audio, opts)
+}
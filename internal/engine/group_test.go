@@ -0,0 +1,162 @@
+package engine
+
+import (
+	"sync"
+	"testing"
+	"time"
+
+	"github.com/nupi-ai/plugin-stt-local-whisper/internal/telemetry"
+)
+
+// sessionStub is a StubEngine that opens stub sessions and counts closes.
+type sessionStub struct {
+	*StubEngine
+	closed int
+}
+
+func (e *sessionStub) NewSession() (Engine, error) {
+	return &closeCounter{StubEngine: NewStubEngine(nil, e.modelVariant), parent: e}, nil
+}
+
+type closeCounter struct {
+	*StubEngine
+	parent *sessionStub
+}
+
+func (s *closeCounter) Close() error {
+	s.parent.closed++
+	return nil
+}
+
+// poolStub is a StubEngine that hands out pooled stub sessions.
+type poolStub struct {
+	*StubEngine
+	idle     []Engine
+	acquired int
+}
+
+func (e *poolStub) Acquire() (Engine, error) {
+	e.acquired++
+	if n := len(e.idle); n > 0 {
+		session := e.idle[n-1]
+		e.idle = e.idle[:n-1]
+		return session, nil
+	}
+	return NewStubEngine(nil, e.modelVariant), nil
+}
+
+func (e *poolStub) Release(session Engine) {
+	e.idle = append(e.idle, session)
+}
+
+type replicaEvents struct {
+	mu     sync.Mutex
+	active map[string]int
+}
+
+func (r *replicaEvents) RecordReplicaStartup(string, time.Duration, time.Duration, telemetry.ModelMemory) {
+}
+
+func (r *replicaEvents) RecordReplicaSession(replica string, opened bool) {
+	r.mu.Lock()
+	defer r.mu.Unlock()
+	if opened {
+		r.active[replica]++
+	} else {
+		r.active[replica]--
+	}
+}
+
+func (r *replicaEvents) RecordReplicaStages(string, telemetry.InferenceStages) {}
+
+func TestEngineGroupRoutesByLanguageAndLoad(t *testing.T) {
+	gpu0 := &sessionStub{StubEngine: NewStubEngine(nil, "base")}
+	gpu1 := &sessionStub{StubEngine: NewStubEngine(nil, "base")}
+	english := &sessionStub{StubEngine: NewStubEngine(nil, "base.en")}
+	group, err := NewEngineGroup([]Replica{
+		{Name: "base@gpu0", Engine: gpu0},
+		{Name: "base@gpu1", Engine: gpu1},
+		{Name: "base.en@gpu0", Engine: english, Languages: []string{"en"}},
+	})
+	if err != nil {
+		t.Fatalf("NewEngineGroup returned error: %v", err)
+	}
+	events := &replicaEvents{active: make(map[string]int)}
+	group.observer = events
+
+	first, err := group.NewSessionForLanguage("pl")
+	if err != nil {
+		t.Fatalf("NewSessionForLanguage returned error: %v", err)
+	}
+	second, err := group.NewSessionForLanguage("auto")
+	if err != nil {
+		t.Fatalf("NewSessionForLanguage returned error: %v", err)
+	}
+	if _, err := group.NewSessionForLanguage("EN"); err != nil {
+		t.Fatalf("NewSessionForLanguage returned error: %v", err)
+	}
+	if events.active["base@gpu0"] != 1 || events.active["base@gpu1"] != 1 || events.active["base.en@gpu0"] != 1 {
+		t.Fatalf("expected one session per replica, got %v", events.active)
+	}
+
+	if err := first.Close(); err != nil {
+		t.Fatalf("Close returned error: %v", err)
+	}
+	_ = first.Close()
+	if gpu0.closed != 1 || events.active["base@gpu0"] != 0 {
+		t.Fatalf("expected the slot released once, got closes=%d active=%v", gpu0.closed, events.active)
+	}
+	if _, err := group.NewSession(); err != nil {
+		t.Fatalf("NewSession returned error: %v", err)
+	}
+	if events.active["base@gpu0"] != 1 {
+		t.Fatalf("expected the new session on the idle replica, got %v", events.active)
+	}
+	_ = second.Close()
+}
+
+func TestEngineGroupFallsBackWithoutUnrestrictedReplica(t *testing.T) {
+	group, err := NewEngineGroup([]Replica{{Name: "en", Engine: NewStubEngine(nil, "base.en"), Languages: []string{"en"}}})
+	if err != nil {
+		t.Fatalf("NewEngineGroup returned error: %v", err)
+	}
+	session, err := group.NewSessionForLanguage("de")
+	if err != nil {
+		t.Fatalf("NewSessionForLanguage returned error: %v", err)
+	}
+	if err := session.Close(); err != nil {
+		t.Fatalf("Close returned error: %v", err)
+	}
+
+	if _, err := NewEngineGroup([]Replica{{Name: "a", Engine: group}, {Name: "a", Engine: group}}); err == nil {
+		t.Fatal("expected duplicate replica names to be rejected")
+	}
+}
+
+func TestEngineGroupReturnsPooledSessions(t *testing.T) {
+	pool := &poolStub{StubEngine: NewStubEngine(nil, "base")}
+	group, err := NewEngineGroup([]Replica{{Name: "base", Engine: pool}})
+	if err != nil {
+		t.Fatalf("NewEngineGroup returned error: %v", err)
+	}
+
+	first, err := group.NewSession()
+	if err != nil {
+		t.Fatalf("NewSession returned error: %v", err)
+	}
+	_ = first.Close()
+	_ = first.Close()
+	if len(pool.idle) != 1 {
+		t.Fatalf("expected the session released once, got %d idle", len(pool.idle))
+	}
+	reused := pool.idle[0]
+
+	second, err := group.NewSession()
+	if err != nil {
+		t.Fatalf("NewSession returned error: %v", err)
+	}
+	if second.(*groupSession).Engine != reused || pool.acquired != 2 {
+		t.Fatalf("expected the idle session to be reused, acquired=%d", pool.acquired)
+	}
+	_ = second.Close()
+}
@@ -10,6 +10,8 @@ package engine
 #cgo darwin LDFLAGS: -lggml-metal -lggml-blas -framework Accelerate -framework Metal -framework Foundation -framework CoreGraphics
 #include <stdlib.h>
 #include "native_stream.h"
+
+extern bool goWhisperStreamShouldAbort(void *user_data);
 */
 import "C"
 
@@ -17,13 +19,17 @@ import (
 	"context"
 	"errors"
 	"fmt"
-	"math"
 	"os"
+	"path/filepath"
 	"runtime"
+	"runtime/cgo"
 	"strconv"
 	"strings"
 	"sync"
+	"time"
 	"unsafe"
+
+	"github.com/nupi-ai/plugin-stt-local-whisper/internal/telemetry"
 )
 
 const (
@@ -32,17 +38,99 @@ const (
 	defaultKeepMillis    = 200 // Audio overlap between windows
 	defaultVADThreshold  = 0.6
 	defaultFreqThreshold = 100.0
-	defaultFlashAttnEnv  = "WHISPERCPP_FLASH_ATTENTION"
-	useGPUEnv            = "WHISPERCPP_USE_GPU"
-	threadsEnv           = "WHISPERCPP_THREADS"
+	// Mean token probability below which an adaptive audio_ctx window is
+	// decoded again with the full encoder context.
+	defaultAudioCtxMinConf = 0.5
+	// Mean token probability below which a greedy window is decoded again
+	// with beam search in adaptive mode.
+	defaultAdaptiveBeamMinConf = 0.6
+	// A draft partial every half second keeps live captions moving.
+	defaultDraftIntervalMs = 500
+	// One second of audio is enough to touch every encoder and decoder kernel.
+	defaultWarmupMs = 1000
+	// Released sessions kept for reuse; each holds a whisper_state and its
+	// stream buffers.
+	defaultSessionPoolSize = 4
+	// Matches the native default of whisper_stream_set_endpointing.
+	defaultEndpointSilenceMs = 1000
+	// Matches the native default of whisper_stream_set_repetition_guard.
+	defaultRepetitionThreshold = 4
+	// Match the native defaults of whisper_stream_set_language_cache.
+	defaultLanguagePinWindows     = 2
+	defaultLanguageRecheckWindows = 20
+	defaultLanguageMinProb        = 0.8
+	defaultFlashAttnEnv           = "WHISPERCPP_FLASH_ATTENTION"
+	useGPUEnv                     = "WHISPERCPP_USE_GPU"
+	threadsEnv                    = "WHISPERCPP_THREADS"
 )
 
+var errSessionClosed = errors.New("whisper: session closed")
+
 func NativeAvailable() bool { return true }
 
+//export goWhisperStreamShouldAbort
+func goWhisperStreamShouldAbort(userData unsafe.Pointer) C.bool {
+	return C.bool(shouldAbort(userData))
+}
+
+// withAbortProbe runs a native call with an abort callback bound to ctx, so
+// inference stops soon after the caller goes away. Contexts that can never be
+// cancelled skip the probe entirely.
+func withAbortProbe(ctx context.Context, call func(C.whisper_stream_abort_callback, unsafe.Pointer) C.int) C.int {
+	if ctx.Done() == nil {
+		return call(nil, nil)
+	}
+	handle := cgo.NewHandle(ctx)
+	defer handle.Delete()
+	return call(C.whisper_stream_abort_callback(C.goWhisperStreamShouldAbort), unsafe.Pointer(&handle))
+}
+
+// abortError maps WHISPER_STREAM_ERR_ABORTED back to the context error.
+func abortError(ctx context.Context) error {
+	if err := ctx.Err(); err != nil {
+		return err
+	}
+	return context.Canceled
+}
+
+// NativeEngine owns the shared model weights. Streams are served by sessions
+// created with NewSession; the engine itself also implements Engine through a
+// lazily created default session for callers that drive a single stream.
 type NativeEngine struct {
 	mu sync.Mutex
 
-	stream *C.whisper_stream
+	model      *C.whisper_stream_model
+	draftModel *C.whisper_stream_model
+	params     streamParams
+	session    *NativeSession
+	budget     *ThreadBudget
+	observer   observerSlot
+	loadTime   time.Duration
+	warmupTime time.Duration
+	memory     telemetry.ModelMemory
+
+	// idle holds released sessions, reset and ready for Acquire.
+	idle     []*NativeSession
+	poolSize int
+
+	defaultLang string
+}
+
+// NativeSession is a single transcription stream backed by a shared model.
+// Each session owns its whisper_state, audio windows and token history, so
+// concurrent sessions never contend on a common lock.
+type NativeSession struct {
+	mu sync.Mutex
+
+	stream       *C.whisper_stream
+	engine       *NativeEngine
+	budget       *ThreadBudget
+	pool         int // the session's budget pool, -1 while idle
+	observer     *observerSlot
+	melCache     bool
+	batchWorkers int
+	melStats     C.whisper_stream_mel_stats
+	stats        C.whisper_stream_stats
 
 	defaultLang        string
 	lastConf           float32
@@ -51,6 +139,46 @@ type NativeEngine struct {
 	languageConfigured bool
 }
 
+// streamParams captures the resolved per-stream decoding configuration.
+type streamParams struct {
+	stepMs          int
+	lengthMs        int
+	keepMs          int
+	threads         int
+	translate       bool
+	temperatureInc  float32
+	disableFallback bool
+	beamSize        int
+	maxDecoders     int
+	audioCtx        int
+	printTimestamps bool
+	printSpecial    bool
+	keepContext     bool
+	useVAD          bool
+	vadThold        float32
+	freqThold       float32
+	maxTokens       int
+	tinyDiarize     bool
+	melCache        bool
+	audioCtxAuto    bool
+	audioCtxMinConf float32
+	adaptiveBeam    bool
+	beamMinConf     float32
+	tokenTimestamps bool
+	draftIntervalMs int
+	batchWorkers    int
+	speechGate      C.int32_t
+	speechGateThold float32
+	repetitionThold int
+	langPinWindows  int
+	langRecheck     int
+	langMinProb     float32
+	endpointMs      int
+	endpointMinMs   int
+	endpointAdaptMs int
+	speculative     bool
+}
+
 func NewNativeEngine(modelPath string, opts NativeOptions) (Engine, error) {
 	if strings.TrimSpace(modelPath) == "" {
 		return nil, errors.New("whisper: model path required")
@@ -97,6 +225,10 @@ func NewNativeEngine(modelPath string, opts NativeOptions) (Engine, error) {
 	if opts.BeamSize != nil && *opts.BeamSize > 0 {
 		beamSize = *opts.BeamSize
 	}
+	maxDecoders := 0
+	if opts.MaxDecoders != nil && *opts.MaxDecoders > 0 {
+		maxDecoders = *opts.MaxDecoders
+	}
 
 	audioCtx := 0
 	if opts.AudioCtx != nil {
@@ -185,42 +317,691 @@ func NewNativeEngine(modelPath string, opts NativeOptions) (Engine, error) {
 	if disableFallback {
 		temperatureInc = 0
 	}
+	melCache := false
+	if opts.MelCache != nil {
+		melCache = *opts.MelCache && !useVAD
+	}
+	audioCtxAuto := false
+	if opts.AudioCtxAuto != nil {
+		audioCtxAuto = *opts.AudioCtxAuto
+	}
+	audioCtxMinConf := float32(defaultAudioCtxMinConf)
+	if opts.AudioCtxMinConfidence != nil && *opts.AudioCtxMinConfidence >= 0 && *opts.AudioCtxMinConfidence <= 1 {
+		audioCtxMinConf = *opts.AudioCtxMinConfidence
+	}
+	// Adaptive decoding only changes anything when there is a beam to fall
+	// back to.
+	adaptiveBeam := false
+	if opts.AdaptiveBeam != nil {
+		adaptiveBeam = *opts.AdaptiveBeam && beamSize > 1
+	}
+	beamMinConf := float32(defaultAdaptiveBeamMinConf)
+	if opts.AdaptiveBeamMinConfidence != nil && *opts.AdaptiveBeamMinConfidence >= 0 && *opts.AdaptiveBeamMinConfidence <= 1 {
+		beamMinConf = *opts.AdaptiveBeamMinConfidence
+	}
+	tokenTimestamps := false
+	if opts.TokenTimestamps != nil {
+		tokenTimestamps = *opts.TokenTimestamps
+	}
+	dtwTimestamps := false
+	if opts.DTWTimestamps != nil {
+		dtwTimestamps = *opts.DTWTimestamps && !flashAttn
+	}
+	draftIntervalMs := defaultDraftIntervalMs
+	if opts.DraftIntervalMs != nil && *opts.DraftIntervalMs > 0 {
+		draftIntervalMs = *opts.DraftIntervalMs
+	}
+	var numaNodes [][]int32
+	switch pinning := strings.ToLower(strings.TrimSpace(opts.CPUPinning)); pinning {
+	case "", CPUPinningNone:
+	case CPUPinningNUMA:
+		// Refuse rather than pin only the calling thread: OpenMP workers
+		// would keep running wherever they were created.
+		if C.whisper_stream_cpu_pinning_supported() == 0 {
+			return nil, errors.New("whisper: numa cpu pinning needs thread affinity and a native build without OpenMP (-DGGML_OPENMP=OFF)")
+		}
+		// A single node has nothing to keep local; leave placement to the OS.
+		if nodes := numaNodeCPUs(); len(nodes) > 1 {
+			numaNodes = nodes
+		}
+	default:
+		return nil, fmt.Errorf("whisper: unknown cpu pinning policy %q", opts.CPUPinning)
+	}
+	var speechGate C.int32_t
+	switch gate := strings.ToLower(strings.TrimSpace(opts.SpeechGate)); gate {
+	case "", SpeechGateOff:
+		speechGate = C.WHISPER_STREAM_SPEECH_GATE_OFF
+	case SpeechGateEnergy:
+		speechGate = C.WHISPER_STREAM_SPEECH_GATE_ENERGY
+	case SpeechGateSilero:
+		if strings.TrimSpace(opts.VADModelPath) == "" {
+			return nil, errors.New("whisper: silero speech gate requires a VAD model path")
+		}
+		speechGate = C.WHISPER_STREAM_SPEECH_GATE_SILERO
+	default:
+		return nil, fmt.Errorf("whisper: unknown speech gate %q", opts.SpeechGate)
+	}
+	speechGateThold := float32(0)
+	if opts.SpeechGateThreshold != nil && *opts.SpeechGateThreshold > 0 {
+		speechGateThold = *opts.SpeechGateThreshold
+	}
+	batchWorkers := 0
+	if opts.BatchWorkers != nil && *opts.BatchWorkers > 0 {
+		batchWorkers = *opts.BatchWorkers
+	}
+	repetitionThold := defaultRepetitionThreshold
+	if opts.RepetitionThreshold != nil && *opts.RepetitionThreshold >= 0 {
+		repetitionThold = *opts.RepetitionThreshold
+	}
+	langPinWindows := defaultLanguagePinWindows
+	if opts.LanguagePinWindows != nil && *opts.LanguagePinWindows >= 0 {
+		langPinWindows = *opts.LanguagePinWindows
+	}
+	langRecheck := defaultLanguageRecheckWindows
+	if opts.LanguageRecheckWindows != nil && *opts.LanguageRecheckWindows >= 0 {
+		langRecheck = *opts.LanguageRecheckWindows
+	}
+	langMinProb := float32(defaultLanguageMinProb)
+	if opts.LanguageMinProbability != nil && *opts.LanguageMinProbability >= 0 && *opts.LanguageMinProbability <= 1 {
+		langMinProb = *opts.LanguageMinProbability
+	}
+	endpointMs := defaultEndpointSilenceMs
+	if opts.EndpointSilenceMs != nil && *opts.EndpointSilenceMs > 0 {
+		endpointMs = *opts.EndpointSilenceMs
+	}
+	endpointMinMs := 0
+	if opts.EndpointMinSilenceMs != nil && *opts.EndpointMinSilenceMs > 0 {
+		endpointMinMs = *opts.EndpointMinSilenceMs
+	}
+	endpointAdaptMs := 0
+	if opts.EndpointAdaptMs != nil && *opts.EndpointAdaptMs > 0 {
+		endpointAdaptMs = *opts.EndpointAdaptMs
+	}
+	speculative := false
+	if opts.SpeculativeEndpoint != nil {
+		speculative = *opts.SpeculativeEndpoint
+	}
+	warmupMs := defaultWarmupMs
+	if opts.WarmupMs != nil && *opts.WarmupMs >= 0 {
+		warmupMs = *opts.WarmupMs
+	}
+	poolSize := defaultSessionPoolSize
+	if opts.SessionPoolSize != nil && *opts.SessionPoolSize >= 0 {
+		poolSize = *opts.SessionPoolSize
+	}
+
+	switch quantization := strings.ToLower(strings.TrimSpace(opts.Quantization)); quantization {
+	case "", QuantizationNone:
+	default:
+		quantized, err := quantizedModelPath(modelPath, quantization, strings.TrimSpace(opts.QuantizedModelDir), threads)
+		if err != nil {
+			return nil, err
+		}
+		modelPath = quantized
+	}
+
+	loadParams := C.whisper_stream_model_default_params()
+	loadParams.use_gpu = C.bool(useGPU)
+	loadParams.flash_attn = C.bool(flashAttn)
+	if opts.GPUDevice != nil && *opts.GPUDevice > 0 {
+		loadParams.gpu_device = C.int32_t(*opts.GPUDevice)
+	}
 
 	cModel := C.CString(modelPath)
 	defer C.free(unsafe.Pointer(cModel))
 
-	stream := C.whisper_stream_create(
-		cModel,
-		C.int32_t(stepMs),
-		C.int32_t(lengthMs),
-		C.int32_t(keepMs),
-		C.int32_t(threads),
-		C.bool(useGPU),
-		C.bool(flashAttn),
-		C.bool(translate),
-		C.float(temperatureInc),
-		C.bool(disableFallback),
-		C.int32_t(beamSize),
-		C.int32_t(audioCtx),
-		C.bool(printTimestamps),
-		C.bool(printSpecial),
-		C.bool(keepContext),
-		C.bool(useVAD),
-		C.float(vadThold),
-		C.float(freqThold),
-		C.int32_t(maxTokens),
-		C.bool(tinyDiarize),
+	loadStart := time.Now()
+	modelParams := loadParams
+	modelParams.dtw_timestamps = C.bool(dtwTimestamps)
+	model := C.whisper_stream_model_load_with_params(cModel, modelParams)
+	if model == nil {
+		return nil, fmt.Errorf("whisper: failed to initialise context for %s", modelPath)
+	}
+
+	if speechGate == C.WHISPER_STREAM_SPEECH_GATE_SILERO {
+		cVAD := C.CString(strings.TrimSpace(opts.VADModelPath))
+		rc := C.whisper_stream_model_load_vad(model, cVAD, 1)
+		C.free(unsafe.Pointer(cVAD))
+		if rc != 0 {
+			C.whisper_stream_model_free(model)
+			return nil, fmt.Errorf("whisper: failed to load VAD model %s", opts.VADModelPath)
+		}
+	}
+
+	var draftModel *C.whisper_stream_model
+	if draftPath := strings.TrimSpace(opts.DraftModelPath); draftPath != "" {
+		cDraft := C.CString(draftPath)
+		defer C.free(unsafe.Pointer(cDraft))
+		draftModel = C.whisper_stream_model_load_with_params(cDraft, loadParams)
+		if draftModel == nil {
+			C.whisper_stream_model_free(model)
+			return nil, fmt.Errorf("whisper: failed to initialise draft context for %s", draftPath)
+		}
+	}
+
+	budget := opts.ThreadBudget
+	if budget == nil {
+		budget = NewThreadBudget(threads, numaNodes)
+	}
+	engine := &NativeEngine{
+		model:      model,
+		draftModel: draftModel,
+		budget:     budget,
+		memory:     modelMemory(model),
+		poolSize:   poolSize,
+		params: streamParams{
+			stepMs:          stepMs,
+			lengthMs:        lengthMs,
+			keepMs:          keepMs,
+			threads:         threads,
+			translate:       translate,
+			temperatureInc:  temperatureInc,
+			disableFallback: disableFallback,
+			beamSize:        beamSize,
+			maxDecoders:     maxDecoders,
+			audioCtx:        audioCtx,
+			printTimestamps: printTimestamps,
+			printSpecial:    printSpecial,
+			keepContext:     keepContext,
+			useVAD:          useVAD,
+			vadThold:        vadThold,
+			freqThold:       freqThold,
+			maxTokens:       maxTokens,
+			tinyDiarize:     tinyDiarize,
+			melCache:        melCache,
+			audioCtxAuto:    audioCtxAuto,
+			audioCtxMinConf: audioCtxMinConf,
+			adaptiveBeam:    adaptiveBeam,
+			beamMinConf:     beamMinConf,
+			tokenTimestamps: tokenTimestamps,
+			draftIntervalMs: draftIntervalMs,
+			batchWorkers:    batchWorkers,
+			speechGate:      speechGate,
+			speechGateThold: speechGateThold,
+			repetitionThold: repetitionThold,
+			langPinWindows:  langPinWindows,
+			langRecheck:     langRecheck,
+			langMinProb:     langMinProb,
+			endpointMs:      endpointMs,
+			endpointMinMs:   endpointMinMs,
+			endpointAdaptMs: endpointAdaptMs,
+			speculative:     speculative,
+		},
+	}
+
+	// Allocate one state up front so configuration errors surface at startup;
+	// freeing the stream returns the state to the pool for the first session.
+	probe := engine.newStreamLocked()
+	if probe == nil {
+		C.whisper_stream_model_free(model)
+		if draftModel != nil {
+			C.whisper_stream_model_free(draftModel)
+			return nil, fmt.Errorf("whisper: failed to initialise state for %s with draft model %s (vocabularies must match)",
+				modelPath, opts.DraftModelPath)
+		}
+		return nil, fmt.Errorf("whisper: failed to initialise state for %s", modelPath)
+	}
+	C.whisper_stream_free(probe)
+	engine.loadTime = time.Since(loadStart)
+
+	// Run one short decode so the first real window does not pay for backend
+	// kernel compilation and buffer allocation. The warmed state goes back to
+	// the pool for the first session. A model that cannot decode the clip
+	// would fail its first stream too, so a failed warm-up fails the load.
+	if warmupMs > 0 {
+		decodes := []func() int{func() int {
+			return int(C.whisper_stream_model_warmup(model, C.int32_t(warmupMs), C.int32_t(threads)))
+		}}
+		if draftModel != nil {
+			decodes = append(decodes, func() int {
+				return int(C.whisper_stream_model_warmup(draftModel, C.int32_t(warmupMs), C.int32_t(threads)))
+			})
+		}
+		warmupTime, err := warmUp(decodes...)
+		if err != nil {
+			_ = engine.Close()
+			return nil, fmt.Errorf("%w for %s", err, modelPath)
+		}
+		engine.warmupTime = warmupTime
+	}
+
+	return engine, nil
+}
+
+// newStreamLocked creates a stream from the shared model. Callers must hold
+// e.mu or otherwise own the engine exclusively.
+func (e *NativeEngine) newStreamLocked() *C.whisper_stream {
+	p := e.params
+	stream := C.whisper_stream_create_from_model(
+		e.model,
+		C.int32_t(p.stepMs),
+		C.int32_t(p.lengthMs),
+		C.int32_t(p.keepMs),
+		C.int32_t(p.threads),
+		C.bool(p.translate),
+		C.float(p.temperatureInc),
+		C.bool(p.disableFallback),
+		C.int32_t(p.beamSize),
+		C.int32_t(p.audioCtx),
+		C.bool(p.printTimestamps),
+		C.bool(p.printSpecial),
+		C.bool(p.keepContext),
+		C.bool(p.useVAD),
+		C.float(p.vadThold),
+		C.float(p.freqThold),
+		C.int32_t(p.maxTokens),
+		C.bool(p.tinyDiarize),
 	)
 	if stream == nil {
-		return nil, fmt.Errorf("whisper: failed to initialise context for %s", modelPath)
+		return nil
+	}
+	// Results are copied out under the session lock before the next call,
+	// so the stream can keep building them in one reused buffer.
+	if C.whisper_stream_set_reuse_results(stream, C.bool(true)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if p.audioCtxAuto && C.whisper_stream_set_audio_ctx_auto(stream, C.bool(true), C.float(p.audioCtxMinConf)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if p.maxDecoders > 0 && C.whisper_stream_set_max_decoders(stream, C.int32_t(p.maxDecoders)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if p.adaptiveBeam && C.whisper_stream_set_adaptive_beam(stream, C.bool(true), C.float(p.beamMinConf)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if e.draftModel != nil && C.whisper_stream_set_draft_model(stream, e.draftModel, C.int32_t(p.draftIntervalMs)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if p.speechGate != C.WHISPER_STREAM_SPEECH_GATE_OFF &&
+		C.whisper_stream_set_speech_gate(stream, p.speechGate, C.float(p.speechGateThold)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if p.repetitionThold != defaultRepetitionThreshold &&
+		C.whisper_stream_set_repetition_guard(stream, C.int32_t(p.repetitionThold)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if (p.langPinWindows != defaultLanguagePinWindows || p.langRecheck != defaultLanguageRecheckWindows ||
+		p.langMinProb != defaultLanguageMinProb) &&
+		C.whisper_stream_set_language_cache(stream, C.int32_t(p.langPinWindows), C.float(p.langMinProb), C.int32_t(p.langRecheck)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
 	}
+	if p.useVAD && (p.endpointMs != defaultEndpointSilenceMs || p.endpointAdaptMs > 0 || p.speculative) &&
+		C.whisper_stream_set_endpointing(stream, C.int32_t(p.endpointMs), C.int32_t(p.endpointMinMs),
+			C.int32_t(p.endpointAdaptMs), C.bool(p.speculative)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if p.tokenTimestamps && C.whisper_stream_set_token_timestamps(stream, C.bool(true)) != 0 {
+		C.whisper_stream_free(stream)
+		return nil
+	}
+	if p.melCache && C.whisper_stream_set_mel_cache(stream, C.bool(true)) != 0 {
+		// The model file does not carry readable mel filters; whisper.cpp
+		// computes the spectrogram itself for this and later streams.
+		e.params.melCache = false
+	}
+	return stream
+}
+
+// NewSession creates an independent transcription session that shares the
+// engine's model weights. The caller must Close the session when done.
+func (e *NativeEngine) NewSession() (Engine, error) {
+	return e.newSession()
+}
+
+func (e *NativeEngine) newSession() (*NativeSession, error) {
+	e.mu.Lock()
+	defer e.mu.Unlock()
 
-	return &NativeEngine{
-		stream: stream,
+	if e.model == nil {
+		return nil, errors.New("whisper: engine closed")
+	}
+	stream := e.newStreamLocked()
+	if stream == nil {
+		return nil, errors.New("whisper: failed to allocate stream state")
+	}
+	return &NativeSession{
+		stream:       stream,
+		engine:       e,
+		budget:       e.budget,
+		pool:         e.budget.Join(),
+		observer:     &e.observer,
+		melCache:     e.params.melCache,
+		batchWorkers: e.params.batchWorkers,
+		defaultLang:  e.defaultLang,
 	}, nil
 }
 
+// Acquire implements SessionPool: it hands out a session released earlier,
+// already reset, or opens a new one when none is idle.
+func (e *NativeEngine) Acquire() (Engine, error) {
+	e.mu.Lock()
+	if e.model == nil {
+		e.mu.Unlock()
+		return nil, errors.New("whisper: engine closed")
+	}
+	if n := len(e.idle); n > 0 {
+		session := e.idle[n-1]
+		e.idle[n-1] = nil
+		e.idle = e.idle[:n-1]
+		defaultLang := e.defaultLang
+		e.mu.Unlock()
+		session.resume(defaultLang)
+		return session, nil
+	}
+	e.mu.Unlock()
+	return e.newSession()
+}
+
+// Release implements SessionPool. The session is reset and parked for the
+// next Acquire while the pool has room; otherwise it is closed. Sessions not
+// opened by this engine are closed.
+func (e *NativeEngine) Release(session Engine) {
+	s, ok := session.(*NativeSession)
+	if !ok || s.engine != e {
+		if session != nil {
+			_ = session.Close()
+		}
+		return
+	}
+	if err := s.Reset(); err != nil {
+		_ = s.Close()
+		return
+	}
+
+	e.mu.Lock()
+	defer e.mu.Unlock()
+	if e.model == nil || len(e.idle) >= e.poolSize {
+		_ = s.Close()
+		return
+	}
+	s.park()
+	e.idle = append(e.idle, s)
+}
+
+// defaultSession returns the session used when the engine is driven directly.
+func (e *NativeEngine) defaultSession() (*NativeSession, error) {
+	e.mu.Lock()
+	session := e.session
+	e.mu.Unlock()
+	if session != nil {
+		return session, nil
+	}
+
+	session, err := e.newSession()
+	if err != nil {
+		return nil, err
+	}
+
+	e.mu.Lock()
+	defer e.mu.Unlock()
+	if e.session != nil {
+		// Lost a creation race; keep the first session.
+		_ = session.Close()
+		return e.session, nil
+	}
+	e.session = session
+	return session, nil
+}
+
 func (e *NativeEngine) TranscribeSegment(ctx context.Context, audio []byte, opts Options) ([]Result, error) {
+	if err := ctx.Err(); err != nil {
+		return nil, err
+	}
+	session, err := e.defaultSession()
+	if err != nil {
+		return nil, err
+	}
+	return session.TranscribeSegment(ctx, audio, opts)
+}
+
+// TranscribeBatch implements BatchTranscriber on the default session.
+func (e *NativeEngine) TranscribeBatch(ctx context.Context, audio []byte, opts Options) ([]Result, error) {
+	if err := ctx.Err(); err != nil {
+		return nil, err
+	}
+	session, err := e.defaultSession()
+	if err != nil {
+		return nil, err
+	}
+	return session.TranscribeBatch(ctx, audio, opts)
+}
+
+func (e *NativeEngine) Flush(ctx context.Context, opts Options) ([]Result, error) {
+	if err := ctx.Err(); err != nil {
+		return nil, err
+	}
+	session, err := e.defaultSession()
+	if err != nil {
+		return nil, err
+	}
+	return session.Flush(ctx, opts)
+}
+
+// quantizedModelPath returns the copy of modelPath quantized to format,
+// writing it into dir first when it is missing or older than the model.
+// A model that is already quantized is returned unchanged.
+func quantizedModelPath(modelPath, format, dir string, threads int) (string, error) {
+	var ftype C.int32_t
+	switch format {
+	case QuantizationQ5_0:
+		ftype = C.WHISPER_STREAM_FTYPE_Q5_0
+	case QuantizationQ8_0:
+		ftype = C.WHISPER_STREAM_FTYPE_Q8_0
+	default:
+		return "", fmt.Errorf("whisper: unknown quantization %q", format)
+	}
+	source, err := os.Stat(modelPath)
+	if err != nil {
+		return "", fmt.Errorf("whisper: stat model: %w", err)
+	}
+	if dir == "" {
+		dir = filepath.Dir(modelPath)
+	}
+	target := filepath.Join(dir, strings.TrimSuffix(filepath.Base(modelPath), ".bin")+"-"+format+".bin")
+	if cached, err := os.Stat(target); err == nil && !cached.ModTime().Before(source.ModTime()) {
+		return target, nil
+	}
+	if err := os.MkdirAll(dir, 0o755); err != nil {
+		return "", fmt.Errorf("whisper: create quantized model dir: %w", err)
+	}
+
+	cSource := C.CString(modelPath)
+	defer C.free(unsafe.Pointer(cSource))
+	cTarget := C.CString(target)
+	defer C.free(unsafe.Pointer(cTarget))
+	switch rc := C.whisper_stream_model_quantize(cSource, cTarget, ftype, C.int32_t(threads)); rc {
+	case 0:
+		return target, nil
+	case 1:
+		return modelPath, nil
+	default:
+		return "", fmt.Errorf("whisper: failed to quantize %s to %s (rc=%d)", modelPath, format, int(rc))
+	}
+}
+
+// ggmlFileTypes names the ggml file types whisper.cpp models ship in.
+var ggmlFileTypes = map[C.int32_t]string{
+	C.WHISPER_STREAM_FTYPE_F32:  "f32",
+	C.WHISPER_STREAM_FTYPE_F16:  "f16",
+	2:                           "q4_0",
+	3:                           "q4_1",
+	C.WHISPER_STREAM_FTYPE_Q8_0: "q8_0",
+	C.WHISPER_STREAM_FTYPE_Q5_0: "q5_0",
+	9:                           "q5_1",
+}
+
+func modelMemory(model *C.whisper_stream_model) telemetry.ModelMemory {
+	var info C.whisper_stream_model_info
+	if C.whisper_stream_model_get_info(model, &info) != 0 {
+		return telemetry.ModelMemory{}
+	}
+	format, ok := ggmlFileTypes[info.ftype]
+	if !ok {
+		format = "ftype" + strconv.Itoa(int(info.ftype))
+	}
+	return telemetry.ModelMemory{
+		Format:        format,
+		WeightBytes:   uint64(info.weight_bytes),
+		ResidentBytes: uint64(info.resident_bytes),
+	}
+}
+
+func (e *NativeEngine) Close() error {
+	e.mu.Lock()
+	session := e.session
+	e.session = nil
+	model := e.model
+	e.model = nil
+	draftModel := e.draftModel
+	e.draftModel = nil
+	idle := e.idle
+	e.idle = nil
+	e.mu.Unlock()
+
+	for _, s := range idle {
+		_ = s.Close()
+	}
+	if session != nil {
+		_ = session.Close()
+	}
+	if model != nil {
+		// Sessions still open keep their own reference to the weights.
+		C.whisper_stream_model_free(model)
+	}
+	if draftModel != nil {
+		C.whisper_stream_model_free(draftModel)
+	}
+	return nil
+}
+
+func (e *NativeEngine) SetDefaultLanguage(lang string) {
+	e.mu.Lock()
+	e.defaultLang = normaliseLanguageCode(lang)
+	session := e.session
+	e.mu.Unlock()
+
+	if session != nil {
+		session.SetDefaultLanguage(lang)
+	}
+}
+
+// ThreadBudget returns the budget the engine's sessions draw threads from.
+func (e *NativeEngine) ThreadBudget() *ThreadBudget {
+	return e.budget
+}
+
+// SetObserver reports model load and warm-up time, mel cache reuse and per-stage inference timings to observer.
+func (e *NativeEngine) SetObserver(observer Observer) {
+	e.observer.set(observer)
+	if observer != nil {
+		observer.RecordStartup(e.loadTime, e.warmupTime, e.memory)
+	}
+}
+
+// reportMelStatsLocked forwards mel cache counters accumulated since the
+// previous report.
+func (s *NativeSession) reportMelStatsLocked() {
+	if !s.melCache || s.observer == nil {
+		return
+	}
+	observer := s.observer.get()
+	if observer == nil {
+		return
+	}
+	var stats C.whisper_stream_mel_stats
+	if C.whisper_stream_get_mel_stats(s.stream, &stats) != 0 {
+		return
+	}
+	computed := uint64(stats.frames_computed - s.melStats.frames_computed)
+	reused := uint64(stats.frames_reused - s.melStats.frames_reused)
+	elapsed := time.Duration(stats.compute_us-s.melStats.compute_us) * time.Microsecond
+	s.melStats = stats
+	if computed == 0 && reused == 0 {
+		return
+	}
+	observer.RecordMelCache(computed, reused, elapsed)
+}
+
+// reportStageStatsLocked forwards the stage timings and counters accumulated
+// since the previous inference pass. Calls that only buffered audio leave
+// their VAD time to be reported with the next pass.
+func (s *NativeSession) reportStageStatsLocked() {
+	if s.observer == nil {
+		return
+	}
+	observer := s.observer.get()
+	if observer == nil {
+		return
+	}
+	var stats C.whisper_stream_stats
+	if C.whisper_stream_get_stats(s.stream, &stats) != 0 ||
+		(stats.passes == s.stats.passes && stats.silent_samples == s.stats.silent_samples &&
+			stats.endpoints == s.stats.endpoints) {
+		return
+	}
+	prev := s.stats
+	s.stats = stats
+	micros := func(cur, old C.uint64_t) time.Duration {
+		return time.Duration(cur-old) * time.Microsecond
+	}
+	observer.RecordStages(telemetry.InferenceStages{
+		Assembly:        micros(stats.total.assemble, prev.total.assemble),
+		VAD:             micros(stats.total.vad, prev.total.vad),
+		Mel:             micros(stats.total.mel, prev.total.mel),
+		Encode:          micros(stats.total.encode, prev.total.encode),
+		Decode:          micros(stats.total.decode, prev.total.decode),
+		Passes:          uint64(stats.passes - prev.passes),
+		Fallbacks:       uint64(stats.fallbacks - prev.fallbacks),
+		AudioCtxRetries: uint64(stats.audio_ctx_retries - prev.audio_ctx_retries),
+		Tokens:          uint64(stats.tokens - prev.tokens),
+		WindowSamples:   uint64(stats.window_samples - prev.window_samples),
+		RepetitionLoops: uint64(stats.repetition_loops - prev.repetition_loops),
+		RepetitionCuts:  uint64(stats.repetition_cutoffs - prev.repetition_cutoffs),
+		BeamReruns:      uint64(stats.beam_reruns - prev.beam_reruns),
+		LanguageDetects: uint64(stats.language_detections - prev.language_detections),
+		LanguageReuses:  uint64(stats.language_reuses - prev.language_reuses),
+		SilentWindows:   uint64(stats.silent_windows - prev.silent_windows),
+		SilentSamples:   uint64(stats.silent_samples - prev.silent_samples),
+		Endpoints:       uint64(stats.endpoints - prev.endpoints),
+		EndpointSamples: uint64(stats.endpoint_silence_samples - prev.endpoint_silence_samples),
+		Speculations:    uint64(stats.endpoint_speculations - prev.endpoint_speculations),
+		SpeculationHits: uint64(stats.endpoint_speculation_hits - prev.endpoint_speculation_hits),
+		StateMemory: telemetry.StateMemory{
+			StateBytes:   uint64(stats.state_bytes),
+			KVSelfBytes:  uint64(stats.kv_self_bytes),
+			KVCrossBytes: uint64(stats.kv_cross_bytes),
+		},
+	})
+}
+
+// runBudgeted runs a native inference call on threads claimed from the
+// session's budget pool, pinned to the pool's CPUs when pinning is enabled.
+// The share is taken when the call starts and waits while the pool is fully
+// claimed by calls already running.
+func (s *NativeSession) runBudgeted(ctx context.Context, call func(C.whisper_stream_abort_callback, unsafe.Pointer) C.int) (C.int, error) {
+	threads, cpus, release, err := s.budget.Acquire(ctx, s.pool)
+	if err != nil {
+		return 0, err
+	}
+	defer release()
+	var cpuPtr *C.int32_t
+	if len(cpus) > 0 {
+		cpuPtr = (*C.int32_t)(unsafe.Pointer(&cpus[0]))
+	}
+	C.whisper_stream_set_threads(s.stream, C.int32_t(threads), cpuPtr, C.int32_t(len(cpus)))
+	return withAbortProbe(ctx, call), nil
+}
+
+func (s *NativeSession) TranscribeSegment(ctx context.Context, audio []byte, opts Options) ([]Result, error) {
 	if err := ctx.Err(); err != nil {
 		return nil, err
 	}
@@ -228,120 +1009,292 @@ func (e *NativeEngine) TranscribeSegment(ctx context.Context, audio []byte, opts
 		return nil, nil
 	}
 
-	samples := pcmBytesToFloat32(audio)
-	if len(samples) == 0 {
+	// PCM16 LE is decoded inside the stream, straight into its window buffer.
+	sampleCount := len(audio) / 2
+	if sampleCount == 0 {
 		return nil, nil
 	}
 
-	e.mu.Lock()
-	defer e.mu.Unlock()
+	s.mu.Lock()
+	defer s.mu.Unlock()
 
-	if err := e.applyLanguageLocked(opts.Language); err != nil {
+	if s.stream == nil {
+		return nil, errSessionClosed
+	}
+	if err := s.applyLanguageLocked(opts.Language); err != nil {
 		return nil, err
 	}
 
-	var outText *C.char
-	var outConf C.float
+	var out *C.whisper_stream_result
 
-	rc := C.whisper_stream_process(
-		e.stream,
-		(*C.float)(unsafe.Pointer(&samples[0])),
-		C.int32_t(len(samples)),
-		&outText,
-		&outConf,
-	)
+	// Buffer the audio now and only claim threads once a window (1) or a
+	// draft pass (2) is due.
+	rc := C.whisper_stream_push_s16(s.stream, (*C.int16_t)(unsafe.Pointer(&audio[0])), C.int32_t(sampleCount))
+	if rc == 1 || rc == 2 {
+		var err error
+		rc, err = s.runBudgeted(ctx, func(abort C.whisper_stream_abort_callback, abortData unsafe.Pointer) C.int {
+			return C.whisper_stream_step_ex(s.stream, &out, abort, abortData)
+		})
+		if err != nil {
+			return nil, err
+		}
+	}
+	s.reportMelStatsLocked()
+	s.reportStageStatsLocked()
+	if rc == C.WHISPER_STREAM_ERR_ABORTED {
+		return nil, abortError(ctx)
+	}
 	if rc < 0 {
 		return nil, fmt.Errorf("whisper: process error (%d)", int(rc))
 	}
-	if rc == 0 {
-		if outText != nil {
-			C.whisper_stream_free_text(outText)
-		}
+	if rc == 0 || out == nil {
 		return nil, nil
 	}
 
-	text := C.GoString(outText)
-	C.whisper_stream_free_text(outText)
-	text = strings.TrimSpace(text)
-	if text == "" {
+	result := takeResult(out, false)
+	if result.Text == "" {
 		return nil, nil
 	}
-
-	conf := float32(outConf)
-	e.lastConf = conf
-
-	return []Result{{
-		Text:       text,
-		Confidence: conf,
-		Final:      false,
-	}}, nil
+	s.lastConf = result.Confidence
+	return []Result{result}, nil
 }
 
-func (e *NativeEngine) Flush(ctx context.Context, opts Options) ([]Result, error) {
+func (s *NativeSession) Flush(ctx context.Context, opts Options) ([]Result, error) {
 	if err := ctx.Err(); err != nil {
 		return nil, err
 	}
 
-	e.mu.Lock()
-	defer e.mu.Unlock()
+	s.mu.Lock()
+	defer s.mu.Unlock()
 
-	if err := e.applyLanguageLocked(opts.Language); err != nil {
+	if s.stream == nil {
+		return nil, errSessionClosed
+	}
+	if err := s.applyLanguageLocked(opts.Language); err != nil {
 		return nil, err
 	}
 
-	var outText *C.char
-	var outConf C.float
+	var out *C.whisper_stream_result
 
-	rc := C.whisper_stream_flush(e.stream, &outText, &outConf)
+	rc, err := s.runBudgeted(ctx, func(abort C.whisper_stream_abort_callback, abortData unsafe.Pointer) C.int {
+		return C.whisper_stream_flush_ex(s.stream, &out, abort, abortData)
+	})
+	if err != nil {
+		return nil, err
+	}
+	s.reportMelStatsLocked()
+	s.reportStageStatsLocked()
+	if rc == C.WHISPER_STREAM_ERR_ABORTED {
+		return nil, abortError(ctx)
+	}
 	if rc < 0 {
 		return nil, fmt.Errorf("whisper: flush error (%d)", int(rc))
 	}
+	if out == nil {
+		return nil, nil
+	}
 
-	text := C.GoString(outText)
-	C.whisper_stream_free_text(outText)
-	text = strings.TrimSpace(text)
-	if text == "" {
+	result := takeResult(out, true)
+	if result.Text == "" {
 		return nil, nil
 	}
+	s.lastConf = result.Confidence
+	return []Result{result}, nil
+}
 
-	conf := float32(outConf)
-	e.lastConf = conf
+// TranscribeBatch implements BatchTranscriber. The recording is decoded on
+// pooled states of the shared model, so the session's streaming window and
+// token history are left as they were. The call splits its thread share
+// across chunk workers.
+func (s *NativeSession) TranscribeBatch(ctx context.Context, audio []byte, opts Options) ([]Result, error) {
+	if err := ctx.Err(); err != nil {
+		return nil, err
+	}
+	sampleCount := len(audio) / 2
+	if sampleCount == 0 {
+		return nil, nil
+	}
 
-	return []Result{{
-		Text:       text,
-		Confidence: conf,
-		Final:      true,
-	}}, nil
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	if s.stream == nil {
+		return nil, errSessionClosed
+	}
+	if err := s.applyLanguageLocked(opts.Language); err != nil {
+		return nil, err
+	}
+
+	var out *C.whisper_stream_result
+	rc, err := s.runBudgeted(ctx, func(abort C.whisper_stream_abort_callback, abortData unsafe.Pointer) C.int {
+		return C.whisper_stream_transcribe_batch(
+			s.stream,
+			(*C.int16_t)(unsafe.Pointer(&audio[0])),
+			C.int32_t(sampleCount),
+			C.int32_t(s.batchWorkers),
+			&out,
+			abort,
+			abortData,
+		)
+	})
+	if err != nil {
+		return nil, err
+	}
+	s.reportStageStatsLocked()
+	if rc == C.WHISPER_STREAM_ERR_ABORTED {
+		return nil, abortError(ctx)
+	}
+	if rc < 0 {
+		return nil, fmt.Errorf("whisper: batch transcription error (%d)", int(rc))
+	}
+	if rc == 0 || out == nil {
+		return nil, nil
+	}
+
+	result := takeResult(out, true)
+	if result.Text == "" {
+		return nil, nil
+	}
+	s.lastConf = result.Confidence
+	return []Result{result}, nil
 }
 
-func (e *NativeEngine) Close() error {
-	e.mu.Lock()
-	defer e.mu.Unlock()
+// takeResult copies a native result, segments and tokens included, into Go
+// memory. The result lives in the stream's reused buffer, so it is neither
+// freed nor valid past the next call on the stream. Native text is already
+// trimmed.
+func takeResult(out *C.whisper_stream_result, final bool) Result {
+	result := Result{
+		Text:       C.GoStringN(out.text, out.text_len),
+		Confidence: float32(out.confidence),
+		Final:      final,
+		Draft:      !bool(out.stable),
+	}
+	if out.n_segments <= 0 {
+		return result
+	}
+	segments := unsafe.Slice(out.segments, int(out.n_segments))
+	result.Segments = make([]Segment, len(segments))
+	for i := range segments {
+		seg := &segments[i]
+		result.Segments[i] = Segment{
+			Text:       C.GoStringN(seg.text, seg.text_len),
+			Start:      nativeMillis(seg.t0_ms),
+			End:        nativeMillis(seg.t1_ms),
+			Confidence: float32(seg.confidence),
+		}
+		if seg.n_tokens <= 0 {
+			continue
+		}
+		tokens := unsafe.Slice(seg.tokens, int(seg.n_tokens))
+		converted := make([]Token, len(tokens))
+		for j := range tokens {
+			tok := &tokens[j]
+			converted[j] = Token{
+				Text:        C.GoStringN(tok.text, tok.text_len),
+				ID:          int32(tok.id),
+				Probability: float32(tok.p),
+				Start:       nativeMillis(tok.t0_ms),
+				End:         nativeMillis(tok.t1_ms),
+				DTW:         nativeMillis(tok.dtw_ms),
+			}
+		}
+		result.Segments[i].Tokens = converted
+	}
+	return result
+}
+
+func nativeMillis(ms C.int64_t) time.Duration {
+	if ms < 0 {
+		return NoTimestamp
+	}
+	return time.Duration(ms) * time.Millisecond
+}
 
-	if e.stream != nil {
-		C.whisper_stream_free(e.stream)
-		e.stream = nil
+// tokensLoop reports whether text tokens, oldest first, end in a loop the
+// repetition guard would cut at minRepeats.
+func tokensLoop(tokens []int32, minRepeats int) bool {
+	if len(tokens) == 0 {
+		return false
+	}
+	return C.whisper_stream_tokens_loop((*C.int32_t)(unsafe.Pointer(&tokens[0])), C.int32_t(len(tokens)), C.int32_t(minRepeats)) == 1
+}
+
+// Close releases the session's stream and returns its state to the model pool.
+func (s *NativeSession) Close() error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	if s.stream != nil {
+		C.whisper_stream_free(s.stream)
+		s.stream = nil
+		if s.pool >= 0 {
+			s.budget.Leave(s.pool)
+		}
 	}
 	return nil
 }
 
-func (e *NativeEngine) SetDefaultLanguage(lang string) {
-	e.mu.Lock()
-	e.defaultLang = normaliseLanguageCode(lang)
-	e.languageConfigured = false
-	e.mu.Unlock()
+// Reset clears the session for an unrelated stream without reallocating it:
+// audio, transcript, decoder context, language and statistics start over,
+// while the whisper_state and buffer capacity are kept.
+func (s *NativeSession) Reset() error {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	if s.stream == nil {
+		return errSessionClosed
+	}
+	if rc := C.whisper_stream_reset(s.stream); rc != 0 {
+		return fmt.Errorf("whisper: reset stream failed (%d)", int(rc))
+	}
+	s.melStats = C.whisper_stream_mel_stats{}
+	s.stats = C.whisper_stream_stats{}
+	s.lastConf = 0
+	s.lastLanguage = ""
+	s.lastDetectLanguage = false
+	s.languageConfigured = false
+	return nil
+}
+
+// park gives up the session's budget pool while it sits idle.
+func (s *NativeSession) park() {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.pool >= 0 {
+		s.budget.Leave(s.pool)
+		s.pool = -1
+	}
+}
+
+// resume rejoins the thread budget for a session taken from the idle pool.
+func (s *NativeSession) resume(defaultLang string) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if s.pool < 0 {
+		s.pool = s.budget.Join()
+	}
+	s.defaultLang = defaultLang
+	s.languageConfigured = false
 }
 
-func (e *NativeEngine) applyLanguageLocked(lang string) error {
+func (s *NativeSession) SetDefaultLanguage(lang string) {
+	s.mu.Lock()
+	s.defaultLang = normaliseLanguageCode(lang)
+	s.languageConfigured = false
+	s.mu.Unlock()
+}
+
+func (s *NativeSession) applyLanguageLocked(lang string) error {
 	hint := strings.TrimSpace(lang)
 	detect := false
 
 	switch {
 	case hint == "":
-		hint = e.defaultLang
+		hint = s.defaultLang
 	case strings.EqualFold(hint, "auto"):
-		if e.defaultLang != "" {
-			hint = e.defaultLang
+		if s.defaultLang != "" {
+			hint = s.defaultLang
 		} else {
 			hint = ""
 		}
@@ -353,7 +1306,7 @@ func (e *NativeEngine) applyLanguageLocked(lang string) error {
 		detect = true
 	}
 
-	if e.languageConfigured && e.lastLanguage == hint && e.lastDetectLanguage == detect {
+	if s.languageConfigured && s.lastLanguage == hint && s.lastDetectLanguage == detect {
 		return nil
 	}
 
@@ -363,13 +1316,13 @@ func (e *NativeEngine) applyLanguageLocked(lang string) error {
 		defer C.free(unsafe.Pointer(cLang))
 	}
 
-	if rc := C.whisper_stream_set_language(e.stream, cLang, C.bool(detect)); rc != 0 {
+	if rc := C.whisper_stream_set_language(s.stream, cLang, C.bool(detect)); rc != 0 {
 		return fmt.Errorf("whisper: set language failed (%d)", int(rc))
 	}
 
-	e.lastLanguage = hint
-	e.lastDetectLanguage = detect
-	e.languageConfigured = true
+	s.lastLanguage = hint
+	s.lastDetectLanguage = detect
+	s.languageConfigured = true
 	return nil
 }
 
@@ -383,17 +1336,3 @@ func normaliseLanguageCode(lang string) string {
 	}
 	return strings.ToLower(trimmed)
 }
-
-func pcmBytesToFloat32(buf []byte) []float32 {
-	n := len(buf) / 2
-	if n == 0 {
-		return nil
-	}
-	samples := make([]float32, n)
-	for i := 0; i < n; i++ {
-		u := uint16(buf[2*i]) | uint16(buf[2*i+1])<<8
-		val := int16(u)
-		samples[i] = float32(val) / float32(math.MaxInt16)
-	}
-	return samples
-}
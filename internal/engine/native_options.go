@@ -5,7 +5,10 @@ package engine
 type NativeOptions struct {
 	UseGPU         *bool
 	FlashAttention *bool
-	Threads        *int
+	// GPUDevice is the backend device the model is loaded on when UseGPU is
+	// set (default 0).
+	GPUDevice *int
+	Threads   *int
 	// StepMs configures the hop size for sliding-window inference.
 	StepMs *int
 	// LengthMs is the total window size before Whisper is invoked (--length).
@@ -20,8 +23,24 @@ type NativeOptions struct {
 	DisableFallback *bool
 	// BeamSize sets beam search size (1 for greedy sampling, >1 for beam search)
 	BeamSize *int
+	// MaxDecoders caps the decoders a pass allocates on temperature fallback,
+	// each holding a copy of the text KV cache (0 = whisper's default of 5).
+	// Must be >= BeamSize.
+	MaxDecoders *int
 	// AudioCtx sets encoder context size (0 = all audio)
 	AudioCtx *int
+	// AudioCtxAuto sizes the encoder context to each window instead of using
+	// AudioCtx, falling back to the full context on low-confidence output.
+	AudioCtxAuto *bool
+	// AudioCtxMinConfidence is the mean token probability (0..1) below which
+	// AudioCtxAuto retries a window with the full context (default 0.5).
+	AudioCtxMinConfidence *float32
+	// AdaptiveBeam decodes each window greedily and repeats it with beam
+	// search only when confidence is low. Needs BeamSize > 1.
+	AdaptiveBeam *bool
+	// AdaptiveBeamMinConfidence is the mean token probability (0..1) below
+	// which AdaptiveBeam repeats a window with beam search (default 0.6).
+	AdaptiveBeamMinConfidence *float32
 	// PrintTimestamps enables timestamp output in transcription
 	PrintTimestamps *bool
 	// PrintSpecial enables special token output
@@ -38,4 +57,88 @@ type NativeOptions struct {
 	MaxTokens *int
 	// TinyDiarize enables the experimental TinyDiARize feature (--tinydiarize).
 	TinyDiarize *bool
+	// MelCache reuses log-mel frames between overlapping sliding windows
+	// (ignored in VAD mode).
+	MelCache *bool
+	// TokenTimestamps estimates start and end times for each token in the
+	// Result segments.
+	TokenTimestamps *bool
+	// DTWTimestamps aligns token timestamps with cross-attention DTW; needs a
+	// standard whisper model and is ignored with FlashAttention enabled.
+	DTWTimestamps *bool
+	// DraftModelPath loads a smaller model (tiny or base, same vocabulary)
+	// that emits Draft partials between full passes.
+	DraftModelPath string
+	// DraftIntervalMs is how often the draft model decodes the live audio.
+	DraftIntervalMs *int
+	// WarmupMs is the length of the synthetic clip decoded once after loading
+	// so the first real window skips backend initialisation (0 disables).
+	WarmupMs *int
+	// RepetitionThreshold is how many back-to-back repeats of a short n-gram
+	// end a decoder's segment early (default 4; 0 disables the guard).
+	RepetitionThreshold *int
+	// LanguagePinWindows is how many consecutive auto-detect windows must
+	// agree on a language before it is pinned and detection is skipped
+	// (default 2; 0 detects on every window). LanguageMinProbability is the
+	// detection probability that counts towards the pin (default 0.8), and
+	// LanguageRecheckWindows how many pinned windows pass between checks
+	// (default 20; 0 never rechecks).
+	LanguagePinWindows     *int
+	LanguageMinProbability *float32
+	LanguageRecheckWindows *int
+	// EndpointSilenceMs is the trailing silence that ends an utterance in VAD
+	// mode (default 1000). With EndpointAdaptMs set, the silence needed
+	// shrinks towards EndpointMinSilenceMs as an utterance grows to that
+	// length. SpeculativeEndpoint decodes the utterance as soon as silence
+	// begins and returns that text at the endpoint unless speech resumed.
+	EndpointSilenceMs    *int
+	EndpointMinSilenceMs *int
+	EndpointAdaptMs      *int
+	SpeculativeEndpoint  *bool
+	// BatchWorkers is how many chunks TranscribeBatch decodes at once; the
+	// thread budget is split between them (0 = one worker per 4 threads).
+	BatchWorkers *int
+	// CPUPinning is CPUPinningNone (default) or CPUPinningNUMA, which spreads
+	// sessions across NUMA nodes and pins their inference threads to the
+	// node's cores. Threads is split across the nodes either way. NUMA pinning
+	// fails engine creation on native builds using OpenMP.
+	CPUPinning string
+	// ThreadBudget shares another engine's thread budget, so replicas of an
+	// EngineGroup split one set of CPU threads; nil builds a budget from
+	// Threads and CPUPinning.
+	ThreadBudget *ThreadBudget
+	// SpeechGate skips sliding-window inference on silence: SpeechGateOff
+	// (default), SpeechGateEnergy or SpeechGateSilero, which needs
+	// VADModelPath. Speech windows are also trimmed of leading silence.
+	SpeechGate string
+	// SpeechGateThreshold is the per-frame speech level: mean absolute
+	// amplitude for the energy gate (default 0.01), speech probability for
+	// Silero (default 0.5).
+	SpeechGateThreshold *float32
+	// VADModelPath points at whisper.cpp's Silero VAD model.
+	VADModelPath string
+	// Quantization loads the model's weights as QuantizationQ5_0 or
+	// QuantizationQ8_0. An f16/f32 model is quantized into QuantizedModelDir
+	// on first load (default: next to the model) and the copy is reused;
+	// models that are already quantized load as they are.
+	Quantization      string
+	QuantizedModelDir string
+	// SessionPoolSize is how many released sessions Release keeps, reset,
+	// for Acquire to hand out again instead of allocating; 0 disables the
+	// pool. Defaults to 4.
+	SessionPoolSize *int
 }
+
+// Weight formats accepted by NativeOptions.Quantization.
+const (
+	QuantizationNone = "none"
+	QuantizationQ5_0 = "q5_0"
+	QuantizationQ8_0 = "q8_0"
+)
+
+// Speech gates accepted by NativeOptions.SpeechGate.
+const (
+	SpeechGateOff    = "off"
+	SpeechGateEnergy = "energy"
+	SpeechGateSilero = "silero"
+)
@@ -1,23 +1,109 @@
 //go:build whispercpp
 
 #include "native_stream.h"
+#include "token_overlap.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "whisper.h"
 
+#if defined(__linux__)
+#define WHISPER_STREAM_HAVE_AFFINITY 1
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 static constexpr int kSampleRate = WHISPER_SAMPLE_RATE;
 static constexpr float kPi = 3.14159265358979323846f;
 static constexpr int kVadWindowMs = 2000;
 static constexpr int kVadLastMs = 1000;
+// Endpointing: bounds on the trailing silence that ends an utterance, and the
+// silence after which a speculative pass decodes it early; see
+// whisper_stream_set_endpointing.
+static constexpr int kEndpointMinSilenceMs = 100;
+static constexpr int kEndpointMaxSilenceMs = 5000;
+static constexpr int kEndpointSpeculateMs = 300;
+// Minimum spacing between abort callback invocations while ggml is computing.
+// The callback crosses into Go, so it is throttled rather than run per graph node.
+static constexpr int64_t kAbortPollIntervalUs = 1000;
+// Log-mel framing, as in whisper_pcm_to_mel.
+static constexpr int kMelFrameSize = WHISPER_N_FFT;
+static constexpr int kMelHop = WHISPER_HOP_LENGTH;
+static constexpr int kMelBins = 1 + kMelFrameSize / 2;
+static constexpr int kMelPadSamples = WHISPER_SAMPLE_RATE * WHISPER_CHUNK_SIZE;
+static constexpr uint32_t kGgmlFileMagic = 0x67676d6c;
+// Adaptive audio_ctx: encoder positions kept past the end of the audio, and
+// the step sizes are rounded to so graph shapes repeat between windows.
+static constexpr int kAudioCtxMargin = 64;
+static constexpr int kAudioCtxGranularity = 64;
+static constexpr float kDefaultAudioCtxMinConfidence = 0.5f;
+// Adaptive beam search: greedy windows below this mean token probability are
+// decoded again with beam search.
+static constexpr float kDefaultBeamMinConfidence = 0.6f;
+// Offline batch chunking: chunks stay under whisper's 30 s window and are cut
+// at the latest silence past the minimum length. The silence test looks at
+// the last kBatchSilenceMs of a kVadWindowMs window stepped back from the
+// longest cut; without one, chunks overlap by kBatchOverlapMs and the
+// duplicated tokens are dropped when stitching.
+static constexpr int kBatchChunkMs = 28000;
+static constexpr int kBatchMinChunkMs = 10000;
+static constexpr int kBatchSilenceMs = 300;
+static constexpr int kBatchSearchStepMs = 100;
+static constexpr int kBatchOverlapMs = 1000;
+// Threads per worker when the caller leaves the worker count to the stream.
+static constexpr int kBatchThreadsPerWorker = 4;
+
+// Speech gate (see whisper_stream_set_speech_gate): frames match Silero's
+// 512-sample hop at 16 kHz; a window needs kGateMinSpeechMs of speech frames
+// to be decoded, keeps kGateSpeechPadMs before its first one, and is only
+// trimmed when that drops at least kGateMinTrimMs.
+static constexpr int kGateFrameSamples = 512;
+static constexpr int kGateMinSpeechMs = 250;
+static constexpr int kGateSpeechPadMs = 300;
+static constexpr int kGateMinTrimMs = 1000;
+static constexpr float kGateSileroThreshold = 0.5f;
+static constexpr float kGateEnergyThreshold = 0.01f;
+
+// Repetition guard (see whisper_stream_set_repetition_guard): a loop is an
+// n-gram of up to kLoopMaxNgram text tokens repeated back to back, spanning
+// at least kLoopMinTokens; the check looks at the newest kLoopScanTokens.
+static constexpr int kLoopMaxNgram = 6;
+static constexpr int kLoopMinTokens = 8;
+static constexpr int kLoopScanTokens = 96;
+static constexpr int kDefaultLoopRepeats = 4;
+static constexpr int kMaxLoopRepeats = kLoopScanTokens / kLoopMaxNgram;
+
+// Language cache (see whisper_stream_set_language_cache): auto-detect streams
+// pin the language once kDefaultLangPinWindows windows in a row detect it
+// with at least kDefaultLangMinProbability, detect again every
+// kDefaultLangRecheckWindows pinned windows, and drop the pin after a window
+// that decodes under kLangDropConfidence.
+static constexpr int kDefaultLangPinWindows = 2;
+static constexpr int kDefaultLangRecheckWindows = 20;
+static constexpr float kDefaultLangMinProbability = 0.8f;
+static constexpr float kLangDropConfidence = 0.4f;
 
 struct StreamDeleter {
     void operator()(whisper_context *ctx) const noexcept {
@@ -25,29 +111,588 @@ struct StreamDeleter {
             whisper_free(ctx);
         }
     }
+    void operator()(FILE *f) const noexcept {
+        if (f != nullptr) {
+            std::fclose(f);
+        }
+    }
 };
 
-struct whisper_stream {
+// Cached whisper_token_to_str / is_text_token result for one vocab id.
+struct token_entry {
+    const char *piece = nullptr;
+    uint32_t length = 0;
+    bool text = false;
+};
+
+// Model weights shared by every stream created from the same model handle.
+// The context is loaded without a default state; each stream draws its own
+// whisper_state from the pool so decoding can run concurrently.
+struct stream_model {
     std::unique_ptr<whisper_context, StreamDeleter> ctx;
+
+    std::mutex pool_mu;
+    std::vector<whisper_state *> idle_states;
+
+    // See whisper_stream_model_get_info.
+    whisper_stream_model_info info{};
+
+    // Mel filterbank read from the model file ([n_mel][kMelBins]); empty when
+    // the file layout was not recognised, which disables the mel cache.
+    std::vector<float> mel_filters;
+    int n_mel = 0;
+
+    // Indexed by token id; see build_token_table.
+    std::vector<token_entry> tokens;
+
+    // Silero VAD contexts for speech gating, created from vad_path on demand;
+    // see whisper_stream_model_load_vad.
+    std::string vad_path;
+    whisper_vad_context_params vad_params{};
+    std::vector<whisper_vad_context *> idle_vads;
+
+    const token_entry *token(whisper_token id) const {
+        if (id < 0 || static_cast<size_t>(id) >= tokens.size()) {
+            return nullptr;
+        }
+        return &tokens[static_cast<size_t>(id)];
+    }
+
+    ~stream_model() {
+        for (whisper_state *state : idle_states) {
+            whisper_free_state(state);
+        }
+        for (whisper_vad_context *vad : idle_vads) {
+            whisper_vad_free(vad);
+        }
+    }
+
+    whisper_vad_context *acquire_vad() {
+        std::string path;
+        whisper_vad_context_params params;
+        {
+            std::lock_guard<std::mutex> lock(pool_mu);
+            if (!idle_vads.empty()) {
+                whisper_vad_context *vad = idle_vads.back();
+                idle_vads.pop_back();
+                return vad;
+            }
+            path = vad_path;
+            params = vad_params;
+        }
+        if (path.empty()) {
+            return nullptr;
+        }
+        return whisper_vad_init_from_file_with_params(path.c_str(), params);
+    }
+
+    void release_vad(whisper_vad_context *vad) {
+        if (vad == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(pool_mu);
+        idle_vads.push_back(vad);
+    }
+
+    whisper_state *acquire_state() {
+        {
+            std::lock_guard<std::mutex> lock(pool_mu);
+            if (!idle_states.empty()) {
+                whisper_state *state = idle_states.back();
+                idle_states.pop_back();
+                return state;
+            }
+        }
+        return whisper_init_state(ctx.get());
+    }
+
+    void release_state(whisper_state *state) {
+        if (state == nullptr) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(pool_mu);
+        idle_states.push_back(state);
+    }
+};
+
+struct whisper_stream_model {
+    std::shared_ptr<stream_model> shared;
+};
+
+// Coefficient of the single-pole filter used by high_pass_filter.
+static float high_pass_alpha(float cutoff, float sample_rate) {
+    const float rc = 1.0f / (2.0f * kPi * cutoff);
+    const float dt = 1.0f / sample_rate;
+    return dt / (rc + dt);
+}
+
+// Sum of |x[i]| over n samples, vectorised where the target allows.
+static double abs_sum(const float *x, int n) {
+    int i = 0;
+    double total = 0.0;
+#if defined(__AVX2__)
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_add_ps(acc0, _mm256_andnot_ps(sign, _mm256_loadu_ps(x + i)));
+        acc1 = _mm256_add_ps(acc1, _mm256_andnot_ps(sign, _mm256_loadu_ps(x + i + 8)));
+    }
+    acc0 = _mm256_add_ps(acc0, acc1);
+    __m128 acc = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    total = _mm_cvtss_f32(acc);
+#elif defined(__SSE2__)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_andnot_ps(sign, _mm_loadu_ps(x + i)));
+        acc1 = _mm_add_ps(acc1, _mm_andnot_ps(sign, _mm_loadu_ps(x + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    total = _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vaddq_f32(acc0, vabsq_f32(vld1q_f32(x + i)));
+        acc1 = vaddq_f32(acc1, vabsq_f32(vld1q_f32(x + i + 4)));
+    }
+    total = vaddvq_f32(vaddq_f32(acc0, acc1));
+#endif
+    for (; i < n; ++i) {
+        total += std::fabs(x[i]);
+    }
+    return total;
+}
+
+// Converts little-endian int16 PCM to float32 in [-1, 1], matching the scale
+// the Go side used (1/32767). samples need not be 2-byte aligned.
+static void s16_to_f32(const int16_t *samples, float *out, size_t n) {
+    const unsigned char *in = reinterpret_cast<const unsigned char *>(samples);
+    const float scale = 1.0f / 32767.0f;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256 vscale = _mm256_set1_ps(scale);
+    for (; i + 16 <= n; i += 16) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i * 2));
+        const __m256i lo = _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v));
+        const __m256i hi = _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(lo), vscale));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(hi), vscale));
+    }
+#elif defined(__SSE2__)
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 2));
+        // Duplicate each lane into the high half, then arithmetic shift to sign-extend.
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    for (; i + 8 <= n; i += 8) {
+        const int16x8_t v = vreinterpretq_s16_u8(vld1q_u8(in + i * 2));
+        const float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+        const float32x4_t hi = vcvtq_f32_s32(vmovl_high_s16(v));
+        vst1q_f32(out + i, vmulq_n_f32(lo, scale));
+        vst1q_f32(out + i + 4, vmulq_n_f32(hi, scale));
+    }
+#endif
+    for (; i < n; ++i) {
+        int16_t v;
+        std::memcpy(&v, in + i * 2, sizeof(v));
+        out[i] = static_cast<float>(v) * scale;
+    }
+}
+
+// Streaming form of vad_detect_silence over the trailing VAD window.
+// high_pass_filter reads back its own output as the previous input, so past
+// the window's first sample it reduces to scaling by alpha; the tracker
+// therefore stores plain magnitudes once per sample and applies the filter
+// gain at decision time. Running sums over the whole window and its last
+// n_last samples are updated per block and re-summed whenever the history
+// wraps, which bounds floating-point drift at O(1) amortised cost.
+struct vad_tracker {
+    int n_window = 0;
+    int n_last = 0;
+    float gain = 1.0f;
+
+    std::vector<float> magnitude;  // circular, |x| of the last n_window samples
+    int pos = 0;
+    int64_t seen = 0;
+    double sum_all = 0.0;
+    double sum_last = 0.0;
+
+    void init(int window_samples, int last_samples, float freq_thold, int sample_rate) {
+        n_window = window_samples;
+        n_last = last_samples;
+        gain = freq_thold > 0.0f ? high_pass_alpha(freq_thold, static_cast<float>(sample_rate)) : 1.0f;
+        magnitude.assign(n_window > 0 ? static_cast<size_t>(n_window) : 0, 0.0f);
+        reset();
+    }
+
+    bool enabled() const { return n_window > 0 && n_last > 0 && n_last < n_window; }
+
+    void reset() {
+        std::fill(magnitude.begin(), magnitude.end(), 0.0f);
+        pos = 0;
+        seen = 0;
+        sum_all = 0.0;
+        sum_last = 0.0;
+    }
+
+    void push(const float *x, int n) {
+        if (!enabled()) {
+            return;
+        }
+        while (n > 0) {
+            // Keep the range leaving the last-n_last window disjoint from the
+            // slots being overwritten.
+            const int m = std::min({n, n_window - pos, n_last, n_window - n_last});
+
+            sum_all -= abs_sum(magnitude.data() + pos, m);
+            sum_last -= circular_sum(pos - n_last, m);
+
+            float *out = magnitude.data() + pos;
+            for (int i = 0; i < m; ++i) {
+                out[i] = std::fabs(x[i]);
+            }
+            const double added = abs_sum(x, m);
+            sum_all += added;
+            sum_last += added;
+
+            pos += m;
+            seen += m;
+            x += m;
+            n -= m;
+
+            if (pos == n_window) {
+                pos = 0;
+                sum_all = abs_sum(magnitude.data(), n_window);
+                sum_last = abs_sum(magnitude.data() + n_window - n_last, n_last);
+            }
+        }
+    }
+
+    // Same decision as vad_detect_silence over the last n_window samples.
+    bool silent(float vad_thold) const { return silent_tail(n_last, vad_thold); }
+
+    // The same decision for a trailing span of k samples (0 < k < n_window)
+    // instead of n_last; spans other than n_last are summed on demand.
+    bool silent_tail(int k, float vad_thold) const {
+        if (!enabled() || seen < n_window || k <= 0 || k >= n_window) {
+            return false;
+        }
+
+        // The filter leaves the window's first sample (the oldest slot) unscaled.
+        const double first = magnitude[pos];
+        const double energy_all = (first + gain * (sum_all - first)) / static_cast<double>(n_window);
+        const double tail = k == n_last ? sum_last : circular_sum(pos - k, k);
+        const double energy_last = gain * tail / static_cast<double>(k);
+        return energy_last <= vad_thold * energy_all;
+    }
+
+private:
+    double circular_sum(int start, int m) const {
+        if (start < 0) {
+            start += n_window;
+        }
+        const int first = std::min(m, n_window - start);
+        double total = abs_sum(magnitude.data() + start, first);
+        if (first < m) {
+            total += abs_sum(magnitude.data(), m - first);
+        }
+        return total;
+    }
+};
+
+// Contiguous audio buffer with O(1) front drops. The live region slides
+// forward through preallocated storage and is memmoved back to the start only
+// when an append would run past the end, so inference always reads a linear
+// view and steady-state streaming neither allocates nor shifts the window.
+class audio_ring {
+public:
+    void reserve(size_t capacity) {
+        if (capacity > storage_.size()) {
+            compact();
+            storage_.resize(capacity);
+        }
+    }
+
+    size_t size() const { return end_ - begin_; }
+    bool empty() const { return end_ == begin_; }
+
+    const float *data() const { return storage_.data() + begin_; }
+
+    // Absolute index, in samples appended since creation, of data()[0].
+    int64_t begin_position() const { return written_ - static_cast<int64_t>(size()); }
+    int64_t end_position() const { return written_; }
+
+    // Pointer to the last n samples; n must not exceed size().
+    const float *tail(size_t n) const { return storage_.data() + end_ - n; }
+
+    void append(const float *samples, size_t n) {
+        std::memcpy(extend(n), samples, n * sizeof(float));
+    }
+
+    // Converts int16 PCM straight into the ring, skipping any staging buffer.
+    void append_s16(const int16_t *samples, size_t n) {
+        s16_to_f32(samples, extend(n), n);
+    }
+
+    // Drops everything but the most recent n samples.
+    void keep_last(size_t n) {
+        if (n < size()) {
+            begin_ = end_ - n;
+        }
+    }
+
+    void clear() {
+        begin_ = 0;
+        end_ = 0;
+    }
+
+    // Empties the ring and restarts absolute positions at 0, keeping storage.
+    void rewind() {
+        clear();
+        written_ = 0;
+    }
+
+private:
+    // Makes room for n samples at the end and returns where they go.
+    float *extend(size_t n) {
+        if (end_ + n > storage_.size()) {
+            compact();
+            if (end_ + n > storage_.size()) {
+                // Oversized input; grow once rather than fail.
+                storage_.resize(std::max(storage_.size() * 2, end_ + n));
+            }
+        }
+        float *dst = storage_.data() + end_;
+        end_ += n;
+        written_ += static_cast<int64_t>(n);
+        return dst;
+    }
+
+    void compact() {
+        if (begin_ == 0) {
+            return;
+        }
+        const size_t live = size();
+        if (live > 0) {
+            std::memmove(storage_.data(), storage_.data() + begin_, live * sizeof(float));
+        }
+        begin_ = 0;
+        end_ = live;
+    }
+
+    std::vector<float> storage_;
+    size_t begin_ = 0;
+    size_t end_ = 0;
+    int64_t written_ = 0;
+};
+
+// Log-mel frames of the sliding window kept between ticks; see compute_window_mel.
+struct mel_cache {
+    bool enabled = false;
+
+    // Raw log10 frames, frame-major, for absolute hops [first_frame, first_frame + n_frames).
+    std::vector<float> frames;
+    int64_t first_frame = 0;
+    int n_frames = 0;
+
+    std::vector<float> window; // raw frames of the current window, frame-major
+    std::vector<float> input;  // normalised mel handed to whisper, mel-major
+
+    float fft_in[kMelFrameSize];
+    float fft_out[2 * kMelFrameSize];
+    float fft_work[6 * kMelFrameSize];
+
+    whisper_stream_mel_stats stats{};
+};
+
+enum pass_phase {
+    kPhaseMel,
+    kPhaseEncode,
+    kPhaseDecode,
+};
+
+// Splits the wall time of one whisper_full call into stages from inside its
+// callbacks. The logits filter may run on several decoder threads at once.
+struct pass_probe {
+    std::atomic<int> phase{kPhaseMel};
+    std::atomic<int64_t> mark_us{0};
+    std::atomic<uint64_t> stage_us[3] = {};
+
+    // A decoder restarting at token 0 after tokens were seen for the same
+    // segment is a temperature fallback.
+    std::atomic<bool> saw_tokens{false};
+    std::atomic<uint64_t> fallbacks{0};
+
+    // Decoders the repetition guard cut short.
+    std::atomic<uint64_t> loop_cutoffs{0};
+};
+
+// Hidden header in front of every whisper_stream_result, telling
+// whisper_stream_free_result whether the block belongs to the stream.
+struct alignas(std::max_align_t) result_block {
+    bool stream_owned;
+};
+
+// Token behind emitted text; times are stream-absolute milliseconds.
+struct detail_token {
+    whisper_token id = 0;
+    float p = 0.0f;
+    int64_t t0_ms = WHISPER_STREAM_NO_TIMESTAMP;
+    int64_t t1_ms = WHISPER_STREAM_NO_TIMESTAMP;
+    int64_t dtw_ms = WHISPER_STREAM_NO_TIMESTAMP;
+};
+
+// A segment covering tokens [first_token, first_token + n_tokens) of the
+// token list it is stored with.
+struct detail_segment {
+    int64_t t0_ms = 0;
+    int64_t t1_ms = 0;
+    size_t first_token = 0;
+    size_t n_tokens = 0;
+};
+
+// Segments and tokens describing a piece of emitted text; serialised by
+// build_result.
+struct result_details {
+    std::vector<detail_segment> segments;
+    std::vector<detail_token> tokens;
+
+    void clear() {
+        segments.clear();
+        tokens.clear();
+    }
+
+    void append(const result_details &other) {
+        const size_t offset = tokens.size();
+        tokens.insert(tokens.end(), other.tokens.begin(), other.tokens.end());
+        for (detail_segment segment : other.segments) {
+            segment.first_token += offset;
+            segments.push_back(segment);
+        }
+    }
+};
+
+// The draft tier: a smaller model that decodes the live audio between full
+// passes for fast, unstable partials. It reads the stream's audio ring and,
+// when both models use the same mel bins, its cached spectrogram.
+struct draft_decoder {
+    std::shared_ptr<stream_model> model;
+    whisper_state *state = nullptr;
+    bool shares_mel = false;
+    int n_samples_interval = 0;
+    int n_samples_since = 0; // appended since the last pass of either tier
+    std::vector<whisper_token> text_tokens;
+    std::string text; // last partial returned
+
+    ~draft_decoder() {
+        if (model != nullptr) {
+            model->release_state(state);
+        }
+    }
+};
+
+// Decides which sliding windows reach whisper_full; see gate_window.
+struct speech_gate {
+    int kind = WHISPER_STREAM_SPEECH_GATE_OFF;
+    float threshold = 0.0f;
+    whisper_vad_context *vad = nullptr;  // Silero, borrowed from the model pool
+    std::vector<float> levels;           // energy gate: mean |x| per frame
+};
+
+// When a VAD-mode utterance ends; see whisper_stream_set_endpointing.
+struct endpointing {
+    int silence_ms = kVadLastMs;
+    int min_silence_ms = kVadLastMs; // reached once the utterance lasts adapt_ms
+    int adapt_ms = 0;                // 0 keeps silence_ms throughout
+    bool speculative = false;
+
+    // A speculative pass whose text sits in last_window and the current_*
+    // vectors until the endpoint keeps it or speech resumes.
+    bool pending = false;
+    int64_t end_position = 0; // audio.end_position() when it ran
+    int tail_samples = 0;     // trailing silence it was started on
+    float confidence = 0.0f;
+};
+
+// Auto-detected language of a stream; see window_language.
+struct language_cache {
+    int pin_windows = kDefaultLangPinWindows; // 0 detects on every window
+    int recheck_windows = kDefaultLangRecheckWindows;
+    float min_probability = kDefaultLangMinProbability;
+
+    int lang_id = -1;   // pinned language, -1 while detecting
+    int candidate = -1; // language of the latest confident detection
+    int streak = 0;     // consecutive confident detections of candidate
+    int since_check = 0; // pinned windows since the last detection
+    float probability = 0.0f;
+    std::vector<float> probs;
+
+    void reset() {
+        lang_id = -1;
+        candidate = -1;
+        streak = 0;
+        since_check = 0;
+        probability = 0.0f;
+    }
+};
+
+struct whisper_stream {
+    std::shared_ptr<stream_model> model;
+    whisper_state *state = nullptr;
     whisper_full_params params;
 
-    std::vector<float> pcmf32_new;
-    std::vector<float> pcmf32;
-    std::vector<float> pcmf32_old;
-    std::vector<float> pcmf32_vad;
+    whisper_context *ctx() const { return model->ctx.get(); }
+
+    ~whisper_stream() {
+        if (model != nullptr) {
+            model->release_state(state);
+            model->release_vad(gate.vad);
+        }
+    }
+
+    // Sliding mode: the previous window followed by n_samples_pending new samples.
+    // VAD mode: the speech accumulated since the last transcription.
+    audio_ring audio;
+    int n_samples_pending = 0;
+    vad_tracker vad;
+    mel_cache mel;
 
     std::string language_hint;
     bool detect_language = true;
+    language_cache lang;
+
+    speech_gate gate;
 
     std::string last_window;
     std::string transcript;
     float last_confidence = 0.0f;
 
+    // Text of the current entry-point call; reused so steady-state calls do
+    // not allocate. result_arena backs *_ex results when reuse_results is set.
+    std::string output;
+    std::vector<result_block> result_arena;
+    bool reuse_results = false;
+
+    // See whisper_stream_set_draft_model.
+    std::unique_ptr<draft_decoder> draft;
+
     int n_samples_step = 0;
     int n_samples_len = 0;
     int n_samples_keep = 0;
     int vad_window_samples = 0;
-    int vad_last_ms = kVadLastMs;
+    endpointing endpoint;
 
     // Iteration tracking for n_new_line mechanism
     int n_iter = 0;
@@ -55,6 +700,22 @@ struct whisper_stream {
 
     bool keep_context = false;
     bool use_vad = false;
+
+    // Adaptive encoder context; see adaptive_audio_ctx.
+    bool audio_ctx_auto = false;
+    float audio_ctx_min_confidence = kDefaultAudioCtxMinConfidence;
+
+    // Greedy-first decoding; see whisper_stream_set_adaptive_beam.
+    bool beam_adaptive = false;
+    float beam_min_confidence = kDefaultBeamMinConfidence;
+
+    // Cap on the decoders a pass may run; 0 leaves whisper's defaults. See
+    // whisper_stream_set_max_decoders.
+    int max_decoders = 0;
+
+    // Repeats that end a decoder's segment; 0 disables the guard.
+    int loop_repeats = kDefaultLoopRepeats;
+
     float vad_thold = 0.6f;
     float freq_thold = 100.0f;
 
@@ -62,8 +723,263 @@ struct whisper_stream {
     std::vector<whisper_token> current_tokens;
     std::vector<whisper_token> current_text_tokens;
     std::vector<whisper_token> previous_text_tokens;
+    std::vector<size_t> overlap_failure; // scratch for find_common_prefix
+
+    // Timing of the last pass: details parallel to current_text_tokens and
+    // the pass's segments over them.
+    std::vector<detail_token> current_text_details;
+    std::vector<detail_segment> current_segments;
+    int64_t window_start_ms = 0;
+
+    // emitted describes the text returned by the current call;
+    // transcript_details describes transcript.
+    result_details emitted;
+    result_details transcript_details;
+
+    // Abort probe installed for the duration of a single process/flush call.
+    whisper_stream_abort_callback abort_callback = nullptr;
+    void *abort_user_data = nullptr;
+    std::atomic<bool> aborted{false};
+    std::atomic<int64_t> abort_next_poll_us{0};
+
+    // CPUs inference passes are pinned to; empty leaves affinity alone. See
+    // whisper_stream_set_threads.
+    std::vector<int> cpu_affinity;
+
+    // See whisper_stream_get_stats. pending_stages collects work until the
+    // next inference pass claims it as stats.last.
+    whisper_stream_stats stats{};
+    whisper_stream_stage_us pending_stages{};
+    pass_probe probe;
+};
+
+// Installs the caller's abort probe on the stream and clears it on scope exit.
+struct abort_scope {
+    whisper_stream *stream;
+
+    abort_scope(whisper_stream *s, whisper_stream_abort_callback callback, void *user_data)
+        : stream(s) {
+        stream->abort_callback = callback;
+        stream->abort_user_data = user_data;
+        stream->aborted.store(false, std::memory_order_relaxed);
+        stream->abort_next_poll_us.store(0, std::memory_order_relaxed);
+    }
+
+    ~abort_scope() {
+        stream->abort_callback = nullptr;
+        stream->abort_user_data = nullptr;
+    }
+};
+
+// Pins the calling thread to the stream's CPUs for one inference call. Without
+// OpenMP, ggml starts its compute workers from this thread for every graph, so
+// they inherit the mask; the caller's previous mask is restored on scope exit
+// because the thread belongs to the Go runtime. OpenMP builds keep a
+// persistent worker pool per calling thread that ignores later masks, which
+// is why whisper_stream_cpu_pinning_supported reports them as unsupported.
+struct cpu_pin_scope {
+#if WHISPER_STREAM_HAVE_AFFINITY
+    cpu_set_t previous;
+    bool pinned = false;
+
+    explicit cpu_pin_scope(const whisper_stream *stream) {
+        if (stream->cpu_affinity.empty() ||
+            pthread_getaffinity_np(pthread_self(), sizeof(previous), &previous) != 0) {
+            return;
+        }
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (const int cpu : stream->cpu_affinity) {
+            if (cpu >= 0 && cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &mask);
+            }
+        }
+        pinned = CPU_COUNT(&mask) > 0 &&
+            pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+    }
+
+    ~cpu_pin_scope() {
+        if (pinned) {
+            pthread_setaffinity_np(pthread_self(), sizeof(previous), &previous);
+        }
+    }
+#else
+    explicit cpu_pin_scope(const whisper_stream *) {}
+#endif
+
+    cpu_pin_scope(const cpu_pin_scope &) = delete;
+    cpu_pin_scope &operator=(const cpu_pin_scope &) = delete;
 };
 
+static int64_t steady_now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool poll_abort(whisper_stream *stream) {
+    if (stream->aborted.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    if (stream->abort_callback == nullptr) {
+        return false;
+    }
+    if (stream->abort_callback(stream->abort_user_data)) {
+        stream->aborted.store(true, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+// ggml_abort_callback: invoked from compute threads, possibly concurrently.
+// Only one thread polls per interval; the result is latched once aborted.
+static bool stream_abort_callback(void *user_data) {
+    auto *stream = static_cast<whisper_stream *>(user_data);
+    if (stream->aborted.load(std::memory_order_relaxed)) {
+        return true;
+    }
+
+    const int64_t now = steady_now_us();
+    int64_t next = stream->abort_next_poll_us.load(std::memory_order_relaxed);
+    if (now < next ||
+        !stream->abort_next_poll_us.compare_exchange_strong(next, now + kAbortPollIntervalUs,
+                                                            std::memory_order_relaxed)) {
+        return false;
+    }
+    return poll_abort(stream);
+}
+
+static uint64_t elapsed_us(int64_t since_us) {
+    return static_cast<uint64_t>(std::max<int64_t>(0, steady_now_us() - since_us));
+}
+
+// Charges the time since since_us to one stage of the running totals and of
+// the next inference pass.
+static void record_stage(whisper_stream *stream, uint64_t whisper_stream_stage_us::*stage, int64_t since_us) {
+    const uint64_t us = elapsed_us(since_us);
+    stream->stats.total.*stage += us;
+    stream->pending_stages.*stage += us;
+}
+
+// Charges the time since the probe's last mark to phase.
+static void probe_charge(pass_probe &probe, int phase, int64_t now_us) {
+    const int64_t since = probe.mark_us.exchange(now_us, std::memory_order_relaxed);
+    probe.stage_us[phase].fetch_add(static_cast<uint64_t>(std::max<int64_t>(0, now_us - since)),
+                                    std::memory_order_relaxed);
+}
+
+// Closes the probe's current stage at now_us and switches to next.
+static void probe_advance(pass_probe &probe, int next, int64_t now_us) {
+    probe_charge(probe, probe.phase.exchange(next, std::memory_order_relaxed), now_us);
+}
+
+// Runs before each segment's encoder pass, once mel (and language
+// detection) are done.
+static bool stream_encoder_begin_callback(whisper_context *, whisper_state *, void *user_data) {
+    auto *stream = static_cast<whisper_stream *>(user_data);
+    probe_advance(stream->probe, kPhaseEncode, steady_now_us());
+    stream->probe.saw_tokens.store(false, std::memory_order_relaxed);
+    return !poll_abort(stream);
+}
+
+// The guard's repeat count for a requested min_repeats; 0 disables it.
+static int loop_repeats_for(int32_t min_repeats) {
+    return min_repeats <= 0 ? 0 : std::min(std::max(static_cast<int>(min_repeats), 2), kMaxLoopRepeats);
+}
+
+// True when recent (newest first) starts with an n-gram repeated back to
+// back at least min_repeats times and over at least kLoopMinTokens tokens.
+static bool ends_in_loop(const whisper_token *recent, int n, int min_repeats) {
+    for (int ngram = 1; ngram <= kLoopMaxNgram; ++ngram) {
+        const int span = ngram * std::max(min_repeats, (kLoopMinTokens + ngram - 1) / ngram);
+        if (span > n) {
+            continue;
+        }
+        int i = ngram;
+        while (i < span && recent[i] == recent[i - ngram]) {
+            ++i;
+        }
+        if (i == span) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs before every sampled token of every decoder, possibly from several
+// threads at once. Leaves logits untouched unless the decoder is looping, in
+// which case only end-of-text stays sampleable and the segment closes.
+static void stream_logits_filter_callback(whisper_context *ctx,
+                                          whisper_state *,
+                                          const whisper_token_data *tokens,
+                                          int n_tokens,
+                                          float *logits,
+                                          void *user_data) {
+    auto *stream = static_cast<whisper_stream *>(user_data);
+    pass_probe &probe = stream->probe;
+    int phase = kPhaseEncode;
+    if (probe.phase.load(std::memory_order_relaxed) == kPhaseEncode &&
+        probe.phase.compare_exchange_strong(phase, kPhaseDecode, std::memory_order_relaxed)) {
+        // First token of the segment: the encoder and prompt prefill are done.
+        probe_charge(probe, kPhaseEncode, steady_now_us());
+    }
+    if (n_tokens == 0) {
+        if (probe.saw_tokens.exchange(false, std::memory_order_relaxed)) {
+            probe.fallbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else if (!probe.saw_tokens.load(std::memory_order_relaxed)) {
+        probe.saw_tokens.store(true, std::memory_order_relaxed);
+    }
+
+    if (stream->loop_repeats <= 0 || n_tokens < kLoopMinTokens || logits == nullptr) {
+        return;
+    }
+    whisper_token recent[kLoopScanTokens];
+    int n = 0;
+    for (int i = n_tokens; i-- > 0 && n < kLoopScanTokens;) {
+        const token_entry *entry = stream->model->token(tokens[i].id);
+        if (entry != nullptr && entry->text) {
+            recent[n++] = tokens[i].id;
+        }
+    }
+    if (ends_in_loop(recent, n, stream->loop_repeats)) {
+        // Without this the loop runs to the token limit and typically fails
+        // the compression check, costing a fallback pass as well.
+        std::fill(logits, logits + whisper_n_vocab(ctx), -INFINITY);
+        logits[whisper_token_eot(ctx)] = 0.0f;
+        probe.loop_cutoffs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+static void probe_begin(pass_probe &probe) {
+    probe.phase.store(kPhaseMel, std::memory_order_relaxed);
+    probe.mark_us.store(steady_now_us(), std::memory_order_relaxed);
+    for (auto &us : probe.stage_us) {
+        us.store(0, std::memory_order_relaxed);
+    }
+    probe.saw_tokens.store(false, std::memory_order_relaxed);
+    probe.fallbacks.store(0, std::memory_order_relaxed);
+    probe.loop_cutoffs.store(0, std::memory_order_relaxed);
+}
+
+// Folds a finished whisper_full call into the stream's statistics.
+static void probe_end(whisper_stream *stream) {
+    pass_probe &probe = stream->probe;
+    probe_advance(probe, kPhaseMel, steady_now_us());
+
+    const uint64_t mel = probe.stage_us[kPhaseMel].load(std::memory_order_relaxed);
+    const uint64_t encode = probe.stage_us[kPhaseEncode].load(std::memory_order_relaxed);
+    const uint64_t decode = probe.stage_us[kPhaseDecode].load(std::memory_order_relaxed);
+    stream->stats.total.mel += mel;
+    stream->stats.total.encode += encode;
+    stream->stats.total.decode += decode;
+    stream->pending_stages.mel += mel;
+    stream->pending_stages.encode += encode;
+    stream->pending_stages.decode += decode;
+    stream->stats.fallbacks += probe.fallbacks.load(std::memory_order_relaxed);
+    stream->stats.repetition_cutoffs += probe.loop_cutoffs.load(std::memory_order_relaxed);
+    stream->stats.passes++;
+}
+
 static int samples_from_ms(int32_t ms) {
     if (ms <= 0) {
         return 0;
@@ -71,14 +987,61 @@ static int samples_from_ms(int32_t ms) {
     return static_cast<int>(static_cast<int64_t>(kSampleRate) * ms / 1000);
 }
 
+// Runs the speech gate over a sliding window. Returns how many leading
+// samples precede its speech (0 when trimming is not worth it), or -1 when
+// the window holds no speech and inference should be skipped. A Silero
+// failure lets the window through.
+static int gate_window(whisper_stream *stream, const float *pcm, int n) {
+    speech_gate &gate = stream->gate;
+    if (gate.kind == WHISPER_STREAM_SPEECH_GATE_OFF || n <= 0) {
+        return 0;
+    }
+
+    const int64_t start = steady_now_us();
+    const float *levels = nullptr;
+    int n_frames = 0;
+    if (gate.kind == WHISPER_STREAM_SPEECH_GATE_SILERO) {
+        if (gate.vad == nullptr || !whisper_vad_detect_speech(gate.vad, pcm, n)) {
+            record_stage(stream, &whisper_stream_stage_us::vad, start);
+            return 0;
+        }
+        levels = whisper_vad_probs(gate.vad);
+        n_frames = whisper_vad_n_probs(gate.vad);
+    } else {
+        n_frames = n / kGateFrameSamples;
+        gate.levels.resize(static_cast<size_t>(n_frames));
+        for (int f = 0; f < n_frames; ++f) {
+            gate.levels[f] = static_cast<float>(
+                abs_sum(pcm + static_cast<size_t>(f) * kGateFrameSamples, kGateFrameSamples) / kGateFrameSamples);
+        }
+        levels = gate.levels.data();
+    }
+
+    int first = -1;
+    int speech_frames = 0;
+    for (int f = 0; f < n_frames; ++f) {
+        if (levels[f] >= gate.threshold) {
+            if (first < 0) {
+                first = f;
+            }
+            speech_frames++;
+        }
+    }
+    record_stage(stream, &whisper_stream_stage_us::vad, start);
+
+    if (speech_frames * kGateFrameSamples < samples_from_ms(kGateMinSpeechMs)) {
+        return -1;
+    }
+    const int offset = first * kGateFrameSamples - samples_from_ms(kGateSpeechPadMs);
+    return offset >= samples_from_ms(kGateMinTrimMs) ? std::min(offset, n) : 0;
+}
+
 static void high_pass_filter(std::vector<float> &data, float cutoff, float sample_rate) {
     if (data.empty()) {
         return;
     }
 
-    const float rc = 1.0f / (2.0f * kPi * cutoff);
-    const float dt = 1.0f / sample_rate;
-    const float alpha = dt / (rc + dt);
+    const float alpha = high_pass_alpha(cutoff, sample_rate);
 
     float y = data[0];
 
@@ -88,62 +1051,55 @@ static void high_pass_filter(std::vector<float> &data, float cutoff, float sampl
     }
 }
 
-static bool vad_detect_silence(const std::vector<float> &pcm,
+static bool vad_detect_silence(const float *pcm,
+                               int n_samples,
                                int sample_rate,
                                int last_ms,
                                float vad_thold,
                                float freq_thold) {
-    const int n_samples = static_cast<int>(pcm.size());
     const int n_samples_last = (sample_rate * last_ms) / 1000;
 
     if (n_samples == 0 || n_samples_last <= 0 || n_samples_last >= n_samples) {
         return false;
     }
 
-    std::vector<float> data = pcm;
+    std::vector<float> data(pcm, pcm + n_samples);
     if (freq_thold > 0.0f) {
         high_pass_filter(data, freq_thold, static_cast<float>(sample_rate));
     }
 
-    float energy_all = 0.0f;
-    float energy_last = 0.0f;
-    for (int i = 0; i < n_samples; ++i) {
-        energy_all += std::fabs(data[i]);
-        if (i >= n_samples - n_samples_last) {
-            energy_last += std::fabs(data[i]);
-        }
-    }
-
-    energy_all /= static_cast<float>(n_samples);
-    energy_last /= static_cast<float>(n_samples_last);
+    const double energy_all = abs_sum(data.data(), n_samples) / static_cast<double>(n_samples);
+    const double energy_last = abs_sum(data.data() + n_samples - n_samples_last, n_samples_last) /
+                               static_cast<double>(n_samples_last);
 
     return energy_last <= vad_thold * energy_all;
 }
 
-static std::string trim(const std::string &s) {
-    const auto start = s.find_first_not_of(" \t\r\n");
-    if (start == std::string::npos) {
-        return std::string();
-    }
+// Strips surrounding whitespace without reallocating.
+static void trim_in_place(std::string &s) {
     const auto end = s.find_last_not_of(" \t\r\n");
-    return s.substr(start, end - start + 1);
+    if (end == std::string::npos) {
+        s.clear();
+        return;
+    }
+    s.erase(end + 1);
+    s.erase(0, s.find_first_not_of(" \t\r\n"));
 }
 
-static std::string collect_text(whisper_context *ctx, float &confidence_out) {
-    const int n_segments = whisper_full_n_segments(ctx);
+// Writes the pass's trimmed text into text, reusing its capacity.
+static void collect_text(whisper_state *state, std::string &text, float &confidence_out) {
+    text.clear();
+    const int n_segments = whisper_full_n_segments_from_state(state);
     if (n_segments == 0) {
         confidence_out = 0.0f;
-        return {};
+        return;
     }
 
-    std::string text;
-    text.reserve(256);
-
     double prob_sum = 0.0;
     int prob_count = 0;
 
     for (int i = 0; i < n_segments; ++i) {
-        const char *segment = whisper_full_get_segment_text(ctx, i);
+        const char *segment = whisper_full_get_segment_text_from_state(state, i);
         if (segment != nullptr) {
             if (!text.empty()) {
                 text.push_back(' ');
@@ -151,9 +1107,9 @@ static std::string collect_text(whisper_context *ctx, float &confidence_out) {
             text += segment;
         }
 
-        const int tokens = whisper_full_n_tokens(ctx, i);
+        const int tokens = whisper_full_n_tokens_from_state(state, i);
         for (int j = 0; j < tokens; ++j) {
-            const auto data = whisper_full_get_token_data(ctx, i, j);
+            const auto data = whisper_full_get_token_data_from_state(state, i, j);
             if (data.p > 0.0f) {
                 prob_sum += data.p;
                 prob_count += 1;
@@ -162,7 +1118,7 @@ static std::string collect_text(whisper_context *ctx, float &confidence_out) {
     }
 
     confidence_out = prob_count > 0 ? static_cast<float>(prob_sum / prob_count) : 0.0f;
-    return trim(text);
+    trim_in_place(text);
 }
 
 static bool is_text_token(whisper_context *ctx, whisper_token token, const char *piece) {
@@ -194,31 +1150,75 @@ static bool is_text_token(whisper_context *ctx, whisper_token token, const char
     return true;
 }
 
-static void collect_tokens(whisper_stream *stream) {
-    stream->current_tokens.clear();
-    stream->current_text_tokens.clear();
-
-    if (stream == nullptr || stream->ctx == nullptr) {
-        return;
+// Classifies every vocab id once so the per-token loops avoid the string and
+// special-token checks of is_text_token.
+static void build_token_table(stream_model &model) {
+    whisper_context *ctx = model.ctx.get();
+    const int n_vocab = whisper_n_vocab(ctx);
+    model.tokens.assign(static_cast<size_t>(std::max(0, n_vocab)), token_entry{});
+    for (int id = 0; id < n_vocab; ++id) {
+        token_entry &entry = model.tokens[static_cast<size_t>(id)];
+        entry.piece = whisper_token_to_str(ctx, id);
+        if (entry.piece == nullptr) {
+            continue;
+        }
+        entry.length = static_cast<uint32_t>(std::strlen(entry.piece));
+        entry.text = is_text_token(ctx, id, entry.piece);
+    }
+}
+
+// Converts a whisper time in centiseconds from the window start to stream
+// milliseconds.
+static int64_t stream_time_ms(const whisper_stream *stream, int64_t t) {
+    return t < 0 ? WHISPER_STREAM_NO_TIMESTAMP : stream->window_start_ms + t * 10;
+}
+
+static void collect_tokens(whisper_stream *stream) {
+    stream->current_tokens.clear();
+    stream->current_text_tokens.clear();
+    stream->current_text_details.clear();
+    stream->current_segments.clear();
+
+    if (stream == nullptr || stream->state == nullptr) {
+        return;
     }
 
-    whisper_context *ctx = stream->ctx.get();
-    const int n_segments = whisper_full_n_segments(ctx);
+    const stream_model &model = *stream->model;
+    whisper_state *state = stream->state;
+    const int n_segments = whisper_full_n_segments_from_state(state);
     for (int i = 0; i < n_segments; ++i) {
-        const int token_count = whisper_full_n_tokens(ctx, i);
+        detail_segment segment;
+        segment.t0_ms = stream_time_ms(stream, whisper_full_get_segment_t0_from_state(state, i));
+        segment.t1_ms = stream_time_ms(stream, whisper_full_get_segment_t1_from_state(state, i));
+        segment.first_token = stream->current_text_tokens.size();
+
+        const int token_count = whisper_full_n_tokens_from_state(state, i);
         for (int j = 0; j < token_count; ++j) {
-            const whisper_token token = whisper_full_get_token_id(ctx, i, j);
+            const whisper_token token = whisper_full_get_token_id_from_state(state, i, j);
             stream->current_tokens.push_back(token);
 
-            const char *piece = whisper_token_to_str(ctx, token);
-            if (is_text_token(ctx, token, piece)) {
+            const token_entry *entry = model.token(token);
+            if (entry != nullptr && entry->text) {
                 stream->current_text_tokens.push_back(token);
+
+                const whisper_token_data data = whisper_full_get_token_data_from_state(state, i, j);
+                detail_token detail;
+                detail.id = token;
+                detail.p = data.p;
+                detail.t0_ms = stream_time_ms(stream, data.t0);
+                detail.t1_ms = stream_time_ms(stream, data.t1);
+                detail.dtw_ms = stream_time_ms(stream, data.t_dtw);
+                stream->current_text_details.push_back(detail);
             }
         }
+
+        segment.n_tokens = stream->current_text_tokens.size() - segment.first_token;
+        stream->current_segments.push_back(segment);
     }
 
     // Debug: print first few text tokens
 #ifdef WHISPER_DEBUG
+    whisper_context *ctx = stream->ctx();
     fprintf(stderr, "[DEBUG] collect_tokens: total=%zu, text=%zu\n",
             stream->current_tokens.size(), stream->current_text_tokens.size());
     if (!stream->current_text_tokens.empty()) {
@@ -232,95 +1232,97 @@ static void collect_tokens(whisper_stream *stream) {
 #endif
 }
 
-static std::string tokens_to_text(whisper_stream *stream,
-                                  const std::vector<whisper_token> &tokens,
-                                  size_t start_index) {
-    if (stream->ctx == nullptr || start_index >= tokens.size()) {
-        return {};
+// Writes the trimmed text of tokens[start_index..] into text, reusing its
+// capacity.
+static void tokens_to_text(whisper_stream *stream,
+                           const std::vector<whisper_token> &tokens,
+                           size_t start_index,
+                           std::string &text) {
+    text.clear();
+    if (stream->model == nullptr || start_index >= tokens.size()) {
+        return;
     }
 
-    std::string text;
-    text.reserve(tokens.size() * 4);
-
-    whisper_context *ctx = stream->ctx.get();
+    const stream_model &model = *stream->model;
+    size_t length = 0;
     for (size_t i = start_index; i < tokens.size(); ++i) {
-        const char *piece = whisper_token_to_str(ctx, tokens[i]);
-        if (piece != nullptr && is_text_token(ctx, tokens[i], piece)) {
-            text += piece;
+        const token_entry *entry = model.token(tokens[i]);
+        if (entry != nullptr && entry->text) {
+            length += entry->length;
         }
     }
 
-    return trim(text);
-}
-
-static bool has_repetition_loop(const std::vector<whisper_token> &tokens) {
-    if (tokens.size() < 8) {
-        return false;
-    }
-
-    const whisper_token last = tokens.back();
-    int repetition = 0;
-    for (size_t idx = tokens.size(); idx-- > 0 && repetition < 8;) {
-        if (tokens[idx] == last) {
-            repetition++;
-        } else {
-            break;
+    text.reserve(length);
+    for (size_t i = start_index; i < tokens.size(); ++i) {
+        const token_entry *entry = model.token(tokens[i]);
+        if (entry != nullptr && entry->text) {
+            text.append(entry->piece, entry->length);
         }
     }
-
-    return repetition >= 8;
+    trim_in_place(text);
 }
 
-// Find longest common prefix between previous and current token lists
-// Returns the index in current_tokens where new content starts
-static size_t find_common_prefix(const std::vector<whisper_token> &previous,
-                                  const std::vector<whisper_token> &current) {
-    if (previous.empty()) {
-        return 0;  // No previous tokens, everything is new
+// Whether a pass's text tokens still end in a loop, e.g. one the guard is
+// disabled for or that spans segments.
+static bool has_repetition_loop(const whisper_stream *stream, const std::vector<whisper_token> &text_tokens) {
+    whisper_token recent[kLoopScanTokens];
+    int n = 0;
+    for (size_t i = text_tokens.size(); i-- > 0 && n < kLoopScanTokens;) {
+        recent[n++] = text_tokens[i];
     }
+    return ends_in_loop(recent, n, stream->loop_repeats > 0 ? stream->loop_repeats : kDefaultLoopRepeats);
+}
 
-    // Try to find where previous tokens end in current tokens
-    // This handles the case where Whisper "shifts" the window
-    size_t best_match = 0;
-    size_t best_match_len = 0;
+// Find where new content starts in current: the length of the longest prefix
+// of current that previous already contains. This handles the case where
+// Whisper "shifts" the window. Linear in both lengths; see token_overlap.
+static size_t find_common_prefix(whisper_stream *stream,
+                                  const std::vector<whisper_token> &previous,
+                                  const std::vector<whisper_token> &current) {
+    const size_t best_match = token_overlap(previous, current, stream->overlap_failure);
 
 #ifdef WHISPER_DEBUG
-    fprintf(stderr, "[DEBUG] find_common_prefix: searching for overlap\n");
+    fprintf(stderr, "[DEBUG] find_common_prefix: %zu tokens match (new content starts at %zu)\n",
+            best_match, best_match);
 #endif
 
-    // Look for the longest suffix of previous that matches a prefix of current
-    for (size_t i = 0; i < previous.size(); ++i) {
-        size_t match_len = 0;
-        while (i + match_len < previous.size() &&
-               match_len < current.size() &&
-               previous[i + match_len] == current[match_len]) {
-            match_len++;
-        }
-        if (match_len > best_match_len) {
-            best_match_len = match_len;
-            best_match = match_len;
-#ifdef WHISPER_DEBUG
-            fprintf(stderr, "[DEBUG]   suffix at pos %zu: %zu tokens match\n", i, match_len);
-#endif
-        }
-    }
+    return best_match;
+}
 
-#ifdef WHISPER_DEBUG
-    fprintf(stderr, "[DEBUG]   best match: %zu tokens (new content starts at %zu)\n",
-            best_match_len, best_match);
-#endif
+// Appends the last pass's text tokens from first_text_token on to out,
+// grouped by segment. A segment entered part-way starts at its first kept
+// token when token timestamps are available.
+static void append_pass_details(whisper_stream *stream, size_t first_text_token, result_details &out) {
+    const auto &tokens = stream->current_text_details;
+    for (const detail_segment &segment : stream->current_segments) {
+        const size_t end = segment.first_token + segment.n_tokens;
+        const size_t start = std::max(segment.first_token, first_text_token);
+        if (start >= end || end > tokens.size()) {
+            continue;
+        }
 
-    return best_match;
+        detail_segment part = segment;
+        if (start != segment.first_token && tokens[start].t0_ms != WHISPER_STREAM_NO_TIMESTAMP) {
+            part.t0_ms = tokens[start].t0_ms;
+        }
+        part.first_token = out.tokens.size();
+        part.n_tokens = end - start;
+        out.tokens.insert(out.tokens.end(), tokens.begin() + static_cast<std::ptrdiff_t>(start),
+                          tokens.begin() + static_cast<std::ptrdiff_t>(end));
+        out.segments.push_back(part);
+    }
 }
 
-static std::string extract_new_text(whisper_stream *stream, bool &reset_transcript) {
+// Writes the text the last pass added over the previous one into text.
+static void extract_new_text(whisper_stream *stream, bool &reset_transcript, std::string &text) {
     reset_transcript = false;
+    text.clear();
 
     const auto &current = stream->current_text_tokens;
     const auto &previous = stream->previous_text_tokens;
 
     if (current.empty()) {
-        return {};
+        return;
     }
 
 #ifdef WHISPER_DEBUG
@@ -328,8 +1330,8 @@ static std::string extract_new_text(whisper_stream *stream, bool &reset_transcri
             previous.size(), current.size());
 
     // Debug: show last few previous tokens and first few current tokens
-    if (!previous.empty() && stream->ctx) {
-        whisper_context *ctx = stream->ctx.get();
+    if (!previous.empty() && stream->model) {
+        whisper_context *ctx = stream->ctx();
         fprintf(stderr, "[DEBUG]   Last 5 prev tokens: ");
         for (size_t i = previous.size() > 5 ? previous.size() - 5 : 0; i < previous.size(); ++i) {
             const char *piece = whisper_token_to_str(ctx, previous[i]);
@@ -347,7 +1349,7 @@ static std::string extract_new_text(whisper_stream *stream, bool &reset_transcri
 #endif
 
     // Find where new content starts (after common prefix with previous window)
-    const size_t new_start = find_common_prefix(previous, current);
+    const size_t new_start = find_common_prefix(stream, previous, current);
 
 #ifdef WHISPER_DEBUG
     fprintf(stderr, "[DEBUG]   Result: common_prefix=%zu\n", new_start);
@@ -358,29 +1360,36 @@ static std::string extract_new_text(whisper_stream *stream, bool &reset_transcri
 #ifdef WHISPER_DEBUG
         fprintf(stderr, "[DEBUG] No new content (entire window is repeat)\n");
 #endif
-        return {};
+        return;
     }
 
     // Extract text from the new tokens
-    const std::string text = tokens_to_text(stream, current, new_start);
+    tokens_to_text(stream, current, new_start, text);
 
 #ifdef WHISPER_DEBUG
     fprintf(stderr, "[DEBUG] New text: '%s'\n", text.c_str());
 #endif
 
-    // Remember current tokens for next comparison
-    stream->previous_text_tokens = current;
+    if (!text.empty()) {
+        append_pass_details(stream, new_start, stream->emitted);
+    }
 
-    return text;
+    // Remember current tokens for next comparison. Swapping hands the old
+    // buffer to collect_tokens for reuse; current_text_tokens is rebuilt by
+    // the next pass, and emptying it keeps a flush without one from
+    // re-emitting text.
+    stream->previous_text_tokens.swap(stream->current_text_tokens);
+    stream->current_text_tokens.clear();
 }
 static whisper_full_params prepare_params(whisper_stream *stream) {
     whisper_full_params params = stream->params;
+    // detect_language alone stops whisper_full after detection; a null
+    // language detects and then transcribes.
+    params.detect_language = false;
     if (stream->detect_language || stream->language_hint.empty()) {
         params.language = nullptr;
-        params.detect_language = true;
     } else {
         params.language = stream->language_hint.c_str();
-        params.detect_language = false;
     }
 
     // Pass prompt tokens from previous segment
@@ -401,397 +1410,2139 @@ static whisper_full_params prepare_params(whisper_stream *stream) {
     return params;
 }
 
-static int run_inference(whisper_stream *stream,
-                         const float *data,
-                         int n_samples,
-                         std::string &out_text,
-                         float &out_conf) {
-    whisper_full_params params = prepare_params(stream);
-    if (whisper_full(stream->ctx.get(), params, data, n_samples) != 0) {
-        return -2;
+// Decoders whisper_full allocates for params: beam search keeps
+// max(best_of, beam_size) candidates, greedy sampling best_of.
+static int pass_decoders(const whisper_full_params &params) {
+    int n = params.greedy.best_of;
+    if (params.strategy == WHISPER_SAMPLING_BEAM_SEARCH) {
+        n = std::max(n, params.beam_search.beam_size);
     }
-
-    out_text = collect_text(stream->ctx.get(), out_conf);
-    stream->last_confidence = out_conf;
-
-    collect_tokens(stream);
-
-    // NOTE: Prompt tokens are updated in whisper_stream_process(),
-    // synchronized with buffer reset every n_new_line iterations
-
-    return 0;
+    return std::max(n, 1);
 }
 
-static bool should_trigger_vad(whisper_stream *stream) {
-    if (stream->vad_window_samples <= 0 ||
-        static_cast<int>(stream->pcmf32_vad.size()) < stream->vad_window_samples) {
-        return false;
+// whisper_full sizes its text KV cache for every decoder it allocates, even
+// though best_of candidates are only sampled on temperature fallback. Without
+// fallback a single greedy candidate is all a pass can use; max_decoders (0 =
+// none) caps the fallback candidates too.
+static void fit_decoders(whisper_full_params &params, int max_decoders) {
+    if (params.temperature <= 0.0f && params.temperature_inc <= 0.0f) {
+        params.greedy.best_of = 1;
+    }
+    if (max_decoders > 0 && params.greedy.best_of > max_decoders) {
+        params.greedy.best_of = max_decoders;
     }
+}
 
-    const auto begin = stream->pcmf32_vad.end() - stream->vad_window_samples;
-    std::vector<float> chunk(begin, stream->pcmf32_vad.end());
-    return vad_detect_silence(chunk,
-                              kSampleRate,
-                              stream->vad_last_ms,
-                              stream->vad_thold,
-                              stream->freq_thold);
+// Bytes of a KV cache holding n_ctx positions of keys and values for every
+// text layer, in f16 (f32 for f32 models) as whisper.cpp allocates them.
+static uint64_t kv_cache_bytes(whisper_context *ctx, int n_ctx) {
+    const uint64_t element = whisper_model_ftype(ctx) == WHISPER_STREAM_FTYPE_F32 ? 4 : 2;
+    return 2 * element * static_cast<uint64_t>(whisper_model_n_text_layer(ctx)) *
+           static_cast<uint64_t>(whisper_model_n_text_state(ctx)) * static_cast<uint64_t>(n_ctx);
 }
 
-static int transcribe_vad_buffer(whisper_stream *stream,
-                                 char **out_text,
-                                 float *out_confidence) {
-    const int total_samples = static_cast<int>(stream->pcmf32_vad.size());
-    const int take = stream->n_samples_len > 0 ?
-        std::min(stream->n_samples_len, total_samples) : total_samples;
+// whisper_full reallocates the text KV cache on every pass: n_text_ctx padded
+// to 256 positions, times decoders + 2 when more than one decoder runs.
+static uint64_t kv_self_bytes(whisper_context *ctx, int decoders) {
+    const int n_ctx = (whisper_n_text_ctx(ctx) + 255) / 256 * 256;
+    return kv_cache_bytes(ctx, n_ctx * (decoders > 1 ? decoders + 2 : 1));
+}
 
-    if (take <= 0) {
-        stream->pcmf32_vad.clear();
-        return 0;
+// Sin/cos table and periodic Hann window for kMelFrameSize-point frames,
+// built the same way as whisper.cpp's global cache.
+struct mel_tables {
+    float sin_vals[kMelFrameSize];
+    float cos_vals[kMelFrameSize];
+    float hann[kMelFrameSize];
+
+    mel_tables() {
+        for (int i = 0; i < kMelFrameSize; ++i) {
+            const double theta = (2.0 * M_PI * i) / kMelFrameSize;
+            sin_vals[i] = sinf(theta);
+            cos_vals[i] = cosf(theta);
+            hann[i] = 0.5 * (1.0 - cosf((2.0 * M_PI * i) / kMelFrameSize));
+        }
     }
+};
 
-    stream->pcmf32.assign(stream->pcmf32_vad.end() - take, stream->pcmf32_vad.end());
-    stream->pcmf32_vad.clear();
+static const mel_tables &get_mel_tables() {
+    static const mel_tables tables;
+    return tables;
+}
 
-    std::string full_text;
-    float confidence = 0.0f;
-    if (run_inference(stream,
-                      stream->pcmf32.data(),
-                      static_cast<int>(stream->pcmf32.size()),
-                      full_text,
-                      confidence) != 0) {
-        return -2;
+static void mel_dft(const float *in, int n, float *out) {
+    const mel_tables &t = get_mel_tables();
+    const int step = kMelFrameSize / n;
+    for (int k = 0; k < n; ++k) {
+        float re = 0.0f;
+        float im = 0.0f;
+        for (int j = 0; j < n; ++j) {
+            const int idx = (k * j * step) % kMelFrameSize;
+            re += in[j] * t.cos_vals[idx];
+            im -= in[j] * t.sin_vals[idx];
+        }
+        out[2 * k + 0] = re;
+        out[2 * k + 1] = im;
     }
+}
 
-    const std::string trimmed = trim(full_text);
-    stream->last_window = trimmed;
-    stream->last_confidence = confidence;
-
-    if (trimmed.empty()) {
-        return 0;
+// Radix-2 split down to an odd length, then a direct DFT; mirrors whisper.cpp's
+// fft so cached frames match what whisper_pcm_to_mel would produce. out holds
+// n interleaved complex values; work needs 3n floats per recursion level.
+static void mel_fft(const float *in, int n, float *out, float *work) {
+    if (n == 1) {
+        out[0] = in[0];
+        out[1] = 0.0f;
+        return;
     }
-
-    *out_confidence = confidence;
-    *out_text = static_cast<char *>(std::malloc(trimmed.size() + 1));
-    if (*out_text == nullptr) {
-        return -3;
+    const int half = n / 2;
+    if (n - half * 2 == 1) {
+        mel_dft(in, n, out);
+        return;
     }
 
-    std::memcpy(*out_text, trimmed.c_str(), trimmed.size() + 1);
-
-    stream->transcript.clear();
-    stream->prompt_tokens.clear();
-    stream->current_tokens.clear();
-    stream->current_text_tokens.clear();
-    stream->previous_text_tokens.clear();
-    stream->pcmf32.clear();
-    stream->pcmf32_old.clear();
+    float *split = work;
+    float *even_fft = split + half;
+    float *odd_fft = even_fft + n;
+    float *next = odd_fft + n;
 
-    return 1;
+    for (int i = 0; i < half; ++i) {
+        split[i] = in[2 * i];
+    }
+    mel_fft(split, half, even_fft, next);
+    for (int i = 0; i < half; ++i) {
+        split[i] = in[2 * i + 1];
+    }
+    mel_fft(split, half, odd_fft, next);
+
+    const mel_tables &t = get_mel_tables();
+    const int step = kMelFrameSize / n;
+    for (int k = 0; k < half; ++k) {
+        const int idx = k * step;
+        const float re = t.cos_vals[idx];
+        const float im = -t.sin_vals[idx];
+        const float re_odd = odd_fft[2 * k + 0];
+        const float im_odd = odd_fft[2 * k + 1];
+        out[2 * k + 0] = even_fft[2 * k + 0] + re * re_odd - im * im_odd;
+        out[2 * k + 1] = even_fft[2 * k + 1] + re * im_odd + im * re_odd;
+        out[2 * (k + half) + 0] = even_fft[2 * k + 0] - re * re_odd + im * im_odd;
+        out[2 * (k + half) + 1] = even_fft[2 * k + 1] - re * im_odd - im * re_odd;
+    }
 }
 
-extern "C" {
-
-whisper_stream *whisper_stream_create(const char *model_path,
-                                      int32_t step_ms,
-                                      int32_t length_ms,
-                                      int32_t keep_ms,
-                                      int32_t threads,
-                                      bool use_gpu,
-                                      bool flash_attn,
-                                      bool translate,
-                                      float temperature_inc,
-                                      bool disable_fallback,
-                                      int32_t beam_size,
-                                      int32_t audio_ctx,
-                                      bool print_timestamps,
-                                      bool print_special,
-                                      bool keep_context,
-                                      bool use_vad,
-                                      float vad_thold,
-                                      float freq_thold,
-                                      int32_t max_tokens,
-                                      bool tinydiarize) {
-    if (model_path == nullptr) {
-        return nullptr;
+// Computes raw log10 mel frame i of x[0, n) as whisper_pcm_to_mel frames it:
+// 200 samples of reflection padding in front, zeros after the end.
+static void compute_mel_frame(whisper_stream *stream, const float *x, int n, int i, float *dst) {
+    const mel_tables &t = get_mel_tables();
+    mel_cache &mel = stream->mel;
+    const int half = kMelFrameSize / 2;
+    const int offset = i * kMelHop;
+
+    for (int j = 0; j < kMelFrameSize; ++j) {
+        const int k = offset + j;
+        float v = 0.0f;
+        if (k < half) {
+            v = x[half - k];
+        } else if (k - half < n) {
+            v = x[k - half];
+        }
+        mel.fft_in[j] = t.hann[j] * v;
     }
 
-    whisper_context_params cparams = whisper_context_default_params();
-    cparams.use_gpu = use_gpu;
-    cparams.flash_attn = flash_attn;
-
-    auto ctx = whisper_init_from_file_with_params(model_path, cparams);
-    if (ctx == nullptr) {
-        return nullptr;
+    mel_fft(mel.fft_in, kMelFrameSize, mel.fft_out, mel.fft_work);
+    for (int j = 0; j < kMelBins; ++j) {
+        mel.fft_out[j] = mel.fft_out[2 * j + 0] * mel.fft_out[2 * j + 0] +
+                         mel.fft_out[2 * j + 1] * mel.fft_out[2 * j + 1];
     }
 
-    // Choose sampling strategy based on beam_size
-    whisper_sampling_strategy strategy = (beam_size > 1) ?
-        WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
-
-    if (use_vad) {
-        keep_context = false;
+    const std::vector<float> &filters = stream->model->mel_filters;
+    const int n_mel = stream->model->n_mel;
+    for (int m = 0; m < n_mel; ++m) {
+        const float *filter = filters.data() + static_cast<size_t>(m) * kMelBins;
+        double sum = 0.0;
+        for (int k = 0; k < kMelBins; ++k) {
+            sum += mel.fft_out[k] * filter[k];
+        }
+        dst[m] = static_cast<float>(std::log10(std::max(sum, 1e-10)));
     }
+}
 
-    auto *stream = new whisper_stream();
-    stream->ctx.reset(ctx);
-    stream->params = whisper_full_default_params(strategy);
-    stream->params.print_progress = false;
-    stream->params.print_special = print_special;  // Configurable
-    stream->params.print_realtime = false;
-    stream->params.print_timestamps = print_timestamps;  // Configurable
-    stream->params.translate = translate;
-    stream->params.single_segment = !use_vad;
-    stream->params.no_context = !keep_context;
-    stream->params.max_tokens = max_tokens > 0 ? max_tokens : 0;
-    stream->params.audio_ctx = audio_ctx;  // Encoder context size
-    stream->params.temperature_inc = disable_fallback ? 0.0f : temperature_inc;
-    stream->params.n_threads = threads > 0 ? threads : 1;
-    stream->params.tdrz_enable = tinydiarize;
-
-    // Configure beam search if enabled
-    if (beam_size > 1) {
-        stream->params.beam_search.beam_size = beam_size;
+// Builds the normalised log-mel input for the current sliding window exactly
+// as whisper_pcm_to_mel would (30 s of zero padding included), reusing frames
+// from earlier ticks. Frames are cached per absolute 10 ms hop; a frame is
+// reused only when it lies entirely inside the audio on both ticks, so frames
+// touching the window edges and frames over new audio are recomputed.
+// Sets n_len to the padded frame count and n_len_org to the frames of real
+// audio. Returns false when the window is too short to frame.
+static bool compute_window_mel(whisper_stream *stream, int &n_len, int &n_len_org) {
+    mel_cache &mel = stream->mel;
+    const int n_mel = stream->model->n_mel;
+    const int half = kMelFrameSize / 2;
+    const float *x = stream->audio.data();
+    const int n = static_cast<int>(stream->audio.size());
+    if (n <= kMelFrameSize) {
+        return false;
     }
 
-    stream->keep_context = keep_context;
-    stream->use_vad = use_vad;
-    stream->vad_thold = vad_thold;
-    stream->freq_thold = freq_thold;
-    stream->vad_window_samples = samples_from_ms(kVadWindowMs);
-    stream->vad_last_ms = kVadLastMs;
-
-    if (use_vad) {
-        stream->n_samples_step = 0;
-        stream->n_samples_len = std::max(samples_from_ms(length_ms), 1);
-        stream->n_samples_keep = 0;
+    const int64_t start = stream->audio.begin_position();
+    const bool aligned = start % kMelHop == 0;
+    const int64_t first_key = start / kMelHop;
+
+    n_len = (n + kMelPadSamples) / kMelHop;
+    n_len_org = 1 + (n + half - kMelFrameSize) / kMelHop;
+    const int n_active = std::min(n_len, (n + half) / kMelHop + 1);
+
+    // Frames whose 400-sample support lies inside [0, n).
+    const int interior_lo = (half + kMelHop - 1) / kMelHop;
+    const int interior_hi = (n - half) / kMelHop; // inclusive
+
+    const int64_t t_start = steady_now_us();
+    uint64_t computed = 0;
+    mel.window.resize(static_cast<size_t>(n_active) * n_mel);
+    for (int i = 0; i < n_active; ++i) {
+        float *dst = mel.window.data() + static_cast<size_t>(i) * n_mel;
+        const int64_t key = first_key + i;
+        const bool interior = aligned && i >= interior_lo && i <= interior_hi;
+        if (interior && key >= mel.first_frame && key < mel.first_frame + mel.n_frames) {
+            const float *src = mel.frames.data() + static_cast<size_t>(key - mel.first_frame) * n_mel;
+            std::memcpy(dst, src, static_cast<size_t>(n_mel) * sizeof(float));
+            mel.stats.frames_reused++;
+            continue;
+        }
+        compute_mel_frame(stream, x, n, i, dst);
+        computed++;
+    }
+    mel.stats.frames_computed += computed;
+    mel.stats.compute_us += static_cast<uint64_t>(std::max<int64_t>(0, steady_now_us() - t_start));
+
+    if (aligned && interior_hi >= interior_lo) {
+        mel.first_frame = first_key + interior_lo;
+        mel.n_frames = interior_hi - interior_lo + 1;
+        mel.frames.assign(mel.window.begin() + static_cast<size_t>(interior_lo) * n_mel,
+                          mel.window.begin() + static_cast<size_t>(interior_hi + 1) * n_mel);
     } else {
-        stream->n_samples_step = std::max(samples_from_ms(step_ms), 1);
-        stream->n_samples_len = std::max(samples_from_ms(length_ms), stream->n_samples_step);
-        stream->n_samples_keep = std::min(samples_from_ms(keep_ms), stream->n_samples_step);
+        mel.n_frames = 0;
     }
 
-    // Calculate n_new_line for buffer reset
-    if (!use_vad && step_ms > 0) {
-        stream->n_new_line = std::max(1, static_cast<int>(length_ms / step_ms) - 1);
-    } else {
-        stream->n_new_line = 1;
+    // Frames past the audio see only zeros and clamp to log10(1e-10).
+    const float silence = -10.0f;
+    double mmax = n_active < n_len ? silence : -1e20;
+    for (const float v : mel.window) {
+        if (v > mmax) {
+            mmax = v;
+        }
     }
-    stream->n_iter = 0;
+    mmax -= 8.0;
+    const float floor_value = static_cast<float>(mmax);
+    auto normalise = [floor_value](float v) {
+        if (v < floor_value) {
+            v = floor_value;
+        }
+        return static_cast<float>((v + 4.0) / 4.0);
+    };
+
+    mel.input.resize(static_cast<size_t>(n_len) * n_mel);
+    const float padding = normalise(silence);
+    for (int m = 0; m < n_mel; ++m) {
+        float *row = mel.input.data() + static_cast<size_t>(m) * n_len;
+        for (int i = 0; i < n_active; ++i) {
+            row[i] = normalise(mel.window[static_cast<size_t>(i) * n_mel + m]);
+        }
+        std::fill(row + n_active, row + n_len, padding);
+    }
+    return true;
+}
 
-    return stream;
+// Forms the next sliding window in place: the pending samples plus as much of
+// the previous window as fits in n_samples_keep + n_samples_len. Older audio is
+// dropped so the buffer holds exactly the window. Returns the window length.
+static int assemble_window(whisper_stream *stream) {
+    const int n_samples_new = stream->n_samples_pending;
+    const int n_samples_old = static_cast<int>(stream->audio.size()) - n_samples_new;
+    int n_samples_take = std::min(
+        n_samples_old,
+        std::max(0, stream->n_samples_keep + stream->n_samples_len - n_samples_new));
+
+    if (stream->mel.enabled) {
+        // Start the window on the mel hop grid so frames carry over between
+        // ticks; this drops under 10 ms of the oldest context.
+        const int64_t start = stream->audio.end_position() - (n_samples_new + n_samples_take);
+        const int shift = static_cast<int>((kMelHop - start % kMelHop) % kMelHop);
+        if (shift <= n_samples_take) {
+            n_samples_take -= shift;
+        }
+    }
+
+    const int n_window = n_samples_new + n_samples_take;
+    stream->audio.keep_last(static_cast<size_t>(n_window));
+    stream->n_samples_pending = 0;
+    return n_window;
 }
 
-void whisper_stream_free(whisper_stream *stream) {
-    if (stream != nullptr) {
-        delete stream;
+// Smallest encoder context covering n_samples plus kAudioCtxMargin, rounded
+// up to kAudioCtxGranularity. Returns 0 (full context) when that would not be
+// smaller than the model's context.
+static int adaptive_audio_ctx(whisper_context *ctx, int n_samples) {
+    const int n_full = whisper_n_audio_ctx(ctx);
+    if (n_full <= 0) {
+        return 0;
     }
+    const int samples_per_ctx = std::max(1, kSampleRate * WHISPER_CHUNK_SIZE / n_full);
+    int needed = (n_samples + samples_per_ctx - 1) / samples_per_ctx + kAudioCtxMargin;
+    needed = (needed + kAudioCtxGranularity - 1) / kAudioCtxGranularity * kAudioCtxGranularity;
+    return needed >= n_full ? 0 : needed;
 }
 
-int whisper_stream_process(whisper_stream *stream,
-                           const float *samples,
-                           int32_t sample_count,
-                           char **out_text,
-                           float *out_confidence) {
-    if (stream == nullptr || samples == nullptr || sample_count <= 0 ||
-        out_text == nullptr || out_confidence == nullptr) {
+// Picks the language for an auto-detect window. A pinned language is reused
+// until its recheck is due; otherwise whisper's detection runs here rather
+// than inside whisper_full so its probability can be kept. Detection needs the
+// window's mel in the state: when mel_in_state is false it is computed from
+// data and mel_in_state is set, so whisper_full can skip it. Returns -1 to
+// leave detection to whisper_full.
+static int window_language(whisper_stream *stream, const float *data, int n_samples, bool &mel_in_state) {
+    language_cache &cache = stream->lang;
+    if (cache.pin_windows <= 0) {
         return -1;
     }
+    if (cache.lang_id >= 0 && (cache.recheck_windows <= 0 || cache.since_check < cache.recheck_windows)) {
+        cache.since_check++;
+        stream->stats.language_reuses++;
+        return cache.lang_id;
+    }
 
-    if (stream->use_vad) {
-        stream->pcmf32_vad.insert(stream->pcmf32_vad.end(), samples, samples + sample_count);
-        if (stream->n_samples_len > 0) {
-            const size_t max_keep = static_cast<size_t>(stream->n_samples_len + stream->vad_window_samples);
-            if (stream->pcmf32_vad.size() > max_keep) {
-                const size_t drop = stream->pcmf32_vad.size() - max_keep;
-                stream->pcmf32_vad.erase(stream->pcmf32_vad.begin(), stream->pcmf32_vad.begin() + drop);
-            }
+    const int64_t start = steady_now_us();
+    if (!mel_in_state) {
+        if (whisper_pcm_to_mel_with_state(stream->ctx(), stream->state, data, n_samples,
+                                          stream->params.n_threads) != 0) {
+            return -1;
         }
-        if (!should_trigger_vad(stream)) {
-            return 0;
+        mel_in_state = true;
+    }
+    cache.probs.assign(static_cast<size_t>(whisper_lang_max_id() + 1), 0.0f);
+    const int detected = whisper_lang_auto_detect_with_state(stream->ctx(), stream->state, 0,
+                                                             stream->params.n_threads, cache.probs.data());
+    record_stage(stream, &whisper_stream_stage_us::mel, start);
+    if (detected < 0 || detected >= static_cast<int>(cache.probs.size())) {
+        cache.since_check = 0;
+        return -1;
+    }
+    stream->stats.language_detections++;
+    cache.since_check = 0;
+    cache.probability = cache.probs[static_cast<size_t>(detected)];
+    if (cache.probability >= cache.min_probability) {
+        cache.streak = detected == cache.candidate ? cache.streak + 1 : 1;
+        cache.candidate = detected;
+        if (cache.streak >= cache.pin_windows) {
+            cache.lang_id = detected;
+        } else if (cache.lang_id != detected) {
+            // A confident recheck disagrees; confirm the new language first.
+            cache.lang_id = -1;
         }
-        return transcribe_vad_buffer(stream, out_text, out_confidence);
+    }
+    return detected;
+}
+
+// Runs whisper_full on data. sliding_window marks data as the whole of
+// stream->audio, which lets the mel cache supply the spectrogram.
+static int run_inference(whisper_stream *stream,
+                         const float *data,
+                         int n_samples,
+                         std::string &out_text,
+                         float &out_conf,
+                         bool sliding_window = false) {
+    whisper_full_params params = prepare_params(stream);
+    if (stream->audio_ctx_auto) {
+        params.audio_ctx = adaptive_audio_ctx(stream->ctx(), n_samples);
+    }
+    cpu_pin_scope pin(stream);
+    if (stream->abort_callback != nullptr) {
+        if (poll_abort(stream)) {
+            return WHISPER_STREAM_ERR_ABORTED;
+        }
+        params.abort_callback = stream_abort_callback;
+        params.abort_callback_user_data = stream;
+    }
+    params.encoder_begin_callback = stream_encoder_begin_callback;
+    params.encoder_begin_callback_user_data = stream;
+    params.logits_filter_callback = stream_logits_filter_callback;
+    params.logits_filter_callback_user_data = stream;
+    if (stream->beam_adaptive) {
+        params.strategy = WHISPER_SAMPLING_GREEDY;
+    }
+    fit_decoders(params, stream->max_decoders);
+
+    // data is always the newest n_samples of stream->audio.
+    stream->window_start_ms = (stream->audio.end_position() - n_samples) * 1000 / kSampleRate;
+
+    int n_len = 0;
+    int n_len_org = 0;
+    const int64_t mel_start = steady_now_us();
+    bool cached_mel = sliding_window && stream->mel.enabled &&
+        compute_window_mel(stream, n_len, n_len_org) &&
+        whisper_set_mel_with_state(stream->ctx(), stream->state, stream->mel.input.data(),
+                                   n_len, stream->model->n_mel) == 0;
+    if (sliding_window && stream->mel.enabled) {
+        record_stage(stream, &whisper_stream_stage_us::mel, mel_start);
+    }
+    if (cached_mel) {
+        // With no samples whisper_full keeps the mel set above. It reports the
+        // padded length as the audio length, so bound decoding explicitly.
+        params.duration_ms = n_len_org * 10;
     }
 
-    stream->pcmf32_new.insert(stream->pcmf32_new.end(), samples, samples + sample_count);
+    bool pinned_language = false;
+    if (params.language == nullptr) {
+        const int lang_id = window_language(stream, data, n_samples, cached_mel);
+        if (lang_id >= 0) {
+            params.language = whisper_lang_str(lang_id);
+            pinned_language = stream->lang.since_check > 0;
+        }
+    }
 
-    if (static_cast<int>(stream->pcmf32_new.size()) < stream->n_samples_step) {
+    auto full_pass = [&]() {
+        probe_begin(stream->probe);
+        const int rc = cached_mel ?
+            whisper_full_with_state(stream->ctx(), stream->state, params, nullptr, 0) :
+            whisper_full_with_state(stream->ctx(), stream->state, params, data, n_samples);
+        probe_end(stream);
+        stream->stats.window_samples += static_cast<uint64_t>(n_samples);
+        stream->stats.decoders = static_cast<uint64_t>(pass_decoders(params));
+        if (rc != 0) {
+            return stream->aborted.load(std::memory_order_relaxed) ? WHISPER_STREAM_ERR_ABORTED : -2;
+        }
+        collect_text(stream->state, out_text, out_conf);
         return 0;
+    };
+
+    int rc = full_pass();
+    if (rc == 0 && stream->audio_ctx_auto && params.audio_ctx > 0 &&
+        !out_text.empty() && out_conf < stream->audio_ctx_min_confidence) {
+        // Quality guard: a trimmed context that decodes poorly is retried
+        // with the full 30 s context.
+        params.audio_ctx = 0;
+        stream->stats.audio_ctx_retries++;
+        rc = full_pass();
+    }
+    if (rc == 0 && stream->beam_adaptive && !out_text.empty() && out_conf < stream->beam_min_confidence) {
+        // The state still holds this window's spectrogram, so the beam pass
+        // starts at the encoder. A mel computed from samples keeps its real
+        // length, so duration_ms needs no bound here. Pinning the detected
+        // language saves the detection's own encoder run.
+        params.strategy = WHISPER_SAMPLING_BEAM_SEARCH;
+        if (params.language == nullptr) {
+            params.language = whisper_lang_str(whisper_full_lang_id_from_state(stream->state));
+            params.detect_language = false;
+        }
+        cached_mel = true;
+        stream->stats.beam_reruns++;
+        rc = full_pass();
+    }
+    stream->stats.last = stream->pending_stages;
+    stream->pending_stages = whisper_stream_stage_us{};
+    if (rc != 0) {
+        return rc;
+    }
+    stream->last_confidence = out_conf;
+    if (pinned_language && !out_text.empty() && out_conf < kLangDropConfidence) {
+        // Poor text under a pinned language often means the speaker
+        // switched; the next window detects again.
+        stream->lang.reset();
     }
 
-    const int n_samples_new = static_cast<int>(stream->pcmf32_new.size());
-    const int n_samples_take = std::min(
-        static_cast<int>(stream->pcmf32_old.size()),
-        std::max(0, stream->n_samples_keep + stream->n_samples_len - n_samples_new));
-
-    stream->pcmf32.resize(n_samples_new + n_samples_take);
-    if (n_samples_take > 0) {
-        std::copy(stream->pcmf32_old.end() - n_samples_take,
-                  stream->pcmf32_old.end(),
-                  stream->pcmf32.begin());
+    collect_tokens(stream);
+    stream->stats.tokens += stream->current_text_tokens.size();
+    if (has_repetition_loop(stream, stream->current_text_tokens)) {
+        stream->stats.repetition_loops++;
     }
-    std::copy(stream->pcmf32_new.begin(),
-              stream->pcmf32_new.end(),
-              stream->pcmf32.begin() + n_samples_take);
 
-    stream->pcmf32_new.clear();
+    // NOTE: Prompt tokens are updated in whisper_stream_process(),
+    // synchronized with buffer reset every n_new_line iterations
 
-    // Keep entire processed buffeer
-    stream->pcmf32_old = stream->pcmf32;
+    return 0;
+}
 
-    std::string full_text;
-    float confidence = 0.0f;
-    if (run_inference(stream, stream->pcmf32.data(),
-                      static_cast<int>(stream->pcmf32.size()),
-                      full_text, confidence) != 0) {
-        return -2;
+// Trailing silence, in samples, that ends the current utterance: silence_ms,
+// shrinking linearly to min_silence_ms as the utterance approaches adapt_ms.
+// Long utterances rarely pause mid-sentence for as long as short ones.
+static int endpoint_silence_samples(const whisper_stream *stream) {
+    const endpointing &ep = stream->endpoint;
+    int ms = ep.silence_ms;
+    if (ep.adapt_ms > 0 && ep.min_silence_ms < ep.silence_ms) {
+        const double spoken_ms = static_cast<double>(stream->vad.seen) * 1000.0 / kSampleRate;
+        const double progress = std::min(1.0, spoken_ms / ep.adapt_ms);
+        ms -= static_cast<int>((ep.silence_ms - ep.min_silence_ms) * progress);
     }
+    return samples_from_ms(ms);
+}
 
-    stream->last_window = full_text;
-
-    bool reset_transcript = false;
-    std::string delta = extract_new_text(stream, reset_transcript);
+enum endpoint_event {
+    kEndpointNone,
+    kEndpointSpeculate, // silence has begun; decode ahead of the endpoint
+    kEndpointFinal,     // enough trailing silence to end the utterance
+};
 
-    if (reset_transcript) {
-        stream->prompt_tokens.clear();
-        stream->transcript.clear();
-        stream->previous_text_tokens.clear();
+static endpoint_event vad_endpoint(const whisper_stream *stream) {
+    if (stream->vad_window_samples <= 0 ||
+        static_cast<int>(stream->audio.size()) < stream->vad_window_samples) {
+        return kEndpointNone;
     }
 
-    // Increment iteration counter and reset buffer if needed
-    stream->n_iter++;
-    if ((stream->n_iter % stream->n_new_line) == 0) {
-        // Reset pcmf32_old to only keep last n_samples_keep
-        const int keep_size = std::min(stream->n_samples_keep,
-                                       static_cast<int>(stream->pcmf32.size()));
-        stream->pcmf32_old.assign(
-            stream->pcmf32.end() - keep_size,
-            stream->pcmf32.end()
-        );
+    const int n_silence = endpoint_silence_samples(stream);
+    const bool silent = stream->vad.silent_tail(n_silence, stream->vad_thold);
 
-        // Update prompt tokens for next iteration
-        // Only if no_context is false
-        if (!stream->params.no_context) {
-            stream->prompt_tokens.clear();
-            stream->prompt_tokens = stream->current_tokens;
-        }
+#ifdef WHISPER_DEBUG
+    const bool reference = vad_detect_silence(stream->audio.tail(stream->vad_window_samples),
+                                              stream->vad_window_samples,
+                                              kSampleRate,
+                                              n_silence * 1000 / kSampleRate,
+                                              stream->vad_thold,
+                                              stream->freq_thold);
+    if (reference != silent) {
+        fprintf(stderr, "[DEBUG] vad tracker disagrees with windowed recompute (tracker=%d)\n", silent);
     }
+#endif
 
-    if (delta.empty()) {
-        stream->last_confidence = confidence;
-        return 0;
+    if (silent) {
+        return kEndpointFinal;
     }
-
-    if (!stream->transcript.empty()) {
-        stream->transcript.push_back(' ');
+    const endpointing &ep = stream->endpoint;
+    if (ep.speculative && !ep.pending &&
+        stream->vad.silent_tail(std::min(n_silence, samples_from_ms(kEndpointSpeculateMs)), stream->vad_thold)) {
+        return kEndpointSpeculate;
     }
-    stream->transcript += delta;
+    return kEndpointNone;
+}
 
+// True while only silence has followed the pending speculative pass.
+static bool speculation_valid(const whisper_stream *stream) {
+    const endpointing &ep = stream->endpoint;
+    if (!ep.pending) {
+        return false;
+    }
+    const int64_t since = stream->audio.end_position() - ep.end_position;
+    return since == 0 ||
+           stream->vad.silent_tail(static_cast<int>(since) + ep.tail_samples, stream->vad_thold);
+}
+
+// Samples of buffered speech a VAD-mode pass decodes.
+static int vad_take(const whisper_stream *stream) {
+    const int total_samples = static_cast<int>(stream->audio.size());
+    return stream->n_samples_len > 0 ? std::min(stream->n_samples_len, total_samples) : total_samples;
+}
+
+// Decodes the utterance once trailing silence begins, so the endpoint can
+// return its text without waiting on inference. transcribe_vad_buffer keeps
+// the result if nothing but silence follows.
+static int speculate_vad_buffer(whisper_stream *stream) {
+    const int take = vad_take(stream);
+    if (take <= 0) {
+        return 0;
+    }
+    float confidence = 0.0f;
+    const int rc = run_inference(stream, stream->audio.tail(take), take, stream->last_window, confidence);
+    if (rc != 0) {
+        return rc;
+    }
+    endpointing &ep = stream->endpoint;
+    ep.pending = true;
+    ep.end_position = stream->audio.end_position();
+    ep.tail_samples = std::min(endpoint_silence_samples(stream), samples_from_ms(kEndpointSpeculateMs));
+    ep.confidence = confidence;
+    stream->stats.endpoint_speculations++;
+    return 0;
+}
+
+static int transcribe_vad_buffer(whisper_stream *stream,
+                                 std::string &out_text,
+                                 float &out_confidence) {
+    const int take = vad_take(stream);
+    const bool speculated = speculation_valid(stream);
+    stream->endpoint.pending = false;
+
+    if (take <= 0) {
+        stream->audio.clear();
+        stream->vad.reset();
+        return 0;
+    }
+
+    // Transcribe the buffered speech in place, then start a fresh utterance.
+    // A speculative pass followed only by silence already holds the text.
+    float confidence = 0.0f;
+    int rc = 0;
+    if (speculated) {
+        confidence = stream->endpoint.confidence;
+        stream->stats.endpoint_speculation_hits++;
+    } else {
+        rc = run_inference(stream,
+                           stream->audio.tail(take),
+                           take,
+                           stream->last_window,
+                           confidence);
+    }
+    stream->audio.clear();
+    stream->vad.reset();
+    if (rc != 0) {
+        return rc;
+    }
+
+    stream->last_confidence = confidence;
+    if (stream->last_window.empty()) {
+        return 0;
+    }
+
+    out_text = stream->last_window;
+    out_confidence = confidence;
+    append_pass_details(stream, 0, stream->emitted);
+
+    stream->transcript.clear();
+    stream->transcript_details.clear();
+    stream->prompt_tokens.clear();
+    stream->current_tokens.clear();
+    stream->current_text_tokens.clear();
+    stream->previous_text_tokens.clear();
+
+    return 1;
+}
+
+// Reads the mel filterbank that follows the hyperparameters in a ggml whisper
+// model file. whisper.cpp does not expose it, and the mel cache needs it to
+// compute frames itself.
+static bool read_mel_filters(const char *path, int n_mel, std::vector<float> &filters) {
+    FILE *f = std::fopen(path, "rb");
+    if (f == nullptr) {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    int32_t hparams[11];
+    int32_t dims[2];
+    bool ok = std::fread(&magic, sizeof(magic), 1, f) == 1 && magic == kGgmlFileMagic &&
+              std::fread(hparams, sizeof(hparams), 1, f) == 1 &&
+              std::fread(dims, sizeof(dims), 1, f) == 1 &&
+              dims[0] == n_mel && dims[1] == kMelBins;
+    if (ok) {
+        filters.resize(static_cast<size_t>(dims[0]) * dims[1]);
+        ok = std::fread(filters.data(), sizeof(float), filters.size(), f) == filters.size();
+    }
+    std::fclose(f);
+
+    if (!ok) {
+        filters.clear();
+    }
+    return ok;
+}
+
+// Picks the DTW alignment heads matching the hyperparameters in a ggml
+// whisper model file header; whisper.cpp needs them before the model loads.
+// Large v1 and v2 share a layout, so both get the v2 heads.
+static whisper_alignment_heads_preset dtw_heads_preset(const char *path) {
+    FILE *f = std::fopen(path, "rb");
+    if (f == nullptr) {
+        return WHISPER_AHEADS_NONE;
+    }
+    uint32_t magic = 0;
+    int32_t hparams[11];
+    const bool ok = std::fread(&magic, sizeof(magic), 1, f) == 1 && magic == kGgmlFileMagic &&
+                    std::fread(hparams, sizeof(hparams), 1, f) == 1;
+    std::fclose(f);
+    if (!ok) {
+        return WHISPER_AHEADS_NONE;
+    }
+
+    const bool english = hparams[0] == 51864; // n_vocab of the .en models
+    const int32_t n_text_layer = hparams[8];
+    const int32_t n_mels = hparams[9];
+    switch (n_text_layer) {
+    case 4:
+        return n_mels == 128 ? WHISPER_AHEADS_LARGE_V3_TURBO :
+            english ? WHISPER_AHEADS_TINY_EN : WHISPER_AHEADS_TINY;
+    case 6:
+        return english ? WHISPER_AHEADS_BASE_EN : WHISPER_AHEADS_BASE;
+    case 12:
+        return english ? WHISPER_AHEADS_SMALL_EN : WHISPER_AHEADS_SMALL;
+    case 24:
+        return english ? WHISPER_AHEADS_MEDIUM_EN : WHISPER_AHEADS_MEDIUM;
+    case 32:
+        return n_mels == 128 ? WHISPER_AHEADS_LARGE_V3 : WHISPER_AHEADS_LARGE_V2;
+    default:
+        return WHISPER_AHEADS_NONE;
+    }
+}
+
+// Layout of a ggml whisper model file: magic, 11 int32 hyperparameters (file
+// type last), the mel filterbank, the vocabulary, then tensors until EOF.
+static constexpr int kModelHparams = 11;
+static constexpr int kModelFtypeIndex = 10;
+static constexpr int kModelMaxDims = 4;
+
+using model_file = std::unique_ptr<FILE, StreamDeleter>;
+
+// Reads everything ahead of the first tensor into header.
+static bool read_model_header(FILE *f, std::vector<char> &header) {
+    header.clear();
+    auto take = [&](size_t n) {
+        const size_t at = header.size();
+        header.resize(at + n);
+        return std::fread(header.data() + at, 1, n, f) == n;
+    };
+    auto take_i32 = [&](int32_t &value) {
+        if (!take(sizeof(value))) {
+            return false;
+        }
+        std::memcpy(&value, header.data() + header.size() - sizeof(value), sizeof(value));
+        return true;
+    };
+
+    uint32_t magic = 0;
+    if (!take(sizeof(magic) + kModelHparams * sizeof(int32_t))) {
+        return false;
+    }
+    std::memcpy(&magic, header.data(), sizeof(magic));
+    int32_t n_mel = 0;
+    int32_t n_fft = 0;
+    int32_t n_vocab = 0;
+    if (magic != kGgmlFileMagic || !take_i32(n_mel) || !take_i32(n_fft) || n_mel < 0 || n_fft < 0 ||
+        !take(static_cast<size_t>(n_mel) * n_fft * sizeof(float)) || !take_i32(n_vocab) || n_vocab < 0) {
+        return false;
+    }
+    for (int32_t i = 0; i < n_vocab; ++i) {
+        int32_t len = 0;
+        if (!take_i32(len) || len < 0 || !take(static_cast<size_t>(len))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static int32_t header_ftype(const std::vector<char> &header) {
+    int32_t ftype = 0;
+    std::memcpy(&ftype, header.data() + sizeof(uint32_t) + kModelFtypeIndex * sizeof(int32_t), sizeof(ftype));
+    return ftype % GGML_QNT_VERSION_FACTOR;
+}
+
+struct model_tensor {
+    int32_t n_dims = 0;
+    int32_t type = 0;
+    int32_t ne[kModelMaxDims] = {1, 1, 1, 1};
+    std::string name;
+
+    int64_t rows() const { return static_cast<int64_t>(ne[1]) * ne[2] * ne[3]; }
+    size_t bytes() const { return ggml_row_size(static_cast<ggml_type>(type), ne[0]) * rows(); }
+};
+
+// Reads the next tensor header. Returns 1 on success, 0 at the end of the
+// file and -1 on a malformed header.
+static int read_tensor_header(FILE *f, model_tensor &t) {
+    int32_t head[3];
+    const size_t n = std::fread(head, sizeof(int32_t), 3, f);
+    if (n == 0 && std::feof(f)) {
+        return 0;
+    }
+    if (n != 3 || head[0] < 1 || head[0] > kModelMaxDims || head[1] < 0) {
+        return -1;
+    }
+    t.n_dims = head[0];
+    t.type = head[2];
+    std::fill(std::begin(t.ne), std::end(t.ne), 1);
+    if (std::fread(t.ne, sizeof(int32_t), static_cast<size_t>(t.n_dims), f) != static_cast<size_t>(t.n_dims)) {
+        return -1;
+    }
+    t.name.resize(static_cast<size_t>(head[1]));
+    if (std::fread(&t.name[0], 1, t.name.size(), f) != t.name.size()) {
+        return -1;
+    }
+    return 1;
+}
+
+static bool write_tensor_header(FILE *f, const model_tensor &t) {
+    const int32_t head[3] = {t.n_dims, static_cast<int32_t>(t.name.size()), t.type};
+    return std::fwrite(head, sizeof(int32_t), 3, f) == 3 &&
+           std::fwrite(t.ne, sizeof(int32_t), static_cast<size_t>(t.n_dims), f) == static_cast<size_t>(t.n_dims) &&
+           std::fwrite(t.name.data(), 1, t.name.size(), f) == t.name.size();
+}
+
+// Sums the tensor data in a model file without reading it.
+static uint64_t model_weight_bytes(const char *path) {
+    model_file f(std::fopen(path, "rb"));
+    std::vector<char> header;
+    if (!f || !read_model_header(f.get(), header)) {
+        return 0;
+    }
+    uint64_t total = 0;
+    model_tensor t;
+    int rc = 0;
+    while ((rc = read_tensor_header(f.get(), t)) == 1) {
+        total += t.bytes();
+        if (std::fseek(f.get(), static_cast<long>(t.bytes()), SEEK_CUR) != 0) {
+            return 0;
+        }
+    }
+    return rc == 0 ? total : 0;
+}
+
+// Matrices whisper.cpp's quantize tool converts: every 2-D f32/f16 tensor
+// except the positional embeddings, in whole quantization blocks.
+static bool should_quantize(const model_tensor &t, ggml_type qtype) {
+    return t.n_dims == 2 && (t.type == GGML_TYPE_F32 || t.type == GGML_TYPE_F16) &&
+           t.ne[0] % ggml_blck_size(qtype) == 0 &&
+           t.name != "encoder.positional_embedding" && t.name != "decoder.positional_embedding";
+}
+
+static void quantize_rows(ggml_type qtype, const float *src, void *dst, int64_t rows, int64_t n_per_row, int n_threads) {
+    n_threads = static_cast<int>(std::max<int64_t>(1, std::min<int64_t>(n_threads, rows)));
+    const int64_t per_thread = (rows + n_threads - 1) / n_threads;
+    std::vector<std::thread> threads;
+    for (int64_t first = 0; first < rows; first += per_thread) {
+        const int64_t n = std::min(per_thread, rows - first);
+        threads.emplace_back([=]() {
+            ggml_quantize_chunk(qtype, src, dst, first * n_per_row, n, n_per_row, nullptr);
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+static int quantize_model_file(FILE *in, FILE *out, ggml_type qtype, int n_threads) {
+    model_tensor t;
+    std::vector<char> raw;
+    std::vector<float> f32;
+    std::vector<char> quantized;
+    int rc = 0;
+    while ((rc = read_tensor_header(in, t)) == 1) {
+        raw.resize(t.bytes());
+        if (std::fread(raw.data(), 1, raw.size(), in) != raw.size()) {
+            return -3;
+        }
+        const char *data = raw.data();
+        size_t size = raw.size();
+        if (should_quantize(t, qtype)) {
+            const int64_t n = static_cast<int64_t>(t.ne[0]) * t.rows();
+            f32.resize(static_cast<size_t>(n));
+            if (t.type == GGML_TYPE_F16) {
+                ggml_fp16_to_fp32_row(reinterpret_cast<const ggml_fp16_t *>(raw.data()), f32.data(), n);
+            } else {
+                std::memcpy(f32.data(), raw.data(), raw.size());
+            }
+            t.type = qtype;
+            quantized.resize(t.bytes());
+            quantize_rows(qtype, f32.data(), quantized.data(), t.rows(), t.ne[0], n_threads);
+            data = quantized.data();
+            size = quantized.size();
+        }
+        if (!write_tensor_header(out, t) || std::fwrite(data, 1, size, out) != size) {
+            return -4;
+        }
+    }
+    return rc == 0 ? 0 : -3;
+}
+
+// Resident set of the process in bytes; 0 where it cannot be read.
+static uint64_t resident_set_bytes() {
+#if defined(__linux__)
+    model_file f(std::fopen("/proc/self/statm", "r"));
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    if (f && std::fscanf(f.get(), "%llu %llu", &size, &resident) == 2) {
+        return static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+extern "C" {
+
+whisper_stream_model_params whisper_stream_model_default_params(void) {
+    whisper_stream_model_params params;
+    params.use_gpu = true;
+    params.flash_attn = true;
+    params.dtw_timestamps = false;
+    params.gpu_device = 0;
+    return params;
+}
+
+whisper_stream_model *whisper_stream_model_load(const char *model_path,
+                                                bool use_gpu,
+                                                bool flash_attn) {
+    whisper_stream_model_params params = whisper_stream_model_default_params();
+    params.use_gpu = use_gpu;
+    params.flash_attn = flash_attn;
+    return whisper_stream_model_load_with_params(model_path, params);
+}
+
+whisper_stream_model *whisper_stream_model_load_with_params(const char *model_path,
+                                                            whisper_stream_model_params params) {
+    if (model_path == nullptr) {
+        return nullptr;
+    }
+
+    whisper_context_params cparams = whisper_context_default_params();
+    cparams.use_gpu = params.use_gpu;
+    cparams.flash_attn = params.flash_attn;
+    cparams.gpu_device = params.gpu_device > 0 ? params.gpu_device : 0;
+    if (params.dtw_timestamps && !params.flash_attn) {
+        cparams.dtw_aheads_preset = dtw_heads_preset(model_path);
+        cparams.dtw_token_timestamps = cparams.dtw_aheads_preset != WHISPER_AHEADS_NONE;
+    }
+
+    const uint64_t resident_before = resident_set_bytes();
+    whisper_context *ctx = whisper_init_from_file_with_params_no_state(model_path, cparams);
+    if (ctx == nullptr) {
+        return nullptr;
+    }
+
+    const uint64_t resident_after = resident_set_bytes();
+
+    auto shared = std::make_shared<stream_model>();
+    shared->ctx.reset(ctx);
+    shared->info.ftype = whisper_model_ftype(ctx);
+    shared->info.weight_bytes = model_weight_bytes(model_path);
+    shared->info.resident_bytes = resident_after > resident_before ? resident_after - resident_before : 0;
+    build_token_table(*shared);
+    if (read_mel_filters(model_path, whisper_model_n_mels(ctx), shared->mel_filters)) {
+        shared->n_mel = whisper_model_n_mels(ctx);
+    }
+
+    auto *model = new whisper_stream_model();
+    model->shared = std::move(shared);
+    return model;
+}
+
+void whisper_stream_model_free(whisper_stream_model *model) {
+    if (model != nullptr) {
+        delete model;
+    }
+}
+
+int whisper_stream_model_get_info(const whisper_stream_model *model, whisper_stream_model_info *info) {
+    if (model == nullptr || model->shared == nullptr || info == nullptr) {
+        return -1;
+    }
+    *info = model->shared->info;
+    return 0;
+}
+
+int whisper_stream_model_quantize(const char *src_path, const char *dst_path, int32_t ftype, int32_t n_threads) {
+    ggml_type qtype;
+    switch (ftype) {
+    case WHISPER_STREAM_FTYPE_Q5_0:
+        qtype = GGML_TYPE_Q5_0;
+        break;
+    case WHISPER_STREAM_FTYPE_Q8_0:
+        qtype = GGML_TYPE_Q8_0;
+        break;
+    default:
+        return -1;
+    }
+    if (src_path == nullptr || dst_path == nullptr) {
+        return -1;
+    }
+
+    model_file in(std::fopen(src_path, "rb"));
+    std::vector<char> header;
+    if (!in || !read_model_header(in.get(), header)) {
+        return -2;
+    }
+    const int32_t src_ftype = header_ftype(header);
+    if (src_ftype != WHISPER_STREAM_FTYPE_F32 && src_ftype != WHISPER_STREAM_FTYPE_F16) {
+        return 1;
+    }
+    const int32_t dst_ftype = GGML_QNT_VERSION * GGML_QNT_VERSION_FACTOR + ftype;
+    std::memcpy(header.data() + sizeof(uint32_t) + kModelFtypeIndex * sizeof(int32_t), &dst_ftype, sizeof(dst_ftype));
+
+    // Write next to the destination and rename, so a concurrent loader never
+    // sees a partial file.
+    const std::string tmp_path = std::string(dst_path) + ".tmp";
+    model_file out(std::fopen(tmp_path.c_str(), "wb"));
+    if (!out) {
+        return -4;
+    }
+    int rc = std::fwrite(header.data(), 1, header.size(), out.get()) == header.size() ? 0 : -4;
+    if (rc == 0) {
+        rc = quantize_model_file(in.get(), out.get(), qtype, n_threads > 0 ? n_threads : 1);
+    }
+    if (std::fclose(out.release()) != 0 && rc == 0) {
+        rc = -4;
+    }
+    if (rc == 0 && std::rename(tmp_path.c_str(), dst_path) != 0) {
+        rc = -4;
+    }
+    if (rc != 0) {
+        std::remove(tmp_path.c_str());
+    }
+    return rc;
+}
+
+int whisper_stream_model_load_vad(whisper_stream_model *model, const char *path, int32_t n_threads) {
+    if (model == nullptr || model->shared == nullptr || path == nullptr || path[0] == '\0') {
+        return -1;
+    }
+    stream_model &shared = *model->shared;
+    whisper_vad_context_params params = whisper_vad_default_context_params();
+    params.n_threads = n_threads > 0 ? n_threads : 1;
+    // The gate runs on the caller's thread between passes; keep it off the
+    // GPU the encoder is using.
+    params.use_gpu = false;
+    whisper_vad_context *vad = whisper_vad_init_from_file_with_params(path, params);
+    if (vad == nullptr) {
+        return -2;
+    }
+    {
+        std::lock_guard<std::mutex> lock(shared.pool_mu);
+        shared.vad_path = path;
+        shared.vad_params = params;
+    }
+    shared.release_vad(vad);
+    return 0;
+}
+
+int whisper_stream_model_warmup(whisper_stream_model *model, int32_t audio_ms, int32_t n_threads) {
+    if (model == nullptr || model->shared == nullptr || audio_ms <= 0) {
+        return -1;
+    }
+    stream_model &shared = *model->shared;
+    whisper_state *state = shared.acquire_state();
+    if (state == nullptr) {
+        return -2;
+    }
+
+    // Faint deterministic noise rather than silence, so the decoder runs a
+    // few tokens too.
+    std::vector<float> audio(static_cast<size_t>(samples_from_ms(audio_ms)));
+    uint32_t seed = 0x9e3779b9u;
+    for (float &sample : audio) {
+        seed = seed * 1664525u + 1013904223u;
+        sample = (static_cast<float>(seed >> 8) / 16777216.0f - 0.5f) * 0.02f;
+    }
+
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    params.n_threads = n_threads > 0 ? n_threads : 1;
+    params.single_segment = true;
+    params.no_context = true;
+    params.max_tokens = 16;
+    params.temperature_inc = 0.0f;
+    params.language = "en";
+    params.detect_language = false;
+    fit_decoders(params, 0);
+
+    const int rc = whisper_full_with_state(shared.ctx.get(), state, params,
+                                           audio.data(), static_cast<int>(audio.size()));
+    // The warmed state, buffers allocated, serves the next stream.
+    shared.release_state(state);
+    return rc == 0 ? 0 : -2;
+}
+
+whisper_stream *whisper_stream_create(const char *model_path,
+                                      int32_t step_ms,
+                                      int32_t length_ms,
+                                      int32_t keep_ms,
+                                      int32_t threads,
+                                      bool use_gpu,
+                                      bool flash_attn,
+                                      bool translate,
+                                      float temperature_inc,
+                                      bool disable_fallback,
+                                      int32_t beam_size,
+                                      int32_t audio_ctx,
+                                      bool print_timestamps,
+                                      bool print_special,
+                                      bool keep_context,
+                                      bool use_vad,
+                                      float vad_thold,
+                                      float freq_thold,
+                                      int32_t max_tokens,
+                                      bool tinydiarize) {
+    whisper_stream_model *model = whisper_stream_model_load(model_path, use_gpu, flash_attn);
+    if (model == nullptr) {
+        return nullptr;
+    }
+
+    whisper_stream *stream = whisper_stream_create_from_model(model,
+                                                              step_ms,
+                                                              length_ms,
+                                                              keep_ms,
+                                                              threads,
+                                                              translate,
+                                                              temperature_inc,
+                                                              disable_fallback,
+                                                              beam_size,
+                                                              audio_ctx,
+                                                              print_timestamps,
+                                                              print_special,
+                                                              keep_context,
+                                                              use_vad,
+                                                              vad_thold,
+                                                              freq_thold,
+                                                              max_tokens,
+                                                              tinydiarize);
+    // The stream holds its own reference to the weights.
+    whisper_stream_model_free(model);
+    return stream;
+}
+
+whisper_stream *whisper_stream_create_from_model(whisper_stream_model *model,
+                                                 int32_t step_ms,
+                                                 int32_t length_ms,
+                                                 int32_t keep_ms,
+                                                 int32_t threads,
+                                                 bool translate,
+                                                 float temperature_inc,
+                                                 bool disable_fallback,
+                                                 int32_t beam_size,
+                                                 int32_t audio_ctx,
+                                                 bool print_timestamps,
+                                                 bool print_special,
+                                                 bool keep_context,
+                                                 bool use_vad,
+                                                 float vad_thold,
+                                                 float freq_thold,
+                                                 int32_t max_tokens,
+                                                 bool tinydiarize) {
+    if (model == nullptr || model->shared == nullptr) {
+        return nullptr;
+    }
+
+    whisper_state *state = model->shared->acquire_state();
+    if (state == nullptr) {
+        return nullptr;
+    }
+
+    // Choose sampling strategy based on beam_size
+    whisper_sampling_strategy strategy = (beam_size > 1) ?
+        WHISPER_SAMPLING_BEAM_SEARCH : WHISPER_SAMPLING_GREEDY;
+
+    if (use_vad) {
+        keep_context = false;
+    }
+
+    auto *stream = new whisper_stream();
+    stream->model = model->shared;
+    stream->state = state;
+    stream->params = whisper_full_default_params(strategy);
+    stream->params.print_progress = false;
+    stream->params.print_special = print_special;  // Configurable
+    stream->params.print_realtime = false;
+    stream->params.print_timestamps = print_timestamps;  // Configurable
+    stream->params.translate = translate;
+    stream->params.single_segment = !use_vad;
+    stream->params.no_context = !keep_context;
+    stream->params.max_tokens = max_tokens > 0 ? max_tokens : 0;
+    stream->params.audio_ctx = audio_ctx;  // Encoder context size
+    stream->params.temperature_inc = disable_fallback ? 0.0f : temperature_inc;
+    stream->params.n_threads = threads > 0 ? threads : 1;
+    stream->params.tdrz_enable = tinydiarize;
+
+    // Configure beam search if enabled
+    if (beam_size > 1) {
+        stream->params.beam_search.beam_size = beam_size;
+    }
+
+    stream->keep_context = keep_context;
+    stream->use_vad = use_vad;
+    stream->vad_thold = vad_thold;
+    stream->freq_thold = freq_thold;
+    stream->vad_window_samples = samples_from_ms(kVadWindowMs);
+    if (use_vad) {
+        stream->vad.init(stream->vad_window_samples, samples_from_ms(kVadLastMs), freq_thold, kSampleRate);
+    }
+
+    if (use_vad) {
+        stream->n_samples_step = 0;
+        stream->n_samples_len = std::max(samples_from_ms(length_ms), 1);
+        stream->n_samples_keep = 0;
+    } else {
+        stream->n_samples_step = std::max(samples_from_ms(step_ms), 1);
+        stream->n_samples_len = std::max(samples_from_ms(length_ms), stream->n_samples_step);
+        stream->n_samples_keep = std::min(samples_from_ms(keep_ms), stream->n_samples_step);
+    }
+
+    // Calculate n_new_line for buffer reset
+    if (!use_vad && step_ms > 0) {
+        stream->n_new_line = std::max(1, static_cast<int>(length_ms / step_ms) - 1);
+    } else {
+        stream->n_new_line = 1;
+    }
+    stream->n_iter = 0;
+
+    // Twice the largest live region, so the window compacts at most once per
+    // window's worth of appended audio.
+    const size_t max_live = static_cast<size_t>(stream->n_samples_len + stream->n_samples_keep +
+                                                stream->vad_window_samples);
+    stream->audio.reserve(2 * max_live);
+
+    return stream;
+}
+
+void whisper_stream_free(whisper_stream *stream) {
+    if (stream != nullptr) {
+        delete stream;
+    }
+}
+
+int whisper_stream_process(whisper_stream *stream,
+                           const float *samples,
+                           int32_t sample_count,
+                           char **out_text,
+                           float *out_confidence) {
+    return whisper_stream_process_abortable(stream, samples, sample_count,
+                                            out_text, out_confidence, nullptr, nullptr);
+}
+
+// Accounts for sample_count samples just appended to stream->audio.
+static void ingest_appended(whisper_stream *stream, int32_t sample_count) {
+    if (stream->draft != nullptr) {
+        stream->draft->n_samples_since += sample_count;
+    }
+    if (stream->use_vad) {
+        const int64_t start = steady_now_us();
+        stream->vad.push(stream->audio.tail(static_cast<size_t>(sample_count)), sample_count);
+        if (stream->endpoint.pending && !speculation_valid(stream)) {
+            // Speech resumed; the utterance is not over after all.
+            stream->endpoint.pending = false;
+        }
+        if (stream->n_samples_len > 0) {
+            stream->audio.keep_last(static_cast<size_t>(stream->n_samples_len + stream->vad_window_samples));
+        }
+        record_stage(stream, &whisper_stream_stage_us::vad, start);
+        return;
+    }
+    stream->n_samples_pending += sample_count;
+}
+
+// True when the buffered audio warrants an inference pass.
+static bool window_ready(whisper_stream *stream) {
+    if (stream->use_vad) {
+        const int64_t start = steady_now_us();
+        const bool ready = vad_endpoint(stream) != kEndpointNone;
+        record_stage(stream, &whisper_stream_stage_us::vad, start);
+        return ready;
+    }
+    return stream->n_samples_pending >= stream->n_samples_step;
+}
+
+// True when the draft interval has passed since the last pass of either tier.
+static bool draft_due(const whisper_stream *stream) {
+    const draft_decoder *draft = stream->draft.get();
+    return draft != nullptr && draft->n_samples_since >= draft->n_samples_interval &&
+           !stream->audio.empty();
+}
+
+// A full pass supersedes the drafts before it.
+static void reset_draft(whisper_stream *stream) {
+    if (stream->draft != nullptr) {
+        stream->draft->n_samples_since = 0;
+        stream->draft->text.clear();
+    }
+}
+
+// Decodes the live audio with the draft model: in sliding mode the buffered
+// window plus pending samples, in VAD mode the utterance so far. out_text is
+// the part past what the last full pass already returned. Returns 1 when the
+// partial changed since the previous draft, 0 otherwise.
+static int run_draft(whisper_stream *stream, std::string &out_text, float &out_confidence) {
+    draft_decoder &draft = *stream->draft;
+    draft.n_samples_since = 0;
+    stream->emitted.clear();
+
+    const int total = static_cast<int>(stream->audio.size());
+    const int n_samples = stream->use_vad && stream->n_samples_len > 0 ?
+        std::min(stream->n_samples_len, total) : total;
+    if (n_samples <= 0) {
+        return 0;
+    }
+    // Live audio the speech gate finds silent has nothing to preview.
+    if (!stream->use_vad && gate_window(stream, stream->audio.tail(static_cast<size_t>(n_samples)), n_samples) < 0) {
+        return 0;
+    }
+    whisper_context *ctx = draft.model->ctx.get();
+    cpu_pin_scope pin(stream);
+
+    // Greedy and single-shot: a draft is replaced anyway, so it never pays for
+    // beams, fallback or context.
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    params.n_threads = stream->params.n_threads;
+    params.translate = stream->params.translate;
+    params.single_segment = stream->params.single_segment;
+    params.max_tokens = stream->params.max_tokens;
+    params.no_context = true;
+    params.temperature_inc = 0.0f;
+    fit_decoders(params, 0);
+    params.audio_ctx = adaptive_audio_ctx(ctx, n_samples);
+    params.detect_language = false;
+    if (!stream->detect_language && !stream->language_hint.empty()) {
+        params.language = stream->language_hint.c_str();
+    } else if (stream->stats.passes > 0) {
+        // Reuse what the full model detected rather than detecting again.
+        params.language = whisper_lang_str(whisper_full_lang_id_from_state(stream->state));
+    } else {
+        params.language = nullptr;
+    }
+    if (stream->abort_callback != nullptr) {
+        if (poll_abort(stream)) {
+            return WHISPER_STREAM_ERR_ABORTED;
+        }
+        params.abort_callback = stream_abort_callback;
+        params.abort_callback_user_data = stream;
+    }
+
+    // The draft window is the whole sliding buffer, so the mel cache computes
+    // its frames once for both tiers.
+    int n_len = 0;
+    int n_len_org = 0;
+    const bool cached_mel = !stream->use_vad && draft.shares_mel && stream->mel.enabled &&
+        compute_window_mel(stream, n_len, n_len_org) &&
+        whisper_set_mel_with_state(ctx, draft.state, stream->mel.input.data(),
+                                   n_len, stream->model->n_mel) == 0;
+    if (cached_mel) {
+        params.duration_ms = n_len_org * 10;
+    }
+
+    const int rc = cached_mel ?
+        whisper_full_with_state(ctx, draft.state, params, nullptr, 0) :
+        whisper_full_with_state(ctx, draft.state, params, stream->audio.tail(static_cast<size_t>(n_samples)), n_samples);
+    if (rc != 0) {
+        return stream->aborted.load(std::memory_order_relaxed) ? WHISPER_STREAM_ERR_ABORTED : -2;
+    }
+
+    draft.text_tokens.clear();
+    double p_sum = 0.0;
+    const stream_model &model = *draft.model;
+    const int n_segments = whisper_full_n_segments_from_state(draft.state);
+    for (int i = 0; i < n_segments; ++i) {
+        const int n_tokens = whisper_full_n_tokens_from_state(draft.state, i);
+        for (int j = 0; j < n_tokens; ++j) {
+            const whisper_token token = whisper_full_get_token_id_from_state(draft.state, i, j);
+            const token_entry *entry = model.token(token);
+            if (entry != nullptr && entry->text) {
+                draft.text_tokens.push_back(token);
+                p_sum += whisper_full_get_token_p_from_state(draft.state, i, j);
+            }
+        }
+    }
+
+    // Both models share a vocabulary, so the overlap with the last full pass
+    // marks what is already stable.
+    const size_t start = stream->use_vad ? 0 :
+        token_overlap(stream->previous_text_tokens, draft.text_tokens, stream->overlap_failure);
+    tokens_to_text(stream, draft.text_tokens, start, out_text);
+    if (out_text.empty() || out_text == draft.text) {
+        return 0;
+    }
+    draft.text = out_text;
+    out_confidence = draft.text_tokens.empty() ? 0.0f :
+        static_cast<float>(p_sum / static_cast<double>(draft.text_tokens.size()));
+    return 1;
+}
+
+// Decodes the assembled sliding window into stream->last_window unless the
+// speech gate finds it silent. Returns 0 after a pass, 1 when the window was
+// skipped, or a negative error.
+static int decode_window(whisper_stream *stream, int n_window, float &confidence) {
+    const float *data = stream->audio.data();
+    const int offset = gate_window(stream, data, n_window);
+    if (offset < 0) {
+        stream->stats.silent_windows++;
+        stream->stats.silent_samples += static_cast<uint64_t>(n_window);
+        // Earlier speech has slid out of the window, so the next pass has
+        // nothing to overlap with.
+        stream->previous_text_tokens.clear();
+        stream->current_text_tokens.clear();
+        return 1;
+    }
+    stream->stats.silent_samples += static_cast<uint64_t>(offset);
+    // A trimmed window no longer lines up with the cached mel frames.
+    return run_inference(stream, data + offset, n_window - offset,
+                         stream->last_window, confidence, offset == 0);
+}
+
+// Runs the inference pass for a ready window; see window_ready.
+static int run_step(whisper_stream *stream,
+                    std::string &out_text,
+                    float &out_confidence) {
+    stream->emitted.clear();
+    reset_draft(stream);
+    if (stream->use_vad) {
+        if (vad_endpoint(stream) == kEndpointSpeculate) {
+            return speculate_vad_buffer(stream);
+        }
+        stream->stats.endpoints++;
+        stream->stats.endpoint_silence_samples += static_cast<uint64_t>(endpoint_silence_samples(stream));
+        return transcribe_vad_buffer(stream, out_text, out_confidence);
+    }
+
+    const int64_t assemble_start = steady_now_us();
+    const int n_window = assemble_window(stream);
+    record_stage(stream, &whisper_stream_stage_us::assemble, assemble_start);
+
+    float confidence = 0.0f;
+    const int rc = decode_window(stream, n_window, confidence);
+    if (rc < 0) {
+        return rc;
+    }
+    const bool decoded = rc == 0;
+
+    bool reset_transcript = false;
+    if (decoded) {
+        extract_new_text(stream, reset_transcript, out_text);
+    }
+
+    if (reset_transcript) {
+        stream->prompt_tokens.clear();
+        stream->transcript.clear();
+        stream->transcript_details.clear();
+        stream->previous_text_tokens.clear();
+    }
+
+    // Increment iteration counter and reset buffer if needed
+    stream->n_iter++;
+    if ((stream->n_iter % stream->n_new_line) == 0) {
+        // Carry only the last n_samples_keep into the next window
+        stream->audio.keep_last(static_cast<size_t>(std::min(stream->n_samples_keep, n_window)));
+
+        // Update prompt tokens for next iteration
+        // Only if no_context is false
+        if (!stream->params.no_context && decoded) {
+            stream->prompt_tokens.clear();
+            stream->prompt_tokens = stream->current_tokens;
+        }
+    }
+
+    if (!decoded) {
+        return 0;
+    }
     stream->last_confidence = confidence;
+    if (out_text.empty()) {
+        return 0;
+    }
+
+    if (!stream->transcript.empty()) {
+        stream->transcript.push_back(' ');
+    }
+    stream->transcript += out_text;
+    stream->transcript_details.append(stream->emitted);
+
+    out_confidence = confidence;
+    return 1;
+}
+
+// Finalises the stream: transcribes pending audio and returns the whole
+// transcript, then resets for the next utterance.
+static int flush_stream(whisper_stream *stream,
+                        std::string &out_text,
+                        float &out_confidence) {
+    stream->emitted.clear();
+    reset_draft(stream);
+    if (stream->use_vad) {
+        if (!stream->audio.empty()) {
+            return transcribe_vad_buffer(stream, out_text, out_confidence);
+        }
+        return 0;
+    }
+
+    if (stream->n_samples_pending > 0) {
+        const int64_t assemble_start = steady_now_us();
+        const int n_window = assemble_window(stream);
+        record_stage(stream, &whisper_stream_stage_us::assemble, assemble_start);
+        float confidence = 0.0f;
+        const int rc = decode_window(stream, n_window, confidence);
+        if (rc < 0) {
+            return rc;
+        }
+        if (rc == 0) {
+            stream->last_confidence = confidence;
+        }
+    }
+
+    // The delta lands straight in out_text, then joins the transcript.
+    bool reset_transcript = false;
+    extract_new_text(stream, reset_transcript, out_text);
+    if (reset_transcript) {
+        stream->prompt_tokens.clear();
+        stream->transcript.clear();
+        stream->transcript_details.clear();
+        stream->previous_text_tokens.clear();
+    }
+    if (!out_text.empty()) {
+        if (!stream->transcript.empty()) {
+            stream->transcript.push_back(' ');
+        }
+        stream->transcript += out_text;
+        stream->transcript_details.append(stream->emitted);
+    }
+
+    // The flush returns the whole transcript, so describe all of it. Deltas
+    // are trimmed and joined by single spaces, so it needs no trimming; the
+    // swaps keep both buffers' capacity for the next utterance.
+    out_text.swap(stream->transcript);
+    stream->emitted.clear();
+    stream->emitted.segments.swap(stream->transcript_details.segments);
+    stream->emitted.tokens.swap(stream->transcript_details.tokens);
+
+    const bool has_text = !out_text.empty();
+    if (has_text) {
+        out_confidence = stream->last_confidence;
+    } else {
+        stream->last_confidence = 0.0f;
+    }
+
+    stream->audio.clear();
+    stream->n_samples_pending = 0;
+    stream->last_window.clear();
+    stream->transcript.clear();
+    stream->transcript_details.clear();
+    stream->prompt_tokens.clear();
+    stream->current_tokens.clear();
+    stream->current_text_tokens.clear();
+    stream->previous_text_tokens.clear();
+
+    return has_text ? 1 : 0;
+}
+
+// A span of the batch input; overlaps_previous marks a hard cut whose first
+// kBatchOverlapMs repeat the previous chunk.
+struct batch_chunk {
+    int start = 0;
+    int end = 0;
+    bool overlaps_previous = false;
+};
+
+// Text tokens, timing and confidence decoded from one batch chunk.
+struct batch_output {
+    std::vector<whisper_token> text_tokens;
+    std::vector<detail_token> details;
+    std::vector<detail_segment> segments;
+    int rc = 0;
+};
+
+// Splits samples into chunks of at most kBatchChunkMs, cutting in the middle
+// of the latest silence vad_detect_silence finds past kBatchMinChunkMs.
+static std::vector<batch_chunk> plan_batch_chunks(const whisper_stream *stream,
+                                                  const int16_t *samples,
+                                                  int n_samples) {
+    const int max_len = samples_from_ms(kBatchChunkMs);
+    const int min_len = samples_from_ms(kBatchMinChunkMs);
+    const int step = samples_from_ms(kBatchSearchStepMs);
+    const int window = samples_from_ms(kVadWindowMs);
+    const int overlap = samples_from_ms(kBatchOverlapMs);
+
+    std::vector<batch_chunk> chunks;
+    std::vector<float> pcm(static_cast<size_t>(window));
+    int start = 0;
+    bool overlaps = false;
+    while (start < n_samples) {
+        batch_chunk chunk;
+        chunk.start = start;
+        chunk.overlaps_previous = overlaps;
+        if (n_samples - start <= max_len) {
+            chunk.end = n_samples;
+            chunks.push_back(chunk);
+            break;
+        }
+
+        int cut = -1;
+        for (int end = start + max_len; end >= start + min_len; end -= step) {
+            s16_to_f32(samples + end - window, pcm.data(), pcm.size());
+            if (vad_detect_silence(pcm.data(), window, kSampleRate, kBatchSilenceMs,
+                                   stream->vad_thold, stream->freq_thold)) {
+                cut = end - samples_from_ms(kBatchSilenceMs) / 2;
+                break;
+            }
+        }
+        if (cut > 0) {
+            chunk.end = cut;
+            start = cut;
+            overlaps = false;
+        } else {
+            chunk.end = start + max_len;
+            start = chunk.end - overlap;
+            overlaps = true;
+        }
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+// Decodes one chunk on a worker stream into out. Times are from the start of
+// the batch input.
+static int run_batch_chunk(whisper_stream *worker,
+                           const int16_t *samples,
+                           const batch_chunk &chunk,
+                           std::vector<float> &pcm,
+                           batch_output &out) {
+    const int n = chunk.end - chunk.start;
+    pcm.resize(static_cast<size_t>(n));
+    s16_to_f32(samples + chunk.start, pcm.data(), pcm.size());
+
+    whisper_full_params params = prepare_params(worker);
+    fit_decoders(params, worker->max_decoders);
+    if (worker->abort_callback != nullptr) {
+        if (poll_abort(worker)) {
+            return WHISPER_STREAM_ERR_ABORTED;
+        }
+        params.abort_callback = stream_abort_callback;
+        params.abort_callback_user_data = worker;
+    }
+    params.encoder_begin_callback = stream_encoder_begin_callback;
+    params.encoder_begin_callback_user_data = worker;
+    params.logits_filter_callback = stream_logits_filter_callback;
+    params.logits_filter_callback_user_data = worker;
+    worker->window_start_ms = static_cast<int64_t>(chunk.start) * 1000 / kSampleRate;
+
+    probe_begin(worker->probe);
+    const int rc = whisper_full_with_state(worker->ctx(), worker->state, params, pcm.data(), n);
+    probe_end(worker);
+    worker->stats.window_samples += static_cast<uint64_t>(n);
+    if (rc != 0) {
+        return worker->aborted.load(std::memory_order_relaxed) ? WHISPER_STREAM_ERR_ABORTED : -2;
+    }
+
+    collect_tokens(worker);
+    worker->stats.tokens += worker->current_text_tokens.size();
+    if (has_repetition_loop(worker, worker->current_text_tokens)) {
+        worker->stats.repetition_loops++;
+    }
+    out.text_tokens.swap(worker->current_text_tokens);
+    out.details.swap(worker->current_text_details);
+    out.segments.swap(worker->current_segments);
+    return 0;
+}
+
+static void add_stage_us(whisper_stream_stage_us &total, const whisper_stream_stage_us &part) {
+    total.assemble += part.assemble;
+    total.vad += part.vad;
+    total.mel += part.mel;
+    total.encode += part.encode;
+    total.decode += part.decode;
+}
+
+// Transcribes samples offline: plans chunks, decodes them on n_workers
+// pooled states sharing the stream's thread budget, and stitches the chunk
+// texts in order into out_text and stream->emitted.
+static int transcribe_batch(whisper_stream *stream,
+                            const int16_t *samples,
+                            int n_samples,
+                            int n_workers,
+                            std::string &out_text,
+                            float &out_confidence) {
+    stream->emitted.clear();
+    out_text.clear();
+
+    const int64_t assemble_start = steady_now_us();
+    const std::vector<batch_chunk> chunks = plan_batch_chunks(stream, samples, n_samples);
+    const int n_threads = std::max(1, stream->params.n_threads);
+    if (n_workers <= 0) {
+        n_workers = std::max(1, n_threads / kBatchThreadsPerWorker);
+    }
+    n_workers = std::min({n_workers, n_threads, static_cast<int>(chunks.size())});
+    // Worker threads inherit the pinned mask when they start.
+    cpu_pin_scope pin(stream);
+
+    // Workers share the stream's model, decoding settings and abort probe
+    // but own their state, probe and token buffers.
+    std::vector<std::unique_ptr<whisper_stream>> workers;
+    for (int w = 0; w < n_workers; ++w) {
+        auto worker = std::make_unique<whisper_stream>();
+        worker->model = stream->model;
+        worker->state = stream->model->acquire_state();
+        if (worker->state == nullptr) {
+            return -2;
+        }
+        worker->params = stream->params;
+        worker->params.n_threads = std::max(1, n_threads / n_workers);
+        worker->params.single_segment = false;
+        worker->params.no_context = true;
+        worker->language_hint = stream->language_hint;
+        worker->detect_language = stream->detect_language;
+        worker->loop_repeats = stream->loop_repeats;
+        worker->max_decoders = stream->max_decoders;
+        worker->abort_callback = stream->abort_callback;
+        worker->abort_user_data = stream->abort_user_data;
+        workers.push_back(std::move(worker));
+    }
+    record_stage(stream, &whisper_stream_stage_us::assemble, assemble_start);
+
+    std::vector<batch_output> outputs(chunks.size());
+    std::atomic<size_t> next_chunk{0};
+    auto work = [&](whisper_stream *worker) {
+        std::vector<float> pcm;
+        for (size_t i = next_chunk.fetch_add(1); i < chunks.size(); i = next_chunk.fetch_add(1)) {
+            outputs[i].rc = run_batch_chunk(worker, samples, chunks[i], pcm, outputs[i]);
+            if (outputs[i].rc != 0) {
+                // Let the other workers stop at their next chunk.
+                next_chunk.store(chunks.size());
+                return;
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int w = 1; w < n_workers; ++w) {
+        threads.emplace_back(work, workers[w].get());
+    }
+    work(workers[0].get());
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (const auto &worker : workers) {
+        add_stage_us(stream->stats.total, worker->stats.total);
+        add_stage_us(stream->pending_stages, worker->stats.total);
+        stream->stats.passes += worker->stats.passes;
+        stream->stats.fallbacks += worker->stats.fallbacks;
+        stream->stats.tokens += worker->stats.tokens;
+        stream->stats.window_samples += worker->stats.window_samples;
+        stream->stats.repetition_loops += worker->stats.repetition_loops;
+        stream->stats.repetition_cutoffs += worker->stats.repetition_cutoffs;
+    }
+    stream->stats.last = stream->pending_stages;
+    stream->pending_stages = whisper_stream_stage_us{};
+    for (const batch_output &output : outputs) {
+        if (output.rc != 0) {
+            return output.rc;
+        }
+    }
+
+    // Stitch in order. append_pass_details reads the stream's pass buffers,
+    // so lend them each chunk's tokens and restore the stream's afterwards.
+    std::vector<detail_token> saved_details;
+    std::vector<detail_segment> saved_segments;
+    saved_details.swap(stream->current_text_details);
+    saved_segments.swap(stream->current_segments);
+    std::vector<whisper_token> tail;
+    std::string piece;
+    double p_sum = 0.0;
+    size_t n_tokens = 0;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        batch_output &output = outputs[i];
+        size_t skip = 0;
+        if (chunks[i].overlaps_previous && i > 0) {
+            // Only the previous chunk's segments that reach into the overlap
+            // can repeat, which keeps common words elsewhere from matching.
+            const batch_output &previous = outputs[i - 1];
+            const int64_t overlap_ms = static_cast<int64_t>(chunks[i].start) * 1000 / kSampleRate;
+            tail.clear();
+            for (const detail_segment &segment : previous.segments) {
+                if (segment.t1_ms > overlap_ms) {
+                    tail.insert(tail.end(),
+                                previous.text_tokens.begin() + static_cast<std::ptrdiff_t>(segment.first_token),
+                                previous.text_tokens.begin() + static_cast<std::ptrdiff_t>(segment.first_token + segment.n_tokens));
+                }
+            }
+            skip = token_overlap(tail, output.text_tokens, stream->overlap_failure);
+        }
+
+        tokens_to_text(stream, output.text_tokens, skip, piece);
+        if (piece.empty()) {
+            continue;
+        }
+        if (!out_text.empty()) {
+            out_text.push_back(' ');
+        }
+        out_text += piece;
+
+        stream->current_text_details.swap(output.details);
+        stream->current_segments.swap(output.segments);
+        append_pass_details(stream, skip, stream->emitted);
+        // Swap back: the next chunk's overlap check reads this one.
+        stream->current_text_details.swap(output.details);
+        stream->current_segments.swap(output.segments);
+        for (size_t t = skip; t < output.details.size(); ++t) {
+            p_sum += output.details[t].p;
+            n_tokens++;
+        }
+    }
+    stream->current_text_details.swap(saved_details);
+    stream->current_segments.swap(saved_segments);
+
+    if (out_text.empty()) {
+        return 0;
+    }
+    out_confidence = n_tokens > 0 ? static_cast<float>(p_sum / static_cast<double>(n_tokens)) : 0.0f;
+    return 1;
+}
+
+// Hands the text of an internal call to a plain entry point's caller.
+static int emit_text(int rc, const std::string &text, float confidence,
+                     char **out_text, float *out_confidence) {
+    if (rc != 1) {
+        return rc;
+    }
     *out_confidence = confidence;
-    *out_text = static_cast<char *>(std::malloc(delta.size() + 1));
+    *out_text = static_cast<char *>(std::malloc(text.size() + 1));
     if (*out_text == nullptr) {
         return -3;
     }
-    std::memcpy(*out_text, delta.c_str(), delta.size() + 1);
+    std::memcpy(*out_text, text.c_str(), text.size() + 1);
     return 1;
 }
 
-int whisper_stream_flush(whisper_stream *stream,
-                         char **out_text,
-                         float *out_confidence) {
-    if (stream == nullptr || out_text == nullptr || out_confidence == nullptr) {
-        return -1;
+static_assert(sizeof(result_block) % alignof(whisper_stream_result) == 0,
+              "the result must follow its block header aligned");
+static_assert(sizeof(whisper_stream_result) % alignof(whisper_stream_segment) == 0,
+              "segments must follow the result header aligned");
+static_assert(sizeof(whisper_stream_segment) % alignof(whisper_stream_token) == 0,
+              "tokens must follow the segment array aligned");
+
+// Serialises text and stream->emitted into one block: the block header, the
+// result header, the segment array, the token array, then every string. The
+// block is a fresh malloc, or the stream's arena when it reuses results.
+static whisper_stream_result *build_result(whisper_stream *stream,
+                                           const std::string &text,
+                                           float confidence,
+                                           bool stable) {
+    const stream_model &model = *stream->model;
+    const result_details &details = stream->emitted;
+
+    // Each piece is stored once for its token and once inside its segment's text.
+    size_t n_chars = text.size() + 1 + details.segments.size();
+    for (const detail_token &token : details.tokens) {
+        const token_entry *entry = model.token(token.id);
+        n_chars += 2 * static_cast<size_t>(entry != nullptr ? entry->length : 0) + 1;
+    }
+    const size_t result_offset = sizeof(result_block);
+    const size_t segments_offset = result_offset + sizeof(whisper_stream_result);
+    const size_t tokens_offset = segments_offset + details.segments.size() * sizeof(whisper_stream_segment);
+    const size_t chars_offset = tokens_offset + details.tokens.size() * sizeof(whisper_stream_token);
+
+    const size_t n_bytes = chars_offset + n_chars;
+    char *arena = nullptr;
+    if (stream->reuse_results) {
+        const size_t n_blocks = (n_bytes + sizeof(result_block) - 1) / sizeof(result_block);
+        if (stream->result_arena.size() < n_blocks) {
+            stream->result_arena.resize(n_blocks);
+        }
+        arena = reinterpret_cast<char *>(stream->result_arena.data());
+    } else {
+        arena = static_cast<char *>(std::malloc(n_bytes));
+        if (arena == nullptr) {
+            return nullptr;
+        }
+    }
+    reinterpret_cast<result_block *>(arena)->stream_owned = stream->reuse_results;
+    auto *result = reinterpret_cast<whisper_stream_result *>(arena + result_offset);
+    auto *segments = reinterpret_cast<whisper_stream_segment *>(arena + segments_offset);
+    auto *tokens = reinterpret_cast<whisper_stream_token *>(arena + tokens_offset);
+    char *chars = arena + chars_offset;
+
+    auto store = [&chars](const char *data, size_t length) -> const char * {
+        char *dst = chars;
+        if (length > 0) {
+            std::memcpy(dst, data, length);
+        }
+        dst[length] = '\0';
+        chars += length + 1;
+        return dst;
+    };
+
+    result->text = store(text.data(), text.size());
+    result->text_len = static_cast<int32_t>(text.size());
+    result->confidence = confidence;
+    result->n_segments = static_cast<int32_t>(details.segments.size());
+    result->stable = stable;
+    result->segments = segments;
+
+    for (size_t t = 0; t < details.tokens.size(); ++t) {
+        const detail_token &token = details.tokens[t];
+        const token_entry *entry = model.token(token.id);
+        const size_t length = entry != nullptr ? static_cast<size_t>(entry->length) : 0;
+        tokens[t].text = store(entry != nullptr ? entry->piece : "", length);
+        tokens[t].text_len = static_cast<int32_t>(length);
+        tokens[t].id = token.id;
+        tokens[t].p = token.p;
+        tokens[t].t0_ms = token.t0_ms;
+        tokens[t].t1_ms = token.t1_ms;
+        tokens[t].dtw_ms = token.dtw_ms;
     }
 
-    if (stream->use_vad) {
-        if (!stream->pcmf32_vad.empty()) {
-            int rc = transcribe_vad_buffer(stream, out_text, out_confidence);
-            if (rc <= 0) {
-                return rc;
+    for (size_t i = 0; i < details.segments.size(); ++i) {
+        const detail_segment &segment = details.segments[i];
+        char *start = chars;
+        char *end = chars;
+        double p_sum = 0.0;
+        for (size_t t = segment.first_token; t < segment.first_token + segment.n_tokens; ++t) {
+            const token_entry *entry = model.token(details.tokens[t].id);
+            if (entry != nullptr && entry->length > 0) {
+                std::memcpy(end, entry->piece, entry->length);
+                end += entry->length;
             }
-            return rc;
+            p_sum += details.tokens[t].p;
+        }
+        chars = end + 1;
+
+        // Trim in place, like the text returned alongside.
+        while (start < end && std::isspace(static_cast<unsigned char>(*start))) {
+            start++;
+        }
+        while (end > start && std::isspace(static_cast<unsigned char>(end[-1]))) {
+            end--;
         }
+        *end = '\0';
+
+        segments[i].text = start;
+        segments[i].text_len = static_cast<int32_t>(end - start);
+        segments[i].t0_ms = segment.t0_ms;
+        segments[i].t1_ms = segment.t1_ms;
+        segments[i].confidence = segment.n_tokens > 0 ?
+            static_cast<float>(p_sum / static_cast<double>(segment.n_tokens)) : 0.0f;
+        segments[i].n_tokens = static_cast<int32_t>(segment.n_tokens);
+        segments[i].tokens = tokens + segment.first_token;
+    }
+    return result;
+}
+
+// Hands the text of an internal call, with its details, to an *_ex caller.
+static int emit_result(whisper_stream *stream, int rc, const std::string &text, float confidence,
+                       whisper_stream_result **out_result, bool stable = true) {
+    if (rc != 1) {
+        return rc;
+    }
+    *out_result = build_result(stream, text, confidence, stable);
+    return *out_result == nullptr ? -3 : 1;
+}
+
+int whisper_stream_process_abortable(whisper_stream *stream,
+                                     const float *samples,
+                                     int32_t sample_count,
+                                     char **out_text,
+                                     float *out_confidence,
+                                     whisper_stream_abort_callback should_abort,
+                                     void *abort_user_data) {
+    if (stream == nullptr || samples == nullptr || sample_count <= 0 ||
+        out_text == nullptr || out_confidence == nullptr) {
+        return -1;
+    }
+
+    abort_scope abort(stream, should_abort, abort_user_data);
+    stream->audio.append(samples, static_cast<size_t>(sample_count));
+    ingest_appended(stream, sample_count);
+    if (!window_ready(stream)) {
         return 0;
     }
+    std::string &text = stream->output;
+    float confidence = 0.0f;
+    const int rc = run_step(stream, text, confidence);
+    return emit_text(rc, text, confidence, out_text, out_confidence);
+}
 
-    if (!stream->pcmf32_new.empty()) {
-        const int n_samples_new = static_cast<int>(stream->pcmf32_new.size());
-        const int n_samples_take = std::min(
-            static_cast<int>(stream->pcmf32_old.size()),
-            std::max(0, stream->n_samples_keep + stream->n_samples_len - n_samples_new));
-
-        stream->pcmf32.resize(n_samples_new + n_samples_take);
-        if (n_samples_take > 0) {
-            std::copy(stream->pcmf32_old.end() - n_samples_take,
-                      stream->pcmf32_old.end(),
-                      stream->pcmf32.begin());
-        }
-        std::copy(stream->pcmf32_new.begin(),
-                  stream->pcmf32_new.end(),
-                  stream->pcmf32.begin() + n_samples_take);
-        stream->pcmf32_new.clear();
-        stream->pcmf32_old.assign(
-            stream->pcmf32.end() - std::min(stream->n_samples_keep,
-                                            static_cast<int>(stream->pcmf32.size())),
-            stream->pcmf32.end());
-        std::string full_text;
-        float confidence = 0.0f;
-        if (run_inference(stream, stream->pcmf32.data(),
-                          static_cast<int>(stream->pcmf32.size()),
-                          full_text, confidence) != 0) {
-            return -2;
-        }
-        stream->last_window = full_text;
-        stream->last_confidence = confidence;
+int whisper_stream_process_s16(whisper_stream *stream,
+                               const int16_t *samples,
+                               int32_t sample_count,
+                               char **out_text,
+                               float *out_confidence,
+                               whisper_stream_abort_callback should_abort,
+                               void *abort_user_data) {
+    if (stream == nullptr || samples == nullptr || sample_count <= 0 ||
+        out_text == nullptr || out_confidence == nullptr) {
+        return -1;
     }
 
-    bool reset_transcript = false;
-    std::string delta = extract_new_text(stream, reset_transcript);
-    if (reset_transcript) {
-        stream->prompt_tokens.clear();
-        stream->transcript.clear();
-        stream->previous_text_tokens.clear();
+    abort_scope abort(stream, should_abort, abort_user_data);
+    stream->audio.append_s16(samples, static_cast<size_t>(sample_count));
+    ingest_appended(stream, sample_count);
+    if (!window_ready(stream)) {
+        return 0;
     }
-    if (!delta.empty()) {
-        if (!stream->transcript.empty()) {
-            stream->transcript.push_back(' ');
-        }
-        stream->transcript += delta;
+    std::string &text = stream->output;
+    float confidence = 0.0f;
+    const int rc = run_step(stream, text, confidence);
+    return emit_text(rc, text, confidence, out_text, out_confidence);
+}
+
+int whisper_stream_process_ex(whisper_stream *stream,
+                              const int16_t *samples,
+                              int32_t sample_count,
+                              whisper_stream_result **out_result,
+                              whisper_stream_abort_callback should_abort,
+                              void *abort_user_data) {
+    if (stream == nullptr || samples == nullptr || sample_count <= 0 || out_result == nullptr) {
+        return -1;
     }
 
-    std::string final_text = trim(stream->transcript);
-    if (final_text.empty()) {
-        stream->pcmf32.clear();
-        stream->pcmf32_old.clear();
-        stream->pcmf32_new.clear();
-        stream->last_window.clear();
-        stream->transcript.clear();
-        stream->prompt_tokens.clear();
-        stream->current_tokens.clear();
-        stream->current_text_tokens.clear();
-        stream->previous_text_tokens.clear();
-        stream->last_confidence = 0.0f;
+    abort_scope abort(stream, should_abort, abort_user_data);
+    stream->audio.append_s16(samples, static_cast<size_t>(sample_count));
+    ingest_appended(stream, sample_count);
+    std::string &text = stream->output;
+    float confidence = 0.0f;
+    if (window_ready(stream)) {
+        const int rc = run_step(stream, text, confidence);
+        return emit_result(stream, rc, text, confidence, out_result);
+    }
+    if (draft_due(stream)) {
+        const int rc = run_draft(stream, text, confidence);
+        return emit_result(stream, rc, text, confidence, out_result, false);
+    }
+    return 0;
+}
+
+int whisper_stream_push_s16(whisper_stream *stream,
+                            const int16_t *samples,
+                            int32_t sample_count) {
+    if (stream == nullptr || samples == nullptr || sample_count <= 0) {
+        return -1;
+    }
+
+    stream->audio.append_s16(samples, static_cast<size_t>(sample_count));
+    ingest_appended(stream, sample_count);
+    if (window_ready(stream)) {
+        return 1;
+    }
+    return draft_due(stream) ? 2 : 0;
+}
+
+int whisper_stream_step(whisper_stream *stream,
+                        char **out_text,
+                        float *out_confidence,
+                        whisper_stream_abort_callback should_abort,
+                        void *abort_user_data) {
+    if (stream == nullptr || out_text == nullptr || out_confidence == nullptr) {
+        return -1;
+    }
+    if (!window_ready(stream)) {
         return 0;
     }
 
-    *out_confidence = stream->last_confidence;
-    *out_text = static_cast<char *>(std::malloc(final_text.size() + 1));
-    if (*out_text == nullptr) {
-        return -3;
+    abort_scope abort(stream, should_abort, abort_user_data);
+    std::string &text = stream->output;
+    float confidence = 0.0f;
+    const int rc = run_step(stream, text, confidence);
+    return emit_text(rc, text, confidence, out_text, out_confidence);
+}
+
+int whisper_stream_step_ex(whisper_stream *stream,
+                           whisper_stream_result **out_result,
+                           whisper_stream_abort_callback should_abort,
+                           void *abort_user_data) {
+    if (stream == nullptr || out_result == nullptr) {
+        return -1;
+    }
+
+    abort_scope abort(stream, should_abort, abort_user_data);
+    std::string &text = stream->output;
+    float confidence = 0.0f;
+    if (window_ready(stream)) {
+        const int rc = run_step(stream, text, confidence);
+        return emit_result(stream, rc, text, confidence, out_result);
+    }
+    if (draft_due(stream)) {
+        const int rc = run_draft(stream, text, confidence);
+        return emit_result(stream, rc, text, confidence, out_result, false);
+    }
+    return 0;
+}
+
+int whisper_stream_flush(whisper_stream *stream,
+                         char **out_text,
+                         float *out_confidence) {
+    return whisper_stream_flush_abortable(stream, out_text, out_confidence, nullptr, nullptr);
+}
+
+int whisper_stream_flush_abortable(whisper_stream *stream,
+                                   char **out_text,
+                                   float *out_confidence,
+                                   whisper_stream_abort_callback should_abort,
+                                   void *abort_user_data) {
+    if (stream == nullptr || out_text == nullptr || out_confidence == nullptr) {
+        return -1;
+    }
+
+    abort_scope abort(stream, should_abort, abort_user_data);
+    std::string &text = stream->output;
+    float confidence = 0.0f;
+    const int rc = flush_stream(stream, text, confidence);
+    return emit_text(rc, text, confidence, out_text, out_confidence);
+}
+
+int whisper_stream_flush_ex(whisper_stream *stream,
+                            whisper_stream_result **out_result,
+                            whisper_stream_abort_callback should_abort,
+                            void *abort_user_data) {
+    if (stream == nullptr || out_result == nullptr) {
+        return -1;
+    }
+
+    abort_scope abort(stream, should_abort, abort_user_data);
+    std::string &text = stream->output;
+    float confidence = 0.0f;
+    const int rc = flush_stream(stream, text, confidence);
+    return emit_result(stream, rc, text, confidence, out_result);
+}
+
+int whisper_stream_reset(whisper_stream *stream) {
+    if (stream == nullptr) {
+        return -1;
     }
-    std::memcpy(*out_text, final_text.c_str(), final_text.size() + 1);
 
-    stream->pcmf32.clear();
-    stream->pcmf32_old.clear();
-    stream->pcmf32_new.clear();
+    // Positions restart with the ring, so cached mel frames keyed on the old
+    // ones must go too.
+    stream->audio.rewind();
+    stream->n_samples_pending = 0;
+    stream->vad.reset();
+    stream->endpoint.pending = false;
+    stream->mel.first_frame = 0;
+    stream->mel.n_frames = 0;
+    stream->mel.stats = {};
+
+    stream->language_hint.clear();
+    stream->detect_language = true;
+    stream->lang.reset();
+
     stream->last_window.clear();
     stream->transcript.clear();
+    stream->last_confidence = 0.0f;
+    stream->output.clear();
     stream->prompt_tokens.clear();
     stream->current_tokens.clear();
     stream->current_text_tokens.clear();
     stream->previous_text_tokens.clear();
+    stream->current_text_details.clear();
+    stream->current_segments.clear();
+    stream->window_start_ms = 0;
+    stream->emitted.clear();
+    stream->transcript_details.clear();
+    stream->n_iter = 0;
 
-    return 1;
+    reset_draft(stream);
+    if (stream->draft != nullptr) {
+        stream->draft->text_tokens.clear();
+    }
+
+    stream->aborted.store(false, std::memory_order_relaxed);
+    stream->stats = {};
+    stream->pending_stages = {};
+    return 0;
+}
+
+int whisper_stream_transcribe_batch(whisper_stream *stream,
+                                    const int16_t *samples,
+                                    int32_t sample_count,
+                                    int32_t n_workers,
+                                    whisper_stream_result **out_result,
+                                    whisper_stream_abort_callback should_abort,
+                                    void *abort_user_data) {
+    if (stream == nullptr || samples == nullptr || sample_count <= 0 || out_result == nullptr) {
+        return -1;
+    }
+
+    abort_scope abort(stream, should_abort, abort_user_data);
+    std::string &text = stream->output;
+    float confidence = 0.0f;
+    const int rc = transcribe_batch(stream, samples, sample_count, n_workers, text, confidence);
+    return emit_result(stream, rc, text, confidence, out_result);
+}
+
+void whisper_stream_free_result(whisper_stream_result *result) {
+    if (result == nullptr) {
+        return;
+    }
+    auto *block = reinterpret_cast<result_block *>(result) - 1;
+    if (!block->stream_owned) {
+        std::free(block);
+    }
 }
 
 void whisper_stream_free_text(char *text) {
@@ -800,6 +3551,90 @@ void whisper_stream_free_text(char *text) {
     }
 }
 
+int whisper_stream_set_repetition_guard(whisper_stream *stream, int32_t min_repeats) {
+    if (stream == nullptr || min_repeats < 0) {
+        return -1;
+    }
+    stream->loop_repeats = loop_repeats_for(min_repeats);
+    return 0;
+}
+
+int whisper_stream_tokens_loop(const int32_t *tokens, int32_t n_tokens, int32_t min_repeats) {
+    const int repeats = loop_repeats_for(min_repeats);
+    if (tokens == nullptr || n_tokens < kLoopMinTokens || repeats <= 0) {
+        return 0;
+    }
+    whisper_token recent[kLoopScanTokens];
+    int n = 0;
+    for (int i = n_tokens; i-- > 0 && n < kLoopScanTokens;) {
+        recent[n++] = tokens[i];
+    }
+    return ends_in_loop(recent, n, repeats) ? 1 : 0;
+}
+
+int whisper_stream_set_language_cache(whisper_stream *stream,
+                                      int32_t pin_windows,
+                                      float min_probability,
+                                      int32_t recheck_windows) {
+    if (stream == nullptr || pin_windows < 0 || recheck_windows < 0 ||
+        !(min_probability >= 0.0f && min_probability <= 1.0f)) {
+        return -1;
+    }
+    stream->lang.pin_windows = pin_windows;
+    stream->lang.min_probability = min_probability;
+    stream->lang.recheck_windows = recheck_windows;
+    stream->lang.reset();
+    return 0;
+}
+
+int whisper_stream_set_speech_gate(whisper_stream *stream, int32_t kind, float threshold) {
+    if (stream == nullptr || kind < WHISPER_STREAM_SPEECH_GATE_OFF || kind > WHISPER_STREAM_SPEECH_GATE_SILERO) {
+        return -1;
+    }
+
+    speech_gate &gate = stream->gate;
+    if (kind == WHISPER_STREAM_SPEECH_GATE_SILERO && gate.vad == nullptr) {
+        gate.vad = stream->model->acquire_vad();
+        if (gate.vad == nullptr) {
+            return -2;
+        }
+    } else if (kind != WHISPER_STREAM_SPEECH_GATE_SILERO) {
+        stream->model->release_vad(gate.vad);
+        gate.vad = nullptr;
+    }
+    gate.kind = kind;
+    if (threshold > 0.0f) {
+        gate.threshold = threshold;
+    } else {
+        gate.threshold = kind == WHISPER_STREAM_SPEECH_GATE_SILERO ? kGateSileroThreshold : kGateEnergyThreshold;
+    }
+    return 0;
+}
+
+int whisper_stream_set_threads(whisper_stream *stream,
+                               int32_t n_threads,
+                               const int32_t *cpus,
+                               int32_t n_cpus) {
+    if (stream == nullptr || n_threads <= 0 || n_cpus < 0 || (n_cpus > 0 && cpus == nullptr)) {
+        return -1;
+    }
+
+    stream->params.n_threads = n_threads;
+    stream->cpu_affinity.assign(cpus, cpus + n_cpus);
+    return 0;
+}
+
+int whisper_stream_cpu_pinning_supported(void) {
+#if WHISPER_STREAM_HAVE_AFFINITY
+    // The CPU backend lists "OPENMP = 1" among its features when ggml was
+    // built with GGML_OPENMP.
+    const char *info = whisper_print_system_info();
+    return info != nullptr && std::strstr(info, "OPENMP = 1") == nullptr ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
 int whisper_stream_set_language(whisper_stream *stream,
                                 const char *language,
                                 bool detect_language) {
@@ -809,10 +3644,160 @@ int whisper_stream_set_language(whisper_stream *stream,
 
     stream->language_hint.clear();
     stream->detect_language = detect_language;
+    stream->lang.reset();
+    stream->endpoint.pending = false;
     if (!detect_language && language != nullptr) {
         stream->language_hint = language;
     }
     return 0;
 }
 
+int whisper_stream_set_endpointing(whisper_stream *stream,
+                                   int32_t silence_ms,
+                                   int32_t min_silence_ms,
+                                   int32_t adapt_ms,
+                                   bool speculative) {
+    if (stream == nullptr || silence_ms <= 0 || adapt_ms < 0) {
+        return -1;
+    }
+
+    endpointing &ep = stream->endpoint;
+    ep.silence_ms = std::clamp(silence_ms, kEndpointMinSilenceMs, kEndpointMaxSilenceMs);
+    ep.min_silence_ms = min_silence_ms <= 0 ? ep.silence_ms :
+        std::clamp(min_silence_ms, kEndpointMinSilenceMs, ep.silence_ms);
+    ep.adapt_ms = adapt_ms;
+    ep.speculative = speculative;
+    ep.pending = false;
+
+    // The silence is judged against the energy of the whole window, which
+    // must hold as much audio again ahead of it.
+    const int window = samples_from_ms(std::max(kVadWindowMs, 2 * ep.silence_ms));
+    const int last = samples_from_ms(ep.silence_ms);
+    if (stream->use_vad && (window != stream->vad.n_window || last != stream->vad.n_last)) {
+        stream->vad_window_samples = window;
+        stream->vad.init(window, last, stream->freq_thold, kSampleRate);
+    }
+    return 0;
+}
+
+int whisper_stream_set_draft_model(whisper_stream *stream,
+                                   whisper_stream_model *draft_model,
+                                   int32_t interval_ms) {
+    if (stream == nullptr) {
+        return -1;
+    }
+    if (draft_model == nullptr) {
+        stream->draft.reset();
+        return 0;
+    }
+    if (draft_model->shared == nullptr || interval_ms <= 0 ||
+        whisper_model_n_vocab(draft_model->shared->ctx.get()) != whisper_model_n_vocab(stream->ctx())) {
+        return -1;
+    }
+
+    auto draft = std::make_unique<draft_decoder>();
+    draft->model = draft_model->shared;
+    draft->state = draft->model->acquire_state();
+    if (draft->state == nullptr) {
+        draft->model.reset();
+        return -2;
+    }
+    draft->shares_mel = draft->model->n_mel == stream->model->n_mel;
+    draft->n_samples_interval = samples_from_ms(interval_ms);
+    stream->draft = std::move(draft);
+    return 0;
+}
+
+int whisper_stream_set_reuse_results(whisper_stream *stream, bool enabled) {
+    if (stream == nullptr) {
+        return -1;
+    }
+    stream->reuse_results = enabled;
+    if (!enabled) {
+        std::vector<result_block>().swap(stream->result_arena);
+    }
+    return 0;
+}
+
+int whisper_stream_set_token_timestamps(whisper_stream *stream, bool enabled) {
+    if (stream == nullptr) {
+        return -1;
+    }
+    stream->params.token_timestamps = enabled;
+    return 0;
+}
+
+int whisper_stream_set_audio_ctx_auto(whisper_stream *stream,
+                                      bool enabled,
+                                      float min_confidence) {
+    if (stream == nullptr || min_confidence < 0.0f || min_confidence > 1.0f) {
+        return -1;
+    }
+    stream->audio_ctx_auto = enabled;
+    stream->audio_ctx_min_confidence = min_confidence;
+    return 0;
+}
+
+int whisper_stream_set_max_decoders(whisper_stream *stream, int32_t max_decoders) {
+    if (stream == nullptr || max_decoders < 0 ||
+        (max_decoders > 0 && stream->params.strategy == WHISPER_SAMPLING_BEAM_SEARCH &&
+         stream->params.beam_search.beam_size > max_decoders)) {
+        return -1;
+    }
+    stream->max_decoders = max_decoders;
+    return 0;
+}
+
+int whisper_stream_set_adaptive_beam(whisper_stream *stream, bool enabled, float min_confidence) {
+    if (stream == nullptr || min_confidence < 0.0f || min_confidence > 1.0f ||
+        (enabled && stream->params.strategy != WHISPER_SAMPLING_BEAM_SEARCH)) {
+        return -1;
+    }
+    if (enabled && stream->params.greedy.best_of <= 0) {
+        // Beam-search defaults leave best_of unset, which would sample a
+        // single candidate on temperature fallback.
+        stream->params.greedy.best_of = whisper_full_default_params(WHISPER_SAMPLING_GREEDY).greedy.best_of;
+    }
+    stream->beam_adaptive = enabled;
+    stream->beam_min_confidence = min_confidence;
+    return 0;
+}
+
+int whisper_stream_set_mel_cache(whisper_stream *stream, bool enabled) {
+    if (stream == nullptr) {
+        return -1;
+    }
+    if (enabled && (stream->use_vad || stream->model->mel_filters.empty())) {
+        stream->mel.enabled = false;
+        return -2;
+    }
+    stream->mel.enabled = enabled;
+    stream->mel.n_frames = 0;
+    return 0;
+}
+
+int whisper_stream_get_mel_stats(const whisper_stream *stream, whisper_stream_mel_stats *out) {
+    if (stream == nullptr || out == nullptr) {
+        return -1;
+    }
+    *out = stream->mel.stats;
+    return 0;
+}
+
+int whisper_stream_get_stats(const whisper_stream *stream, whisper_stream_stats *out) {
+    if (stream == nullptr || out == nullptr) {
+        return -1;
+    }
+    *out = stream->stats;
+    // Memory is read when asked for: the state and its caches outlive a reset.
+    whisper_context *ctx = stream->model->ctx.get();
+    out->kv_self_bytes = stream->stats.decoders > 0 ?
+        kv_self_bytes(ctx, static_cast<int>(stream->stats.decoders)) : 0;
+    out->kv_cross_bytes = kv_cache_bytes(ctx, whisper_n_audio_ctx(ctx));
+    // A fresh state holds the single-decoder text cache until a pass resizes it.
+    out->state_bytes = (out->kv_self_bytes > 0 ? out->kv_self_bytes : kv_self_bytes(ctx, 1)) +
+                       out->kv_cross_bytes;
+    return 0;
+}
+
 } // extern "C"
@@ -8,8 +8,242 @@ extern "C" {
 #endif
 
 typedef struct whisper_stream whisper_stream;
+typedef struct whisper_stream_model whisper_stream_model;
 
-/// Creates a streaming Whisper context.
+/// Returned by the *_abortable entry points when the abort callback stopped inference.
+#define WHISPER_STREAM_ERR_ABORTED (-4)
+
+/// Timestamp value for times whisper did not compute.
+#define WHISPER_STREAM_NO_TIMESTAMP (-1)
+
+/// Speech gates for whisper_stream_set_speech_gate. ENERGY treats frames whose
+/// mean absolute amplitude reaches the threshold as speech; SILERO uses the
+/// frame's speech probability and needs whisper_stream_model_load_vad.
+#define WHISPER_STREAM_SPEECH_GATE_OFF 0
+#define WHISPER_STREAM_SPEECH_GATE_ENERGY 1
+#define WHISPER_STREAM_SPEECH_GATE_SILERO 2
+
+/// Polled during inference; returning true stops the current whisper_full call.
+/// May be invoked from ggml worker threads.
+typedef bool (*whisper_stream_abort_callback)(void *user_data);
+
+/// Cumulative mel-spectrogram cache counters of a stream.
+typedef struct whisper_stream_mel_stats {
+    uint64_t frames_computed;
+    uint64_t frames_reused;
+    /// Wall time spent computing the frames counted in frames_computed.
+    uint64_t compute_us;
+} whisper_stream_mel_stats;
+
+/// Wall time spent per pipeline stage, in microseconds.
+typedef struct whisper_stream_stage_us {
+    /// Forming the sliding window from buffered audio.
+    uint64_t assemble;
+    /// Energy VAD bookkeeping and silence checks.
+    uint64_t vad;
+    /// Log-mel spectrogram, plus language detection when it runs.
+    uint64_t mel;
+    /// Encoder pass, including the prompt prefill that follows it.
+    uint64_t encode;
+    /// Token decoding and sampling, temperature fallbacks included.
+    uint64_t decode;
+} whisper_stream_stage_us;
+
+/// Cumulative inference statistics of a stream.
+typedef struct whisper_stream_stats {
+    whisper_stream_stage_us total;
+    /// Work behind the most recent inference pass, including the buffering and
+    /// VAD time since the pass before it.
+    whisper_stream_stage_us last;
+    /// whisper_full calls.
+    uint64_t passes;
+    /// Temperature fallbacks: windows decoded again at a higher temperature.
+    uint64_t fallbacks;
+    /// Adaptive audio_ctx windows decoded again with the full context.
+    uint64_t audio_ctx_retries;
+    /// Text tokens produced.
+    uint64_t tokens;
+    /// Samples handed to whisper_full.
+    uint64_t window_samples;
+    /// Windows whose text still ended in a repetition loop.
+    uint64_t repetition_loops;
+    /// Sliding windows the speech gate found silent and never decoded.
+    uint64_t silent_windows;
+    /// Samples kept from whisper_full by the speech gate: silent windows plus
+    /// silence trimmed ahead of speech.
+    uint64_t silent_samples;
+    /// Decoders the repetition guard stopped inside a loop.
+    uint64_t repetition_cutoffs;
+    /// Greedy windows decoded again with beam search; see
+    /// whisper_stream_set_adaptive_beam. Both passes count towards passes.
+    uint64_t beam_reruns;
+    /// Language detections run on auto-detect windows, and windows decoded
+    /// with the pinned language instead; see whisper_stream_set_language_cache.
+    uint64_t language_detections;
+    uint64_t language_reuses;
+    /// VAD-mode utterances ended by trailing silence, and the silence they
+    /// waited for, in samples; see whisper_stream_set_endpointing.
+    uint64_t endpoints;
+    uint64_t endpoint_silence_samples;
+    /// Speculative passes started at the first sign of silence, and those
+    /// whose text was returned at the endpoint instead of decoding again.
+    uint64_t endpoint_speculations;
+    uint64_t endpoint_speculation_hits;
+    /// Decoders the most recent pass allocated; see
+    /// whisper_stream_set_max_decoders.
+    uint64_t decoders;
+    /// Memory behind the stream's whisper_state, sized from the model shape
+    /// wherever the state lives (host or GPU). kv_self_bytes and
+    /// kv_cross_bytes are the text and cross-attention KV caches, kv_self for
+    /// the decoders of the most recent pass (0 before the first). state_bytes
+    /// is the KV caches the state currently holds; the compute buffers
+    /// whisper.cpp sizes per backend come on top and are not reported.
+    uint64_t state_bytes;
+    uint64_t kv_self_bytes;
+    uint64_t kv_cross_bytes;
+} whisper_stream_stats;
+
+/// One decoded text token. Times are milliseconds since the start of the
+/// stream; t0_ms/t1_ms need whisper_stream_set_token_timestamps and dtw_ms a
+/// model loaded with dtw_timestamps, otherwise they are
+/// WHISPER_STREAM_NO_TIMESTAMP.
+typedef struct whisper_stream_token {
+    /// Token piece, including its leading space when it starts a word.
+    const char *text;
+    int32_t text_len;
+    int32_t id;
+    float p;
+    int64_t t0_ms;
+    int64_t t1_ms;
+    int64_t dtw_ms;
+} whisper_stream_token;
+
+/// A timed span of the returned text, in milliseconds since stream start.
+typedef struct whisper_stream_segment {
+    const char *text;
+    int32_t text_len;
+    int64_t t0_ms;
+    int64_t t1_ms;
+    /// Mean probability of the segment's tokens.
+    float confidence;
+    int32_t n_tokens;
+    const whisper_stream_token *tokens;
+} whisper_stream_segment;
+
+/// Structured output of the *_ex entry points. The result and every string
+/// and array it points to live in one allocation released with
+/// whisper_stream_free_result.
+typedef struct whisper_stream_result {
+    /// Same text the plain entry point would return. Every string in the
+    /// result is NUL-terminated and also carries its length in bytes.
+    const char *text;
+    int32_t text_len;
+    float confidence;
+    int32_t n_segments;
+    /// False for a draft partial (see whisper_stream_set_draft_model), which
+    /// the next stable result replaces. Drafts carry no segments.
+    bool stable;
+    const whisper_stream_segment *segments;
+} whisper_stream_result;
+
+/// Loads model weights once so they can be shared by many streams.
+/// Each stream created from the model draws a private whisper_state from the
+/// model's state pool, so streams may run inference concurrently.
+/// Returns NULL on failure.
+whisper_stream_model *whisper_stream_model_load(const char *model_path,
+                                                bool use_gpu,
+                                                bool flash_attn);
+
+/// Releases the caller's reference to the model. Streams created from it keep
+/// the weights alive until they are freed.
+void whisper_stream_model_free(whisper_stream_model *model);
+
+/// Options for whisper_stream_model_load_with_params.
+typedef struct whisper_stream_model_params {
+    bool use_gpu;
+    bool flash_attn;
+    /// Computes DTW-aligned token times using the alignment heads that match
+    /// the model file; unknown architectures and flash attention leave them
+    /// disabled.
+    bool dtw_timestamps;
+    /// Backend device index the weights and states are placed on when use_gpu
+    /// is set.
+    int32_t gpu_device;
+} whisper_stream_model_params;
+
+/// GPU (device 0) and flash attention on, DTW off.
+whisper_stream_model_params whisper_stream_model_default_params(void);
+
+/// Same as whisper_stream_model_load with the options in params.
+whisper_stream_model *whisper_stream_model_load_with_params(const char *model_path,
+                                                            whisper_stream_model_params params);
+
+/// Loads whisper.cpp's Silero VAD model (e.g. ggml-silero-v5.1.2.bin) for
+/// WHISPER_STREAM_SPEECH_GATE_SILERO. Streams draw their own VAD context from
+/// a pool on the model. Returns 0 on success, negative value on error.
+int whisper_stream_model_load_vad(whisper_stream_model *model, const char *path, int32_t n_threads);
+
+/// Weight formats for whisper_stream_model_quantize; the values are ggml file
+/// types, as reported in whisper_stream_model_info.ftype.
+#define WHISPER_STREAM_FTYPE_F32 0
+#define WHISPER_STREAM_FTYPE_F16 1
+#define WHISPER_STREAM_FTYPE_Q8_0 7
+#define WHISPER_STREAM_FTYPE_Q5_0 8
+
+/// Memory footprint of a loaded model.
+typedef struct whisper_stream_model_info {
+    /// ggml file type of the weights (WHISPER_STREAM_FTYPE_*, or another
+    /// ggml quantization).
+    int32_t ftype;
+    /// Tensor data in the model file: the weights whisper.cpp keeps resident
+    /// in its backend buffers.
+    uint64_t weight_bytes;
+    /// Growth of the process's resident set while the model loaded, which
+    /// adds whisper.cpp's own buffers but misses weights placed on a GPU.
+    /// 0 where the resident set cannot be read (non-Linux hosts).
+    uint64_t resident_bytes;
+} whisper_stream_model_info;
+
+/// Fills info for model. Returns 0 on success, negative value on error.
+int whisper_stream_model_get_info(const whisper_stream_model *model, whisper_stream_model_info *info);
+
+/// Writes a copy of the f32/f16 ggml model at src_path to dst_path with its
+/// matrices quantized to ftype (WHISPER_STREAM_FTYPE_Q5_0 or _Q8_0), the
+/// same way whisper.cpp's quantize tool does. Rows are split across
+/// n_threads. The file appears at dst_path only once complete. Returns 0 on
+/// success, 1 when src_path is already quantized (nothing is written), or a
+/// negative value on error.
+int whisper_stream_model_quantize(const char *src_path, const char *dst_path, int32_t ftype, int32_t n_threads);
+
+/// Runs one inference pass over audio_ms of synthetic audio, so kernel
+/// compilation, compute buffer allocation and weight page-in happen before the
+/// first stream does. The warmed state returns to the model's pool for the
+/// next stream. Returns 0 on success, negative value on error.
+int whisper_stream_model_warmup(whisper_stream_model *model, int32_t audio_ms, int32_t n_threads);
+
+/// Creates a streaming context backed by a shared model.
+/// Parameters mirror whisper_stream_create; GPU settings come from the model.
+/// Returns NULL on failure.
+whisper_stream *whisper_stream_create_from_model(whisper_stream_model *model,
+                                                 int32_t step_ms,
+                                                 int32_t length_ms,
+                                                 int32_t keep_ms,
+                                                 int32_t threads,
+                                                 bool translate,
+                                                 float temperature_inc,
+                                                 bool disable_fallback,
+                                                 int32_t beam_size,
+                                                 int32_t audio_ctx,
+                                                 bool print_timestamps,
+                                                 bool print_special,
+                                                 bool keep_context,
+                                                 bool use_vad,
+                                                 float vad_thold,
+                                                 float freq_thold,
+                                                 int32_t max_tokens,
+                                                 bool tinydiarize);
+
+/// Creates a streaming Whisper context with a privately loaded model.
 /// @param translate If true, translate from source language to English
 /// @param temperature_inc Temperature increment for fallback (0.0 to disable)
 /// @param beam_size Beam size for beam search (use 1 for greedy sampling)
@@ -38,9 +272,16 @@ whisper_stream *whisper_stream_create(const char *model_path,
                                       int32_t max_tokens,
                                       bool tinydiarize);
 
-/// Releases all resources associated with the stream.
+/// Releases all resources associated with the stream and returns its
+/// whisper_state to the model pool.
 void whisper_stream_free(whisper_stream *stream);
 
+/// Returns the stream to its freshly created state for a new, unrelated
+/// audio stream: buffered audio, transcript, decoder context, the language
+/// hint and statistics are cleared, while settings, buffer capacity and the
+/// whisper_state (with its KV cache) are kept. Cheaper than free + create.
+int whisper_stream_reset(whisper_stream *stream);
+
 /// Feeds new audio samples (mono PCM float32) into the stream.
 /// On success:
 ///   - returns 1 when new text is available and sets out_text/confidence
@@ -52,15 +293,191 @@ int whisper_stream_process(whisper_stream *stream,
                            char **out_text,
                            float *out_confidence);
 
+/// Same as whisper_stream_process, but polls should_abort before the encoder
+/// runs and periodically while ggml computes. Returns WHISPER_STREAM_ERR_ABORTED
+/// when inference was cancelled; audio of the aborted window is discarded.
+/// should_abort may be NULL.
+int whisper_stream_process_abortable(whisper_stream *stream,
+                                     const float *samples,
+                                     int32_t sample_count,
+                                     char **out_text,
+                                     float *out_confidence,
+                                     whisper_stream_abort_callback should_abort,
+                                     void *abort_user_data);
+
+/// Feeds mono PCM16 little-endian samples, as carried on the wire, into the
+/// stream. Samples are converted straight into the stream's window buffer, so
+/// callers can pass their receive buffer without decoding it first; it need
+/// not be 2-byte aligned. Return values and abort handling match
+/// whisper_stream_process_abortable. should_abort may be NULL.
+int whisper_stream_process_s16(whisper_stream *stream,
+                               const int16_t *samples,
+                               int32_t sample_count,
+                               char **out_text,
+                               float *out_confidence,
+                               whisper_stream_abort_callback should_abort,
+                               void *abort_user_data);
+
+/// Buffers PCM16 samples like whisper_stream_process_s16 without running
+/// inference, so the caller can claim threads only once a window is due.
+/// Returns 1 when a window is ready for whisper_stream_step, 2 when only a
+/// draft pass is due (run it with whisper_stream_step_ex), 0 when more audio
+/// is required, negative value on failure.
+int whisper_stream_push_s16(whisper_stream *stream,
+                            const int16_t *samples,
+                            int32_t sample_count);
+
+/// Runs inference on the window buffered by whisper_stream_push_s16.
+/// Returns 0 without running inference when no window is ready; otherwise
+/// return values and abort handling match whisper_stream_process_abortable.
+int whisper_stream_step(whisper_stream *stream,
+                        char **out_text,
+                        float *out_confidence,
+                        whisper_stream_abort_callback should_abort,
+                        void *abort_user_data);
+
+/// Structured variants of whisper_stream_process_s16, whisper_stream_step and
+/// whisper_stream_flush_abortable: return values match, and on 1 out_result
+/// is set to the text together with its segments and tokens. Segments cover
+/// exactly the returned text, so a sliding-window step describes only the new
+/// tail of the window and a flush describes the whole transcript.
+int whisper_stream_process_ex(whisper_stream *stream,
+                              const int16_t *samples,
+                              int32_t sample_count,
+                              whisper_stream_result **out_result,
+                              whisper_stream_abort_callback should_abort,
+                              void *abort_user_data);
+
+int whisper_stream_step_ex(whisper_stream *stream,
+                           whisper_stream_result **out_result,
+                           whisper_stream_abort_callback should_abort,
+                           void *abort_user_data);
+
+int whisper_stream_flush_ex(whisper_stream *stream,
+                            whisper_stream_result **out_result,
+                            whisper_stream_abort_callback should_abort,
+                            void *abort_user_data);
+
+/// Transcribes a whole recording offline with the stream's decoding settings
+/// and language, leaving its streaming buffers untouched. The audio is split
+/// at silences into chunks of up to 28 s (overlapping hard cuts where speech
+/// runs on), the chunks decode in parallel on n_workers pooled states that
+/// share the stream's thread count, and their text is stitched in order.
+/// n_workers <= 0 picks one worker per 4 threads. Segment times are measured
+/// from the first sample. Returns 1 with *out_result set, 0 when nothing was
+/// recognised, or a negative error.
+int whisper_stream_transcribe_batch(whisper_stream *stream,
+                                    const int16_t *samples,
+                                    int32_t sample_count,
+                                    int32_t n_workers,
+                                    whisper_stream_result **out_result,
+                                    whisper_stream_abort_callback should_abort,
+                                    void *abort_user_data);
+
+/// Frees a result returned by the *_ex entry points. A no-op for results
+/// backed by the stream; see whisper_stream_set_reuse_results.
+void whisper_stream_free_result(whisper_stream_result *result);
+
+/// Makes the *_ex entry points build results in a buffer owned by the stream
+/// instead of a fresh allocation. Such a result stays valid until the next
+/// call on the stream and need not be freed. Returns 0 on success, negative
+/// value on error.
+int whisper_stream_set_reuse_results(whisper_stream *stream, bool enabled);
+
+/// Adds a draft tier decoded by draft_model, typically tiny or base. Between
+/// full passes the *_ex entry points decode the live audio with it every
+/// interval_ms and return the text past the last stable result as a draft
+/// (stable == false). The draft model must share the stream model's
+/// vocabulary; the mel cache serves both when their mel bins match. The
+/// stream keeps its own reference to draft_model; NULL removes the tier.
+/// Returns 0 on success, negative value on error.
+int whisper_stream_set_draft_model(whisper_stream *stream,
+                                   whisper_stream_model *draft_model,
+                                   int32_t interval_ms);
+
 /// Finalises the transcription and returns the full transcript.
 /// Returns negative value on failure.
 int whisper_stream_flush(whisper_stream *stream,
                          char **out_text,
                          float *out_confidence);
 
+/// Abort-aware variant of whisper_stream_flush; see whisper_stream_process_abortable.
+int whisper_stream_flush_abortable(whisper_stream *stream,
+                                   char **out_text,
+                                   float *out_confidence,
+                                   whisper_stream_abort_callback should_abort,
+                                   void *abort_user_data);
+
 /// Frees strings returned by process / flush.
 void whisper_stream_free_text(char *text);
 
+/// Stops a decoder once its text ends in a loop: an n-gram of up to 6 tokens
+/// repeated back to back min_repeats times (and over at least 8 tokens, so a
+/// single token needs 8 repeats). Only end-of-text is then sampleable, which
+/// closes the segment instead of decoding the loop to the token limit.
+/// min_repeats is clamped to [2, 16]; 0 disables the guard. Defaults to 4.
+/// Returns 0 on success, negative on error.
+int whisper_stream_set_repetition_guard(whisper_stream *stream, int32_t min_repeats);
+
+/// Runs the repetition guard's loop check on text tokens, oldest first, as
+/// whisper_stream_set_repetition_guard(min_repeats) would. Returns 1 when the
+/// tokens end in a loop, 0 otherwise.
+int whisper_stream_tokens_loop(const int32_t *tokens, int32_t n_tokens, int32_t min_repeats);
+
+/// Caches the language of an auto-detect stream. Once pin_windows windows
+/// in a row detect the same language with at least min_probability, later
+/// windows decode in that language without a detection pass. Every
+/// recheck_windows pinned windows (0 = never) detection runs again, and a
+/// confident different language unpins; so does a pinned window whose text
+/// decodes with low confidence. pin_windows 0 detects on every window.
+/// Defaults: 2 windows, 0.8, 20 windows. whisper_stream_set_language clears
+/// the pin. Returns 0 on success, negative on error.
+int whisper_stream_set_language_cache(whisper_stream *stream,
+                                      int32_t pin_windows,
+                                      float min_probability,
+                                      int32_t recheck_windows);
+
+/// Tunes when a VAD-mode utterance ends. The endpoint is silence_ms of
+/// trailing silence (default 1000); with adapt_ms > 0 the silence needed
+/// shrinks linearly to min_silence_ms as the utterance grows to adapt_ms, so
+/// long utterances finalise sooner. min_silence_ms <= 0 keeps silence_ms.
+/// Both are clamped to [100, 5000] ms, and the VAD window grows to twice
+/// silence_ms when that exceeds its 2000 ms. With speculative set, the
+/// buffered speech is decoded once 300 ms of silence appear, and the endpoint
+/// returns that text without another pass unless speech resumed in between.
+/// Changing the silence restarts detection on the audio that follows.
+/// Sliding-window streams ignore these settings. Returns 0 on success,
+/// negative on error.
+int whisper_stream_set_endpointing(whisper_stream *stream,
+                                   int32_t silence_ms,
+                                   int32_t min_silence_ms,
+                                   int32_t adapt_ms,
+                                   bool speculative);
+
+/// Gates sliding-window inference on speech. A window with under 250 ms of
+/// speech frames skips whisper_full, and a second or more of silence ahead of
+/// the first speech frame is trimmed before encoding. Draft passes are gated
+/// the same way. threshold <= 0 picks the gate's default (0.01 for ENERGY,
+/// 0.5 for SILERO). VAD mode (step_ms <= 0) decodes only detected utterances
+/// already and ignores the gate. Returns 0 on success, negative on error.
+int whisper_stream_set_speech_gate(whisper_stream *stream, int32_t kind, float threshold);
+
+/// Sets the thread count of the stream's following inference calls. When
+/// n_cpus > 0 those calls pin the calling thread, and so the ggml workers it
+/// starts, to cpus and restore its previous affinity on return; n_cpus == 0
+/// clears pinning. Pinning is skipped where thread affinity is unsupported.
+/// Returns 0 on success, negative value on error.
+int whisper_stream_set_threads(whisper_stream *stream,
+                               int32_t n_threads,
+                               const int32_t *cpus,
+                               int32_t n_cpus);
+
+/// Returns 1 when pinning through whisper_stream_set_threads reaches the ggml
+/// compute workers, 0 otherwise: thread affinity is unsupported, or ggml was
+/// built with OpenMP, whose persistent worker pool keeps the affinity its
+/// threads were created with.
+int whisper_stream_cpu_pinning_supported(void);
+
 /// Configures the language handling strategy.
 /// When detect_language is true, the model will auto-detect language regardless of hint.
 /// When detect_language is false and language is non-null, the provided hint is enforced.
@@ -69,6 +486,53 @@ int whisper_stream_set_language(whisper_stream *stream,
                                 const char *language,
                                 bool detect_language);
 
+/// Enables per-token t0/t1 estimates (whisper's token_timestamps), which also
+/// tighten segment bounds of sliding-window deltas. Returns 0 on success,
+/// negative value on error.
+int whisper_stream_set_token_timestamps(whisper_stream *stream, bool enabled);
+
+/// Switches the stream to an adaptive encoder context: each window is encoded
+/// with the smallest audio_ctx that covers it plus a safety margin, instead of
+/// the fixed audio_ctx given at creation. When the decoded text's mean token
+/// probability falls below min_confidence (0..1), the window is decoded again
+/// with the full context. Returns 0 on success, negative value on error.
+int whisper_stream_set_audio_ctx_auto(whisper_stream *stream,
+                                      bool enabled,
+                                      float min_confidence);
+
+/// Caps the decoders a pass allocates, each of which takes a full copy of the
+/// text KV cache. Without temperature fallback a greedy stream already runs a
+/// single decoder; with it, max_decoders bounds the candidates sampled per
+/// fallback (whisper's default is 5). Beam search needs max_decoders >=
+/// beam_size. 0 removes the cap. Returns 0 on success, negative value on
+/// error.
+int whisper_stream_set_max_decoders(whisper_stream *stream, int32_t max_decoders);
+
+/// Decodes each window greedily first and repeats it with the stream's beam
+/// search only when the greedy text's mean token probability falls below
+/// min_confidence (0..1). The repeat reuses the window's spectrogram but
+/// encodes again: whisper_full offers no way to keep the encoder output.
+/// Needs a stream created with beam_size > 1. Returns 0 on success, negative
+/// value on error.
+int whisper_stream_set_adaptive_beam(whisper_stream *stream, bool enabled, float min_confidence);
+
+/// Enables reuse of log-mel frames between overlapping sliding windows.
+/// The stream then computes the spectrogram itself, recomputing only frames
+/// over new audio or at the window edges, and snaps window starts to the
+/// 10 ms mel hop. Returns 0 on success, negative value when the stream uses
+/// VAD mode or the model file's mel filters could not be read.
+int whisper_stream_set_mel_cache(whisper_stream *stream, bool enabled);
+
+/// Copies the stream's cumulative mel cache counters into out.
+/// Returns 0 on success, negative value on error.
+int whisper_stream_get_mel_stats(const whisper_stream *stream,
+                                 whisper_stream_mel_stats *out);
+
+/// Copies the stream's stage timings and inference counters into out.
+/// Returns 0 on success, negative value on error.
+int whisper_stream_get_stats(const whisper_stream *stream,
+                             whisper_stream_stats *out);
+
 #ifdef __cplusplus
 }
 #endif
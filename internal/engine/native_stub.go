@@ -23,6 +23,12 @@ func (e *NativeEngine) Flush(ctx context.Context, opts Options) ([]Result, error
 	return nil, ErrNativeEngineUnavailable
 }
 
+func (e *NativeEngine) TranscribeBatch(ctx context.Context, audio []byte, opts Options) ([]Result, error) {
+	return nil, ErrNativeEngineUnavailable
+}
+
 func (e *NativeEngine) Close() error { return nil }
 
 func (e *NativeEngine) SetDefaultLanguage(string) {}
+
+func (e *NativeEngine) ThreadBudget() *ThreadBudget { return nil }
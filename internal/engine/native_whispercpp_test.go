@@ -11,6 +11,10 @@ import (
 	"path/filepath"
 	"strings"
 	"testing"
+	"time"
+	"unicode"
+
+	"github.com/nupi-ai/plugin-stt-local-whisper/internal/telemetry"
 )
 
 func TestNativeEngineTranscribesFixture(t *testing.T) {
@@ -158,6 +162,32 @@ func TestNativeEngineTranscribeSegmentRespectsContextCancellation(t *testing.T)
 	}
 }
 
+func TestNativeEngineAbortsInferenceOnCancellation(t *testing.T) {
+	if !NativeAvailable() {
+		t.Skip("native backend not available")
+	}
+
+	engine := openTestNativeEngine(t)
+	audio, _ := loadTestAudio(t)
+
+	ctx, cancel := context.WithCancel(context.Background())
+	time.AfterFunc(20*time.Millisecond, cancel)
+	defer cancel()
+
+	// A single large segment crosses n_samples_step and runs whisper_full.
+	_, err := engine.TranscribeSegment(ctx, audio, Options{Language: "en"})
+	if err == nil {
+		t.Skip("inference finished before cancellation")
+	}
+	if !errors.Is(err, context.Canceled) {
+		t.Fatalf("expected context cancellation, got %v", err)
+	}
+
+	if _, err := engine.Flush(context.Background(), Options{Language: "en"}); err != nil {
+		t.Fatalf("flush after aborted inference failed: %v", err)
+	}
+}
+
 func TestNativeEngineTrimsOversizedAudio(t *testing.T) {
 	if !NativeAvailable() {
 		t.Skip("native backend not available")
@@ -181,18 +211,408 @@ func TestNativeEngineTrimsOversizedAudio(t *testing.T) {
 	}
 }
 
+func TestNativeEngineSessionsAreIndependent(t *testing.T) {
+	if !NativeAvailable() {
+		t.Skip("native backend not available")
+	}
+
+	engine := openTestNativeEngine(t)
+	audio, _ := loadTestAudio(t)
+	ctx := context.Background()
+
+	const sessions = 2
+	finals := make([]string, sessions)
+	errs := make(chan error, sessions)
+
+	for i := 0; i < sessions; i++ {
+		go func(idx int) {
+			sess, err := engine.NewSession()
+			if err != nil {
+				errs <- fmt.Errorf("NewSession: %w", err)
+				return
+			}
+			defer sess.Close()
+
+			const chunkSize = 9600
+			for offset := 0; offset < len(audio); offset += chunkSize {
+				end := offset + chunkSize
+				if end > len(audio) {
+					end = len(audio)
+				}
+				if _, err := sess.TranscribeSegment(ctx, audio[offset:end], Options{Language: "en"}); err != nil {
+					errs <- fmt.Errorf("session %d TranscribeSegment: %w", idx, err)
+					return
+				}
+			}
+			results, err := sess.Flush(ctx, Options{Language: "en"})
+			if err != nil {
+				errs <- fmt.Errorf("session %d Flush: %w", idx, err)
+				return
+			}
+			if len(results) > 0 {
+				finals[idx] = strings.ToLower(results[len(results)-1].Text)
+			}
+			errs <- nil
+		}(i)
+	}
+
+	for i := 0; i < sessions; i++ {
+		if err := <-errs; err != nil {
+			t.Fatal(err)
+		}
+	}
+	for idx, final := range finals {
+		if !strings.Contains(final, "show me what you can do") {
+			t.Fatalf("session %d final transcript %q missing expected phrase", idx, final)
+		}
+	}
+}
+
+type melCacheCounter struct {
+	computed uint64
+	reused   uint64
+}
+
+func (c *melCacheCounter) RecordStages(telemetry.InferenceStages) {}
+
+func (c *melCacheCounter) RecordStartup(time.Duration, time.Duration, telemetry.ModelMemory) {}
+
+func (c *melCacheCounter) RecordMelCache(computed, reused uint64, _ time.Duration) {
+	c.computed += computed
+	c.reused += reused
+}
+
+func TestNativeEngineReusesReleasedSessions(t *testing.T) {
+	engine := openTestNativeEngine(t)
+	audio, _ := loadTestAudio(t)
+	ctx := context.Background()
+
+	transcribe := func() (Engine, string) {
+		t.Helper()
+		session, err := engine.Acquire()
+		if err != nil {
+			t.Fatalf("Acquire: %v", err)
+		}
+		if _, err := session.TranscribeSegment(ctx, audio, Options{Language: "en"}); err != nil {
+			t.Fatalf("TranscribeSegment: %v", err)
+		}
+		results, err := session.Flush(ctx, Options{Language: "en"})
+		if err != nil {
+			t.Fatalf("Flush: %v", err)
+		}
+		if len(results) == 0 {
+			t.Fatal("expected a final transcript")
+		}
+		return session, results[len(results)-1].Text
+	}
+
+	first, firstText := transcribe()
+	engine.Release(first)
+	second, secondText := transcribe()
+	defer engine.Release(second)
+	if second != first {
+		t.Fatal("expected the released session to be reused")
+	}
+	if secondText != firstText {
+		t.Fatalf("reset session transcribed differently: %q vs %q", secondText, firstText)
+	}
+}
+
+func TestNativeEngineMelCacheReusesFrames(t *testing.T) {
+	enabled := true
+	engine := openTestNativeEngineWithOptions(t, NativeOptions{MelCache: &enabled})
+	counter := &melCacheCounter{}
+	engine.SetObserver(counter)
+
+	audio, _ := loadTestAudio(t)
+	ctx := context.Background()
+	const chunkSize = 3200
+	for offset := 0; offset < len(audio); offset += chunkSize {
+		end := offset + chunkSize
+		if end > len(audio) {
+			end = len(audio)
+		}
+		if _, err := engine.TranscribeSegment(ctx, audio[offset:end], Options{Language: "en"}); err != nil {
+			t.Fatalf("TranscribeSegment: %v", err)
+		}
+	}
+	results, err := engine.Flush(ctx, Options{Language: "en"})
+	if err != nil {
+		t.Fatalf("Flush: %v", err)
+	}
+	if len(results) == 0 || !strings.Contains(strings.ToLower(results[len(results)-1].Text), "show me what you can do") {
+		t.Fatalf("unexpected transcript with mel cache: %+v", results)
+	}
+	if counter.computed == 0 || counter.reused == 0 {
+		t.Fatalf("expected mel frames to be computed and reused, got %+v", counter)
+	}
+}
+
+func TestNativeEngineReportsStageTimings(t *testing.T) {
+	engine := openTestNativeEngine(t)
+	recorder := telemetry.NewRecorder(nil)
+	engine.SetObserver(recorder)
+
+	audio, _ := loadTestAudio(t)
+	ctx := context.Background()
+	if _, err := engine.TranscribeSegment(ctx, audio, Options{Language: "en"}); err != nil {
+		t.Fatalf("TranscribeSegment: %v", err)
+	}
+	if _, err := engine.Flush(ctx, Options{Language: "en"}); err != nil {
+		t.Fatalf("Flush: %v", err)
+	}
+
+	snapshot := recorder.Snapshot()
+	if snapshot.TotalInferencePasses == 0 || snapshot.StageEncode.Count == 0 {
+		t.Fatalf("expected inference passes to be recorded, got %+v", snapshot)
+	}
+	if snapshot.StageEncode.Sum == 0 || snapshot.StageDecode.Sum == 0 {
+		t.Fatalf("expected encode and decode time, got encode=%v decode=%v",
+			snapshot.StageEncode.Sum, snapshot.StageDecode.Sum)
+	}
+	if snapshot.TotalTokens == 0 || snapshot.TotalWindowSamples == 0 {
+		t.Fatalf("expected tokens and window samples, got %+v", snapshot)
+	}
+}
+
+func TestNativeEngineReturnsTimedSegments(t *testing.T) {
+	enabled := true
+	engine := openTestNativeEngineWithOptions(t, NativeOptions{TokenTimestamps: &enabled})
+
+	audio, _ := loadTestAudio(t)
+	ctx := context.Background()
+	if _, err := engine.TranscribeSegment(ctx, audio, Options{Language: "en"}); err != nil {
+		t.Fatalf("TranscribeSegment: %v", err)
+	}
+	results, err := engine.Flush(ctx, Options{Language: "en"})
+	if err != nil {
+		t.Fatalf("Flush: %v", err)
+	}
+	if len(results) == 0 || len(results[0].Segments) == 0 {
+		t.Fatalf("expected a final result with segments, got %+v", results)
+	}
+
+	var last time.Duration
+	for i, seg := range results[0].Segments {
+		if seg.Start < last || seg.End < seg.Start {
+			t.Fatalf("segment %d out of order: start=%v end=%v previous end=%v", i, seg.Start, seg.End, last)
+		}
+		if len(seg.Tokens) == 0 {
+			t.Fatalf("segment %d has no tokens", i)
+		}
+		for j, tok := range seg.Tokens {
+			if tok.Start == NoTimestamp || tok.End < tok.Start {
+				t.Fatalf("segment %d token %d missing timestamps: %+v", i, j, tok)
+			}
+		}
+		last = seg.End
+	}
+}
+
+func TestNativeEngineEmitsDraftPartials(t *testing.T) {
+	modelRel := filepath.Join("testdata", "models", "ggml-base.en.bin")
+	draftPath := locateFixture(t, modelRel, "run `go run ./cmd/tools/models/download --variant base --dir testdata`")
+	interval := 250
+	engine := openTestNativeEngineWithOptions(t, NativeOptions{DraftModelPath: draftPath, DraftIntervalMs: &interval})
+
+	audio, _ := loadTestAudio(t)
+	ctx := context.Background()
+	const chunk = 16000 / 4 * 2 // 250 ms of PCM16
+	var drafts, stable int
+	for offset := 0; offset < len(audio); offset += chunk {
+		end := offset + chunk
+		if end > len(audio) {
+			end = len(audio)
+		}
+		results, err := engine.TranscribeSegment(ctx, audio[offset:end], Options{Language: "en"})
+		if err != nil {
+			t.Fatalf("TranscribeSegment: %v", err)
+		}
+		for _, res := range results {
+			if res.Draft {
+				drafts++
+			} else {
+				stable++
+			}
+		}
+	}
+	final, err := engine.Flush(ctx, Options{Language: "en"})
+	if err != nil {
+		t.Fatalf("Flush: %v", err)
+	}
+	if drafts == 0 {
+		t.Fatalf("expected draft partials between full passes (stable partials: %d)", stable)
+	}
+	if len(final) == 0 || final[0].Draft {
+		t.Fatalf("expected a stable final transcript, got %+v", final)
+	}
+}
+
+func TestNativeEngineTranscribesBatch(t *testing.T) {
+	workers := 2
+	engine := openTestNativeEngineWithOptions(t, NativeOptions{BatchWorkers: &workers})
+
+	audio, _ := loadTestAudio(t)
+	// Repeat the fixture so the recording spans several chunks.
+	recording := make([]byte, 0, len(audio)*8)
+	for i := 0; i < 8; i++ {
+		recording = append(recording, audio...)
+	}
+	results, err := engine.TranscribeBatch(context.Background(), recording, Options{Language: "en"})
+	if err != nil {
+		t.Fatalf("TranscribeBatch: %v", err)
+	}
+	if len(results) != 1 || !results[0].Final {
+		t.Fatalf("expected one final result, got %+v", results)
+	}
+	lower := strings.ToLower(results[0].Text)
+	if n := strings.Count(lower, "show me what you can do"); n < 6 {
+		t.Fatalf("batch transcript %q repeats the fixture phrase %d times, want about 8", results[0].Text, n)
+	}
+	var last time.Duration
+	for i, seg := range results[0].Segments {
+		if seg.Start < last {
+			t.Fatalf("segment %d starts at %v before segment %d at %v", i, seg.Start, i-1, last)
+		}
+		last = seg.Start
+	}
+}
+
+func TestNativeEngineSpeculativeEndpointKeepsTranscript(t *testing.T) {
+	plain, plainStats := transcribeUtterances(t, false)
+	speculative, speculativeStats := transcribeUtterances(t, true)
+
+	if plainStats.TotalEndpoints == 0 || speculativeStats.TotalEndpoints == 0 {
+		t.Fatalf("expected trailing silence to end utterances, got %d and %d endpoints",
+			plainStats.TotalEndpoints, speculativeStats.TotalEndpoints)
+	}
+	if plainStats.TotalSpeculations != 0 || plainStats.TotalSpeculationHits != 0 {
+		t.Fatalf("expected no speculation when it is disabled, got %+v", plainStats)
+	}
+	if speculativeStats.TotalSpeculationHits == 0 {
+		t.Fatalf("expected a speculative pass to be kept at the endpoint (speculations: %d)",
+			speculativeStats.TotalSpeculations)
+	}
+	if speculative != plain {
+		t.Fatalf("speculative endpointing changed the transcript: %q vs %q", speculative, plain)
+	}
+	if !strings.Contains(plain, "show me what you can do") {
+		t.Fatalf("unexpected VAD transcript %q", plain)
+	}
+}
+
+// transcribeUtterances streams the fixture in VAD mode, followed by enough
+// silence to end its last utterance, and returns the joined transcript in
+// lower case without punctuation together with the recorded telemetry.
+func transcribeUtterances(t *testing.T, speculative bool) (string, telemetry.Snapshot) {
+	t.Helper()
+	useVAD := true
+	silenceMs := 800
+	engine := openTestNativeEngineWithOptions(t, NativeOptions{
+		UseVAD:              &useVAD,
+		EndpointSilenceMs:   &silenceMs,
+		SpeculativeEndpoint: &speculative,
+	})
+	recorder := telemetry.NewRecorder(nil)
+	engine.SetObserver(recorder)
+
+	audio, _ := loadTestAudio(t)
+	audio = append(audio, make([]byte, 2*16000*2)...) // 2 s of silence
+	ctx := context.Background()
+	const chunkSize = 3200 // 100 ms of PCM16
+	var texts []string
+	for offset := 0; offset < len(audio); offset += chunkSize {
+		end := offset + chunkSize
+		if end > len(audio) {
+			end = len(audio)
+		}
+		results, err := engine.TranscribeSegment(ctx, audio[offset:end], Options{Language: "en"})
+		if err != nil {
+			t.Fatalf("TranscribeSegment: %v", err)
+		}
+		for _, res := range results {
+			texts = append(texts, res.Text)
+		}
+	}
+	results, err := engine.Flush(ctx, Options{Language: "en"})
+	if err != nil {
+		t.Fatalf("Flush: %v", err)
+	}
+	for _, res := range results {
+		texts = append(texts, res.Text)
+	}
+
+	words := strings.FieldsFunc(strings.ToLower(strings.Join(texts, " ")), func(r rune) bool {
+		return !unicode.IsLetter(r) && !unicode.IsDigit(r) && r != '\''
+	})
+	return strings.Join(words, " "), recorder.Snapshot()
+}
+
+func TestRepetitionGuardDetectsLoops(t *testing.T) {
+	repeat := func(ngram []int32, times int, tail ...int32) []int32 {
+		var tokens []int32
+		for i := 0; i < times; i++ {
+			tokens = append(tokens, ngram...)
+		}
+		return append(tokens, tail...)
+	}
+	cases := []struct {
+		name       string
+		tokens     []int32
+		minRepeats int
+		want       bool
+	}{
+		{"single token over the minimum span", repeat([]int32{7}, 8), 4, true},
+		{"single token under the minimum span", repeat([]int32{1, 2}, 1, repeat([]int32{7}, 7)...), 4, false},
+		{"trigram repeated enough", repeat([]int32{1, 2, 3}, 4), 4, true},
+		{"trigram repeated too few times", repeat([]int32{9}, 3, repeat([]int32{1, 2, 3}, 3)...), 4, false},
+		{"loop followed by new text", repeat([]int32{1, 2, 3}, 4, 4), 4, false},
+		{"n-gram longer than the guard scans", repeat([]int32{1, 2, 3, 4, 5, 6, 7}, 4), 4, false},
+		{"lower threshold", repeat([]int32{1, 2, 3, 4}, 2), 2, true},
+		{"guard disabled", repeat([]int32{7}, 16), 0, false},
+	}
+	for _, tc := range cases {
+		if got := tokensLoop(tc.tokens, tc.minRepeats); got != tc.want {
+			t.Errorf("%s: tokensLoop(%v, %d) = %v, want %v", tc.name, tc.tokens, tc.minRepeats, got, tc.want)
+		}
+	}
+}
+
 func TestNewNativeEngineRejectsEmptyPath(t *testing.T) {
 	if _, err := NewNativeEngine("", NativeOptions{}); err == nil {
 		t.Fatal("expected error for empty model path")
 	}
 }
 
+func TestNewNativeEngineRejectsUnknownPinning(t *testing.T) {
+	if _, err := NewNativeEngine("model.bin", NativeOptions{CPUPinning: "socket"}); err == nil {
+		t.Fatal("expected error for unknown cpu pinning policy")
+	}
+}
+
+func TestQuantizedModelPathRejectsUnknownFormat(t *testing.T) {
+	if _, err := quantizedModelPath("model.bin", "q4_k", t.TempDir(), 1); err == nil {
+		t.Fatal("expected error for unknown quantization")
+	}
+}
+
+func TestNewNativeEngineRejectsSileroWithoutModel(t *testing.T) {
+	if _, err := NewNativeEngine("model.bin", NativeOptions{SpeechGate: SpeechGateSilero}); err == nil {
+		t.Fatal("expected error for a silero speech gate without a VAD model path")
+	}
+}
+
 func openTestNativeEngine(tb testing.TB) *NativeEngine {
 	tb.Helper()
+	return openTestNativeEngineWithOptions(tb, NativeOptions{})
+}
+
+func openTestNativeEngineWithOptions(tb testing.TB, opts NativeOptions) *NativeEngine {
+	tb.Helper()
 
 	modelRel := filepath.Join("testdata", "models", "ggml-base.en.bin")
 	modelPath := locateFixture(tb, modelRel, "run `go run ./cmd/tools/models/download --variant base --dir testdata`")
-	eng, err := NewNativeEngine(modelPath, NativeOptions{})
+	eng, err := NewNativeEngine(modelPath, opts)
 	if err != nil {
 		tb.Fatalf("NewNativeEngine: %v", err)
 	}
@@ -0,0 +1,69 @@
+package engine
+
+import (
+	"sync"
+	"time"
+
+	"github.com/nupi-ai/plugin-stt-local-whisper/internal/telemetry"
+)
+
+// MelCacheObserver receives mel-spectrogram reuse counters after inference.
+type MelCacheObserver interface {
+	RecordMelCache(framesComputed, framesReused uint64, computeTime time.Duration)
+}
+
+// StageObserver receives the per-stage breakdown of each native call that
+// ran inference.
+type StageObserver interface {
+	RecordStages(telemetry.InferenceStages)
+}
+
+// StartupObserver receives the model load and warm-up time, and the loaded
+// model's memory footprint, once the engine is ready.
+type StartupObserver interface {
+	RecordStartup(load, warmup time.Duration, memory telemetry.ModelMemory)
+}
+
+// Observer collects runtime statistics from the native engine;
+// telemetry.Recorder implements it.
+type Observer interface {
+	MelCacheObserver
+	StageObserver
+	StartupObserver
+}
+
+// observerSetter is implemented by engines that can report runtime metrics
+// once a recorder is available.
+type observerSetter interface {
+	SetObserver(Observer)
+}
+
+// AttachObserver wires observer into eng when the engine reports runtime
+// metrics. It reports whether the engine accepted the observer.
+func AttachObserver(eng Engine, observer Observer) bool {
+	setter, ok := eng.(observerSetter)
+	if !ok {
+		return false
+	}
+	setter.SetObserver(observer)
+	return true
+}
+
+// observerSlot lets sessions created before an observer is attached pick it
+// up later.
+type observerSlot struct {
+	mu       sync.RWMutex
+	observer Observer
+}
+
+func (s *observerSlot) set(observer Observer) {
+	s.mu.Lock()
+	s.observer = observer
+	s.mu.Unlock()
+}
+
+func (s *observerSlot) get() Observer {
+	s.mu.RLock()
+	defer s.mu.RUnlock()
+	return s.observer
+}
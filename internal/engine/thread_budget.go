@@ -0,0 +1,192 @@
+package engine
+
+import (
+	"context"
+	"fmt"
+	"os"
+	"path/filepath"
+	"sort"
+	"strconv"
+	"strings"
+	"sync"
+)
+
+// CPU pinning policies accepted by NativeOptions.CPUPinning.
+const (
+	// CPUPinningNone leaves thread placement to the OS scheduler.
+	CPUPinningNone = "none"
+	// CPUPinningNUMA assigns each session to a NUMA node and pins its
+	// inference threads to that node's cores.
+	CPUPinningNUMA = "numa"
+)
+
+const numaSysfsDir = "/sys/devices/system/node"
+
+// ThreadBudget splits a fixed number of inference threads across the calls
+// running at once, so concurrent streams share the machine instead of each
+// starting a full set of ggml workers. Each session joins one pool: a single
+// unpinned pool by default, or one pool per NUMA node whose threads are
+// pinned to the node's CPUs. The threads claimed from a pool never add up to
+// more than its share.
+type ThreadBudget struct {
+	mu    sync.Mutex
+	pools []threadPool
+	freed chan struct{} // closed and replaced whenever a call returns threads
+}
+
+type threadPool struct {
+	cpus     []int32 // nil when the pool is not pinned
+	threads  int
+	sessions int
+	inflight int
+	claimed  int // threads held by the calls in flight
+}
+
+// NewThreadBudget shares threads between calls. With nodes, every node gets
+// a pinned pool whose share of threads is proportional to its CPU count.
+func NewThreadBudget(threads int, nodes [][]int32) *ThreadBudget {
+	if threads < 1 {
+		threads = 1
+	}
+	total := 0
+	for _, cpus := range nodes {
+		total += len(cpus)
+	}
+	b := &ThreadBudget{freed: make(chan struct{})}
+	for _, cpus := range nodes {
+		if len(cpus) == 0 {
+			continue
+		}
+		share := threads * len(cpus) / total
+		if share < 1 {
+			share = 1
+		}
+		b.pools = append(b.pools, threadPool{cpus: cpus, threads: share})
+	}
+	if len(b.pools) == 0 {
+		b.pools = []threadPool{{threads: threads}}
+	}
+	return b
+}
+
+// Join assigns a session to the pool with the fewest sessions and returns
+// the pool's index for Acquire and Leave.
+func (b *ThreadBudget) Join() int {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	best := 0
+	for i := range b.pools {
+		if b.pools[i].sessions < b.pools[best].sessions {
+			best = i
+		}
+	}
+	b.pools[best].sessions++
+	return best
+}
+
+// Leave removes a session from its pool.
+func (b *ThreadBudget) Leave(pool int) {
+	b.mu.Lock()
+	defer b.mu.Unlock()
+	if b.pools[pool].sessions > 0 {
+		b.pools[pool].sessions--
+	}
+}
+
+// Acquire claims threads from the pool for one inference call and returns
+// the CPUs to pin it to (nil when unpinned). A call gets an even share among
+// the pool's live sessions (or the calls in flight, when more), capped at what
+// the running calls left unclaimed; calls already running keep the share they
+// started with. When every thread is claimed it waits for one to be
+// returned, so the pool is never oversubscribed. The caller must invoke
+// release when the call returns.
+func (b *ThreadBudget) Acquire(ctx context.Context, pool int) (threads int, cpus []int32, release func(), err error) {
+	b.mu.Lock()
+	p := &b.pools[pool]
+	for p.claimed >= p.threads {
+		freed := b.freed
+		b.mu.Unlock()
+		select {
+		case <-freed:
+		case <-ctx.Done():
+			return 0, nil, nil, ctx.Err()
+		}
+		b.mu.Lock()
+	}
+	defer b.mu.Unlock()
+	p.inflight++
+	sharers := max(p.sessions, p.inflight)
+	threads = min(max(p.threads/sharers, 1), p.threads-p.claimed)
+	p.claimed += threads
+	return threads, p.cpus, func() {
+		b.mu.Lock()
+		defer b.mu.Unlock()
+		p.inflight--
+		p.claimed -= threads
+		close(b.freed)
+		b.freed = make(chan struct{})
+	}, nil
+}
+
+// Pools reports how many pools the budget has.
+func (b *ThreadBudget) Pools() int {
+	return len(b.pools)
+}
+
+// numaNodeCPUs lists the online CPUs of each NUMA node, or nil when the
+// topology is unavailable (non-Linux hosts, containers without sysfs).
+func numaNodeCPUs() [][]int32 {
+	dirs, err := filepath.Glob(filepath.Join(numaSysfsDir, "node[0-9]*"))
+	if err != nil || len(dirs) == 0 {
+		return nil
+	}
+	sort.Slice(dirs, func(i, j int) bool {
+		return nodeIndex(dirs[i]) < nodeIndex(dirs[j])
+	})
+	var nodes [][]int32
+	for _, dir := range dirs {
+		raw, err := os.ReadFile(filepath.Join(dir, "cpulist"))
+		if err != nil {
+			continue
+		}
+		cpus, err := parseCPUList(string(raw))
+		if err != nil || len(cpus) == 0 {
+			continue
+		}
+		nodes = append(nodes, cpus)
+	}
+	return nodes
+}
+
+func nodeIndex(dir string) int {
+	n, _ := strconv.Atoi(strings.TrimPrefix(filepath.Base(dir), "node"))
+	return n
+}
+
+// parseCPUList decodes the kernel's CPU list format, e.g. "0-3,8,10-11".
+func parseCPUList(list string) ([]int32, error) {
+	var cpus []int32
+	for _, part := range strings.Split(strings.TrimSpace(list), ",") {
+		if part == "" {
+			continue
+		}
+		lo, hi, isRange := strings.Cut(part, "-")
+		first, err := strconv.Atoi(lo)
+		if err != nil {
+			return nil, fmt.Errorf("engine: invalid cpu list %q: %w", list, err)
+		}
+		last := first
+		if isRange {
+			if last, err = strconv.Atoi(hi); err != nil {
+				return nil, fmt.Errorf("engine: invalid cpu list %q: %w", list, err)
+			}
+		}
+		if first < 0 || last < first {
+			return nil, fmt.Errorf("engine: invalid cpu range %q", part)
+		}
+		for cpu := first; cpu <= last; cpu++ {
+			cpus = append(cpus, int32(cpu))
+		}
+	}
+	return cpus, nil
+}
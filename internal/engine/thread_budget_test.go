@@ -0,0 +1,168 @@
+package engine
+
+import (
+	"context"
+	"errors"
+	"reflect"
+	"sync"
+	"testing"
+	"time"
+)
+
+func TestThreadBudgetSplitsConcurrentCalls(t *testing.T) {
+	b := NewThreadBudget(8, nil)
+	pool := b.Join()
+	ctx := context.Background()
+
+	first, cpus, releaseFirst, err := b.Acquire(ctx, pool)
+	if err != nil || first != 8 || cpus != nil {
+		t.Fatalf("a lone session should get every thread unpinned, got %d threads on %v (err %v)", first, cpus, err)
+	}
+	releaseFirst()
+
+	// Three live sessions: each call takes a third, and a fourth call in
+	// flight only gets what the first three left.
+	b.Join()
+	b.Join()
+	var claims []int
+	for i := 0; i < 3; i++ {
+		threads, _, release, err := b.Acquire(ctx, pool)
+		if err != nil {
+			t.Fatalf("Acquire returned error: %v", err)
+		}
+		defer release()
+		claims = append(claims, threads)
+	}
+	if want := []int{2, 2, 2}; !reflect.DeepEqual(claims, want) {
+		t.Fatalf("expected claims %v, got %v", want, claims)
+	}
+	fourth, _, releaseFourth, _ := b.Acquire(ctx, pool)
+	defer releaseFourth()
+	if fourth != 2 {
+		t.Fatalf("expected the remaining 2 threads, got %d", fourth)
+	}
+}
+
+func TestThreadBudgetSharesLongCallWithOtherReplicas(t *testing.T) {
+	// Two replicas draw from one budget, as EngineGroup wires them. A
+	// whole-file batch call on the first must leave threads for a live call
+	// on the second instead of holding the pool until the file is done.
+	b := NewThreadBudget(8, nil)
+	batchPool := b.Join()
+	livePool := b.Join()
+
+	batch, _, releaseBatch, err := b.Acquire(context.Background(), batchPool)
+	if err != nil {
+		t.Fatalf("Acquire returned error: %v", err)
+	}
+	defer releaseBatch()
+
+	ctx, cancel := context.WithTimeout(context.Background(), time.Second)
+	defer cancel()
+	live, _, releaseLive, err := b.Acquire(ctx, livePool)
+	if err != nil {
+		t.Fatalf("expected the live call to get threads while the batch runs, got %v", err)
+	}
+	defer releaseLive()
+	if batch != 4 || live != 4 {
+		t.Fatalf("expected an even 4/4 split, got batch %d and live %d", batch, live)
+	}
+}
+
+func TestThreadBudgetWaitsWhenExhausted(t *testing.T) {
+	b := NewThreadBudget(8, nil)
+	pool := b.Join()
+	_, _, release, _ := b.Acquire(context.Background(), pool)
+
+	ctx, cancel := context.WithTimeout(context.Background(), 20*time.Millisecond)
+	defer cancel()
+	if _, _, _, err := b.Acquire(ctx, pool); !errors.Is(err, context.DeadlineExceeded) {
+		t.Fatalf("expected a call to wait while every thread is claimed, got %v", err)
+	}
+
+	got := make(chan int, 1)
+	go func() {
+		threads, _, release, _ := b.Acquire(context.Background(), pool)
+		release()
+		got <- threads
+	}()
+	release()
+	if threads := <-got; threads != 8 {
+		t.Fatalf("expected the waiting call to get the returned threads, got %d", threads)
+	}
+}
+
+func TestThreadBudgetNeverOversubscribes(t *testing.T) {
+	const budget = 8
+	b := NewThreadBudget(budget, nil)
+	pool := b.Join()
+	b.Join()
+	b.Join()
+
+	var (
+		mu      sync.Mutex
+		claimed int
+		peak    int
+		wg      sync.WaitGroup
+	)
+	for i := 0; i < 32; i++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for j := 0; j < 50; j++ {
+				threads, _, release, err := b.Acquire(context.Background(), pool)
+				if err != nil || threads < 1 {
+					t.Errorf("Acquire returned %d threads (err %v)", threads, err)
+					return
+				}
+				mu.Lock()
+				claimed += threads
+				peak = max(peak, claimed)
+				mu.Unlock()
+				time.Sleep(50 * time.Microsecond)
+				mu.Lock()
+				claimed -= threads
+				mu.Unlock()
+				release()
+			}
+		}()
+	}
+	wg.Wait()
+	if peak > budget {
+		t.Fatalf("concurrent calls claimed %d threads, budget is %d", peak, budget)
+	}
+}
+
+func TestThreadBudgetBalancesNUMAPools(t *testing.T) {
+	nodes := [][]int32{{0, 1, 2, 3}, {4, 5, 6, 7}}
+	b := NewThreadBudget(8, nodes)
+	if b.Pools() != 2 {
+		t.Fatalf("expected one pool per node, got %d", b.Pools())
+	}
+	first, second := b.Join(), b.Join()
+	if first == second {
+		t.Fatalf("expected sessions spread across nodes, both joined pool %d", first)
+	}
+	threads, cpus, release, _ := b.Acquire(context.Background(), second)
+	defer release()
+	if threads != 4 || !reflect.DeepEqual(cpus, nodes[second]) {
+		t.Fatalf("expected 4 threads pinned to node %d, got %d on %v", second, threads, cpus)
+	}
+	b.Leave(first)
+	if third := b.Join(); third != first {
+		t.Fatalf("expected a new session on the emptier node %d, got %d", first, third)
+	}
+}
+
+func TestParseCPUList(t *testing.T) {
+	cpus, err := parseCPUList("0-2,8,10-11\n")
+	if err != nil {
+		t.Fatalf("parseCPUList returned error: %v", err)
+	}
+	if want := []int32{0, 1, 2, 8, 10, 11}; !reflect.DeepEqual(cpus, want) {
+		t.Fatalf("got %v, want %v", cpus, want)
+	}
+	if _, err := parseCPUList("3-1"); err == nil {
+		t.Fatal("expected a reversed range to be rejected")
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Returns the length of the longest prefix of current that occurs anywhere in
+// previous, i.e. the maximum over i of the common prefix of previous[i..] and
+// current. This is where new content starts when a sliding window re-decodes
+// audio the previous window already covered.
+//
+// Runs Knuth-Morris-Pratt with current as the pattern and previous as the
+// text, so the cost is O(|previous| + |current|). failure is scratch space
+// for the prefix function and is reused across calls.
+template <typename Token>
+size_t token_overlap(const std::vector<Token> &previous,
+                     const std::vector<Token> &current,
+                     std::vector<size_t> &failure) {
+    const size_t m = current.size();
+    if (previous.empty() || m == 0) {
+        return 0;
+    }
+
+    failure.resize(m);
+    failure[0] = 0;
+    for (size_t q = 1, k = 0; q < m; ++q) {
+        while (k > 0 && current[q] != current[k]) {
+            k = failure[k - 1];
+        }
+        if (current[q] == current[k]) {
+            k++;
+        }
+        failure[q] = k;
+    }
+
+    size_t best = 0;
+    size_t k = 0;
+    for (const Token &token : previous) {
+        while (k > 0 && token != current[k]) {
+            k = failure[k - 1];
+        }
+        if (token == current[k]) {
+            k++;
+        }
+        if (k > best) {
+            best = k;
+            if (best == m) {
+                break;
+            }
+        }
+    }
+    return best;
+}
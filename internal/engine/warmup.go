@@ -0,0 +1,19 @@
+package engine
+
+import (
+	"fmt"
+	"time"
+)
+
+// warmUp runs the engine's warm-up decodes in order and returns how long they
+// took. Each decode returns the native rc; the first failure stops the run and
+// is reported with a zero duration, since the model is still cold.
+func warmUp(decodes ...func() int) (time.Duration, error) {
+	start := time.Now()
+	for i, decode := range decodes {
+		if rc := decode(); rc < 0 {
+			return 0, fmt.Errorf("whisper: warm-up decode %d failed (%d)", i, rc)
+		}
+	}
+	return time.Since(start), nil
+}
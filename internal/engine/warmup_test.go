@@ -0,0 +1,37 @@
+package engine
+
+import (
+	"strings"
+	"testing"
+)
+
+func TestWarmUpRunsEveryDecode(t *testing.T) {
+	var ran []int
+	_, err := warmUp(
+		func() int { ran = append(ran, 0); return 0 },
+		func() int { ran = append(ran, 1); return 0 },
+	)
+	if err != nil {
+		t.Fatalf("warmUp returned error: %v", err)
+	}
+	if len(ran) != 2 {
+		t.Fatalf("expected both decodes to run, got %v", ran)
+	}
+}
+
+func TestWarmUpStopsAtFirstFailure(t *testing.T) {
+	draftRan := false
+	elapsed, err := warmUp(
+		func() int { return -2 },
+		func() int { draftRan = true; return 0 },
+	)
+	if err == nil || !strings.Contains(err.Error(), "(-2)") {
+		t.Fatalf("expected the native rc in the error, got %v", err)
+	}
+	if elapsed != 0 {
+		t.Fatalf("expected no warm-up time after a failure, got %v", elapsed)
+	}
+	if draftRan {
+		t.Fatal("expected decodes after the failure to be skipped")
+	}
+}
@@ -0,0 +1,227 @@
+package server
+
+import (
+	"context"
+	"errors"
+	"log/slog"
+	"sync"
+	"time"
+
+	"github.com/nupi-ai/plugin-stt-local-whisper/internal/engine"
+)
+
+const (
+	// pcmBytesPerMs is the size of one millisecond of 16 kHz mono s16le audio.
+	pcmBytesPerMs = 32
+	// defaultPipelineMaxLagMs is the queued audio tolerated when the config
+	// leaves pipeline_max_lag_ms unset.
+	defaultPipelineMaxLagMs = 1000
+)
+
+// segmentPipeline moves a live stream's inference off its receive path. The
+// handler queues each segment with submit, which never waits on the engine;
+// one worker transcribes the queue in order and hands the results back on
+// results for the handler to send. Once the queued audio exceeds maxLag the
+// worker merges the backlog into a single call, so a stream that fell behind
+// skips to its latest window instead of decoding stale steps.
+type segmentPipeline struct {
+	server   *Server
+	eng      engine.Engine
+	lang     string
+	priority engine.Priority
+	maxLag   int // queued bytes tolerated before the backlog is merged
+	log      *slog.Logger
+
+	ctx    context.Context
+	cancel context.CancelFunc
+
+	mu       sync.Mutex
+	queue    []pipelineJob
+	queued   int    // bytes in queue
+	carry    []byte // audio of a skipped step, sent with the next call
+	closing  bool   // no more submits; the worker exits once the queue is done
+	wake     chan struct{}
+	results  chan pipelineResults
+	finished chan struct{}
+}
+
+type pipelineJob struct {
+	audio    []byte
+	sequence uint64
+	final    bool
+	segments int // segments merged into this call
+}
+
+// pipelineResults carries one engine call's outcome back to the handler.
+type pipelineResults struct {
+	sequence uint64
+	final    bool
+	results  []engine.Result
+	elapsed  time.Duration
+	admitted bool // false when err came from admission control
+	err      error
+}
+
+func (s *Server) startPipeline(ctx context.Context, eng engine.Engine, lang string, priority engine.Priority, logger *slog.Logger) *segmentPipeline {
+	maxLag := defaultPipelineMaxLagMs * pcmBytesPerMs
+	if s.cfg.PipelineMaxLagMs != nil {
+		maxLag = *s.cfg.PipelineMaxLagMs * pcmBytesPerMs
+	}
+	p := &segmentPipeline{
+		server:   s,
+		eng:      eng,
+		lang:     lang,
+		priority: priority,
+		maxLag:   maxLag,
+		log:      logger,
+		wake:     make(chan struct{}, 1),
+		results:  make(chan pipelineResults, 1),
+		finished: make(chan struct{}),
+	}
+	p.ctx, p.cancel = context.WithCancel(ctx)
+	go p.run()
+	return p
+}
+
+// submit queues a segment's audio for transcription and returns at once.
+func (p *segmentPipeline) submit(audio []byte, sequence uint64, final bool) {
+	p.mu.Lock()
+	p.queue = append(p.queue, pipelineJob{audio: audio, sequence: sequence, final: final, segments: 1})
+	p.queued += len(audio)
+	p.mu.Unlock()
+	p.signal()
+}
+
+// drain stops intake and lets the worker finish the queue; the handler keeps
+// reading results until the channel closes.
+func (p *segmentPipeline) drain() {
+	p.mu.Lock()
+	p.closing = true
+	p.mu.Unlock()
+	p.signal()
+}
+
+// abort cancels the call in flight, drops the queue and waits for the worker
+// to exit. It returns the audio that was never transcribed.
+func (p *segmentPipeline) abort() []byte {
+	p.cancel()
+	<-p.finished
+	return p.leftover()
+}
+
+// leftover returns the audio the worker did not transcribe. It is only
+// meaningful once results has been closed.
+func (p *segmentPipeline) leftover() []byte {
+	p.mu.Lock()
+	defer p.mu.Unlock()
+	audio := p.carry
+	for _, job := range p.queue {
+		audio = append(audio, job.audio...)
+	}
+	p.carry, p.queue, p.queued = nil, nil, 0
+	return audio
+}
+
+func (p *segmentPipeline) signal() {
+	select {
+	case p.wake <- struct{}{}:
+	default:
+	}
+}
+
+func (p *segmentPipeline) run() {
+	defer close(p.finished)
+	defer close(p.results)
+	for {
+		job, ok := p.next()
+		if !ok {
+			return
+		}
+		release, err := p.server.admit(p.ctx, p.priority, !job.final)
+		if errors.Is(err, engine.ErrStepSkipped) {
+			// Queued past the max delay: fold this audio into the next
+			// segment so the stream skips ahead instead of falling behind.
+			p.mu.Lock()
+			p.carry = job.audio
+			p.mu.Unlock()
+			p.log.Debug("inference step merged into next segment", "sequence", job.sequence, "pending_bytes", len(job.audio))
+			continue
+		}
+		if err != nil {
+			p.deliver(pipelineResults{sequence: job.sequence, final: job.final, err: err})
+			return
+		}
+		start := time.Now()
+		results, err := p.eng.TranscribeSegment(p.ctx, job.audio, engine.Options{
+			Language: p.lang,
+			Final:    job.final,
+			Sequence: job.sequence,
+		})
+		release()
+		if !p.deliver(pipelineResults{sequence: job.sequence, final: job.final, results: results, elapsed: time.Since(start), admitted: true, err: err}) || err != nil {
+			return
+		}
+	}
+}
+
+// next waits for queued audio and returns the next call to make: the oldest
+// segment, or the whole backlog merged once it exceeds maxLag. A carried
+// skipped step waits for the segment after it. ok is false once the
+// pipeline is closing with nothing left to do, or aborted.
+func (p *segmentPipeline) next() (job pipelineJob, ok bool) {
+	for {
+		p.mu.Lock()
+		if p.ctx.Err() != nil {
+			p.mu.Unlock()
+			return pipelineJob{}, false
+		}
+		if len(p.queue) > 0 {
+			break
+		}
+		closing := p.closing
+		p.mu.Unlock()
+		if closing {
+			return pipelineJob{}, false
+		}
+		select {
+		case <-p.wake:
+		case <-p.ctx.Done():
+		}
+	}
+	defer p.mu.Unlock()
+
+	n := 1
+	if len(p.queue) > 1 && p.queued > p.maxLag {
+		n = len(p.queue)
+	}
+	job = p.queue[0]
+	if n > 1 || len(p.carry) > 0 {
+		merged := append(p.carry, job.audio...)
+		for _, next := range p.queue[1:n] {
+			merged = append(merged, next.audio...)
+			job.sequence = next.sequence
+			job.final = job.final || next.final
+			job.segments += next.segments
+		}
+		job.audio = merged
+		p.carry = nil
+	}
+	if n > 1 {
+		p.log.Debug("inference backlog coalesced", "segments", job.segments, "sequence", job.sequence, "bytes", len(job.audio))
+	}
+	for _, done := range p.queue[:n] {
+		p.queued -= len(done.audio)
+	}
+	p.queue = append(p.queue[:0], p.queue[n:]...)
+	return job, true
+}
+
+// deliver hands results to the handler unless the pipeline was aborted.
+func (p *segmentPipeline) deliver(res pipelineResults) bool {
+	select {
+	case p.results <- res:
+		return true
+	case <-p.ctx.Done():
+		return false
+	}
+}
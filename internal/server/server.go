@@ -8,6 +8,9 @@ import (
 	"strings"
 	"time"
 
+	"google.golang.org/grpc/codes"
+	"google.golang.org/grpc/status"
+
 	napv1 "github.com/nupi-ai/nupi/api/nap/v1"
 
 	"github.com/nupi-ai/plugin-stt-local-whisper/internal/adapterinfo"
@@ -24,6 +27,10 @@ type Server struct {
 	log     *slog.Logger
 	engine  engine.Engine
 	metrics *telemetry.Recorder
+
+	// admission bounds concurrent inference across streams; nil when
+	// admission control is disabled.
+	admission *engine.AdmissionQueue
 }
 
 // New returns a new Server instance.
@@ -37,7 +44,7 @@ func New(cfg config.Config, logger *slog.Logger, engine engine.Engine, metrics *
 	if metrics == nil {
 		metrics = telemetry.NewRecorder(logger)
 	}
-	return &Server{
+	s := &Server{
 		cfg: cfg,
 		log: logger.With(
 			"component", "server",
@@ -47,6 +54,23 @@ func New(cfg config.Config, logger *slog.Logger, engine engine.Engine, metrics *
 		engine:  engine,
 		metrics: metrics,
 	}
+	if cfg.AdmissionMaxInflight != nil && *cfg.AdmissionMaxInflight > 0 {
+		s.admission = newAdmissionQueue(cfg)
+		s.admission.SetObserver(metrics)
+	}
+	return s
+}
+
+func newAdmissionQueue(cfg config.Config) *engine.AdmissionQueue {
+	depth := 0
+	if cfg.AdmissionQueueDepth != nil {
+		depth = *cfg.AdmissionQueueDepth
+	}
+	var maxDelay time.Duration
+	if cfg.AdmissionMaxDelayMs != nil {
+		maxDelay = time.Duration(*cfg.AdmissionMaxDelayMs) * time.Millisecond
+	}
+	return engine.NewAdmissionQueue(*cfg.AdmissionMaxInflight, depth, maxDelay)
 }
 
 // StreamTranscription consumes PCM segments and emits stub transcripts that
@@ -60,6 +84,12 @@ func (s *Server) StreamTranscription(stream napv1.SpeechToTextService_StreamTran
 		streamID      string
 		lastSequence  uint64
 		streamLang    string // effective language for the entire stream
+		eng           engine.Engine
+		priority      engine.Priority
+		pendingAudio  []byte // batch audio, or live audio left for the flush
+		batchMode     bool   // buffer the whole stream and transcribe on flush
+		pipe          *segmentPipeline
+		pipeResults   <-chan pipelineResults // nil until a live segment arrives
 	)
 	ctx := stream.Context()
 	defer func() {
@@ -68,8 +98,40 @@ func (s *Server) StreamTranscription(stream napv1.SpeechToTextService_StreamTran
 		}
 	}()
 
+	// Receive on a separate goroutine so the stream keeps accepting audio
+	// while a segment is being transcribed.
+	received := make(chan receivedRequest)
+	stopReceiving := make(chan struct{})
+	defer close(stopReceiving)
+	go func() {
+		for {
+			req, err := stream.Recv()
+			select {
+			case received <- receivedRequest{req: req, err: err}:
+			case <-stopReceiving:
+				return
+			}
+			if err != nil {
+				return
+			}
+		}
+	}()
+
 	for {
-		req, err := stream.Recv()
+		var req *napv1.StreamTranscriptionRequest
+		select {
+		case msg := <-received:
+			req, err = msg.req, msg.err
+		case res, ok := <-pipeResults:
+			if !ok {
+				pipeResults = nil
+				continue
+			}
+			if err := s.sendPipelineResults(stream, pipe, res, streamLang, streamMetrics); err != nil {
+				return err
+			}
+			continue
+		}
 		if err != nil {
 			if errors.Is(err, io.EOF) || errors.Is(err, context.Canceled) {
 				if streamMetrics != nil {
@@ -78,8 +140,16 @@ func (s *Server) StreamTranscription(stream napv1.SpeechToTextService_StreamTran
 						var cancel context.CancelFunc
 						flushCtx, cancel = context.WithTimeout(context.Background(), 2*time.Second)
 						defer cancel()
+						if pipe != nil {
+							pendingAudio = pipe.abort()
+						}
+					} else if pipe != nil {
+						if err := s.drainPipeline(stream, pipe, streamLang, streamMetrics); err != nil {
+							return err
+						}
+						pendingAudio = pipe.leftover()
 					}
-					if flushErr := s.emitFlush(flushCtx, stream, sessionID, streamID, lastSequence, streamLang, streamMetrics, "stream closed"); flushErr != nil {
+					if flushErr := s.emitFlush(flushCtx, stream, eng, sessionID, streamID, lastSequence, streamLang, priority, pendingAudio, batchMode, streamMetrics, "stream closed"); flushErr != nil {
 						return flushErr
 					}
 				}
@@ -93,13 +163,28 @@ func (s *Server) StreamTranscription(stream napv1.SpeechToTextService_StreamTran
 		}
 
 		if !initLogged {
-			streamMetrics = s.metrics.StartStream(req.GetSessionId(), req.GetStreamId(), req.GetMetadata())
 			streamLang = resolveLanguage(s.cfg.Language, req.GetMetadata())
+			session, release, sessionErr := s.openSession(streamLang)
+			if sessionErr != nil {
+				s.log.Error("failed to open engine session", "error", sessionErr)
+				return sessionErr
+			}
+			defer release()
+			eng = session
+
+			streamMetrics = s.metrics.StartStream(req.GetSessionId(), req.GetStreamId(), req.GetMetadata())
+			batchMode = strings.EqualFold(strings.TrimSpace(req.GetMetadata()[engine.ModeMetadataKey]), engine.ModeBatch)
+			priority = engine.ParsePriority(req.GetMetadata()[engine.PriorityMetadataKey])
+			if _, ok := req.GetMetadata()[engine.PriorityMetadataKey]; batchMode && !ok {
+				priority = engine.PriorityBatch
+			}
 			s.log.Info("stream opened",
 				"session_id", req.GetSessionId(),
 				"stream_id", req.GetStreamId(),
 				"metadata", req.GetMetadata(),
 				"resolved_language", streamLang,
+				"priority", priority.String(),
+				"batch_mode", batchMode,
 			)
 			sessionID = req.GetSessionId()
 			streamID = req.GetStreamId()
@@ -113,44 +198,38 @@ func (s *Server) StreamTranscription(stream napv1.SpeechToTextService_StreamTran
 			lastSequence = sequence
 		}
 
-		if segment != nil && len(segment.GetAudio()) > 0 {
-			logEntry := s.log.With(
-				"session_id", req.GetSessionId(),
-				"stream_id", req.GetStreamId(),
-				"sequence", sequence,
-				"final_requested", req.GetFlush() || segment.GetLast(),
-			)
+		if batchMode && segment != nil && len(segment.GetAudio()) > 0 {
+			// Batch streams only decode once the recording is complete.
 			if streamMetrics != nil {
 				streamMetrics.RecordSegment(sequence, len(segment.GetAudio()), req.GetFlush() || segment.GetLast())
 			}
-			start := time.Now()
-			results, err := s.engine.TranscribeSegment(ctx, segment.GetAudio(), engine.Options{
-				Language: streamLang,
-				Final:    req.GetFlush() || segment.GetLast(),
-				Sequence: sequence,
-			})
-			if err != nil {
-				logEntry.Error("engine segment failure", "error", err, "context_err", ctx.Err())
-				return err
-			}
+			pendingAudio = append(pendingAudio, segment.GetAudio()...)
+		} else if segment != nil && len(segment.GetAudio()) > 0 {
+			final := req.GetFlush() || segment.GetLast()
 			if streamMetrics != nil {
-				streamMetrics.RecordInferenceDuration(time.Since(start))
-			}
-			for idx, res := range results {
-				logEntry.Info("engine segment result",
-					"index", idx,
-					"text", res.Text,
-					"confidence", res.Confidence,
-					"final", res.Final,
-				)
+				streamMetrics.RecordSegment(sequence, len(segment.GetAudio()), final)
 			}
-			if err := s.sendResults(stream, sequence, results, streamLang, streamMetrics); err != nil {
-				return err
+			if pipe == nil {
+				// The session is released by an earlier defer, so the worker
+				// is stopped before the session goes back to its pool.
+				pipe = s.startPipeline(ctx, eng, streamLang, priority, s.log.With(
+					"session_id", sessionID,
+					"stream_id", streamID,
+				))
+				pipeResults = pipe.results
+				defer pipe.abort()
 			}
+			pipe.submit(segment.GetAudio(), sequence, final)
 		}
 
 		if req.GetFlush() {
-			if err := s.emitFlush(ctx, stream, req.GetSessionId(), req.GetStreamId(), sequence, streamLang, streamMetrics, "stream flushed"); err != nil {
+			if pipe != nil {
+				if err := s.drainPipeline(stream, pipe, streamLang, streamMetrics); err != nil {
+					return err
+				}
+				pendingAudio = pipe.leftover()
+			}
+			if err := s.emitFlush(ctx, stream, eng, req.GetSessionId(), req.GetStreamId(), sequence, streamLang, priority, pendingAudio, batchMode, streamMetrics, "stream flushed"); err != nil {
 				return err
 			}
 			return nil
@@ -158,12 +237,120 @@ func (s *Server) StreamTranscription(stream napv1.SpeechToTextService_StreamTran
 	}
 }
 
+type receivedRequest struct {
+	req *napv1.StreamTranscriptionRequest
+	err error
+}
+
+// drainPipeline waits for the pipeline to transcribe its queue and sends the
+// remaining results.
+func (s *Server) drainPipeline(
+	stream napv1.SpeechToTextService_StreamTranscriptionServer,
+	pipe *segmentPipeline,
+	lang string,
+	metrics *telemetry.StreamMetrics,
+) error {
+	pipe.drain()
+	for res := range pipe.results {
+		if err := s.sendPipelineResults(stream, pipe, res, lang, metrics); err != nil {
+			return err
+		}
+	}
+	return nil
+}
+
+// sendPipelineResults reports one pipelined engine call and sends its
+// results; a failed call ends the stream with its error.
+func (s *Server) sendPipelineResults(
+	stream napv1.SpeechToTextService_StreamTranscriptionServer,
+	pipe *segmentPipeline,
+	res pipelineResults,
+	lang string,
+	metrics *telemetry.StreamMetrics,
+) error {
+	logEntry := pipe.log.With(
+		"sequence", res.sequence,
+		"final_requested", res.final,
+	)
+	if res.err != nil {
+		if !res.admitted {
+			logEntry.Warn("inference call not admitted", "error", res.err, "priority", pipe.priority.String())
+		} else {
+			logEntry.Error("engine segment failure", "error", res.err, "context_err", stream.Context().Err())
+		}
+		return res.err
+	}
+	if metrics != nil {
+		metrics.RecordInferenceDuration(res.elapsed)
+	}
+	for idx, r := range res.results {
+		logEntry.Info("engine segment result",
+			"index", idx,
+			"text", r.Text,
+			"confidence", r.Confidence,
+			"final", r.Final,
+		)
+	}
+	return s.sendResults(stream, res.sequence, res.results, lang, metrics)
+}
+
+// openSession returns the engine serving a single stream. Engines that can
+// isolate decoding state hand out a dedicated session; others are shared.
+// Engines that route by language, such as an engine group, place the session
+// on a model serving lang. Pooled sessions go back to their pool when the
+// stream ends.
+func (s *Server) openSession(lang string) (engine.Engine, func(), error) {
+	var (
+		session engine.Engine
+		err     error
+	)
+	if router, ok := s.engine.(engine.LanguageSessionFactory); ok {
+		session, err = router.NewSessionForLanguage(lang)
+	} else if pool, ok := s.engine.(engine.SessionPool); ok {
+		session, err = pool.Acquire()
+		if err != nil {
+			return nil, nil, err
+		}
+		return session, func() { pool.Release(session) }, nil
+	} else if factory, ok := s.engine.(engine.SessionFactory); ok {
+		session, err = factory.NewSession()
+	} else {
+		return s.engine, func() {}, nil
+	}
+	if err != nil {
+		return nil, nil, err
+	}
+	return session, func() {
+		if err := session.Close(); err != nil {
+			s.log.Warn("failed to close engine session", "error", err)
+		}
+	}, nil
+}
+
+// admit waits for an inference slot when admission control is enabled.
+// Overload surfaces as a retriable Unavailable status; ErrStepSkipped and
+// context errors are returned unchanged.
+func (s *Server) admit(ctx context.Context, priority engine.Priority, mergeable bool) (func(), error) {
+	if s.admission == nil {
+		return func() {}, nil
+	}
+	release, err := s.admission.Acquire(ctx, priority, mergeable)
+	if errors.Is(err, engine.ErrQueueFull) || errors.Is(err, engine.ErrQueueTimeout) {
+		return nil, status.Errorf(codes.Unavailable, "%s inference queue overloaded, retry later: %v", priority, err)
+	}
+	return release, err
+}
+
 func (s *Server) emitFlush(
 	ctx context.Context,
 	stream napv1.SpeechToTextService_StreamTranscriptionServer,
+	eng engine.Engine,
 	sessionID, streamID string,
 	sequence uint64,
 	lang string,
+	priority engine.Priority,
+	pendingAudio []byte,
+	batch bool,
 	metrics *telemetry.StreamMetrics,
 	reason string,
 ) error {
@@ -175,12 +362,39 @@ func (s *Server) emitFlush(
 	if metrics != nil {
 		metrics.RecordFlush()
 	}
-	start := time.Now()
-	results, err := s.engine.Flush(ctx, engine.Options{Language: lang, Final: true})
+	release, err := s.admit(ctx, priority, false)
 	if err != nil {
-		logEntry.Error("engine flush failure", "error", err, "context_err", ctx.Err())
+		logEntry.Warn("flush not admitted", "error", err, "priority", priority.String())
 		return err
 	}
+	start := time.Now()
+	var results []engine.Result
+	if transcriber, ok := eng.(engine.BatchTranscriber); ok && batch && len(pendingAudio) > 0 {
+		results, err = transcriber.TranscribeBatch(ctx, pendingAudio, engine.Options{Language: lang, Final: true, Sequence: sequence})
+		release()
+		if err != nil {
+			logEntry.Error("engine batch failure", "error", err, "context_err", ctx.Err())
+			return err
+		}
+	} else {
+		// Audio from steps skipped under load, or a batch stream on an engine
+		// without batch support, still belongs in the transcript.
+		if len(pendingAudio) > 0 {
+			results, err = eng.TranscribeSegment(ctx, pendingAudio, engine.Options{Language: lang, Sequence: sequence})
+			if err != nil {
+				release()
+				logEntry.Error("engine segment failure", "error", err, "context_err", ctx.Err())
+				return err
+			}
+		}
+		flushed, err := eng.Flush(ctx, engine.Options{Language: lang, Final: true})
+		release()
+		results = append(results, flushed...)
+		if err != nil {
+			logEntry.Error("engine flush failure", "error", err, "context_err", ctx.Err())
+			return err
+		}
+	}
 	if metrics != nil {
 		metrics.RecordInferenceDuration(time.Since(start))
 	}
@@ -230,6 +444,11 @@ func (s *Server) sendResults(stream napv1.SpeechToTextService_StreamTranscriptio
 			Final:      res.Final,
 			Metadata:   adapterinfo.TranscriptMetadata(s.cfg.ModelVariant, resolvedLang),
 		}
+		if res.Draft {
+			// Transcript has no stability field; clients replace a draft
+			// with the next transcript that lacks this marker.
+			transcript.Metadata["stability"] = "draft"
+		}
 		if err := stream.Send(transcript); err != nil {
 			s.log.Error("failed to send transcript", "error", err)
 			return err
@@ -3,15 +3,19 @@ package server_test
 import (
 	"context"
 	"errors"
+	"fmt"
 	"io"
 	"log/slog"
 	"net"
 	"strings"
+	"sync"
 	"testing"
 	"time"
 
 	"google.golang.org/grpc"
+	"google.golang.org/grpc/codes"
 	"google.golang.org/grpc/credentials/insecure"
+	"google.golang.org/grpc/status"
 	"google.golang.org/grpc/test/bufconn"
 
 	napv1 "github.com/nupi-ai/nupi/api/nap/v1"
@@ -246,3 +250,474 @@ func TestStreamTranscriptionFlushOnCancel(t *testing.T) {
 		t.Fatalf("expected EOF after final transcript, got %v", err)
 	}
 }
+
+type sessionCountingEngine struct {
+	*engine.StubEngine
+
+	mu     sync.Mutex
+	opened int
+	closed int
+}
+
+func (e *sessionCountingEngine) NewSession() (engine.Engine, error) {
+	e.mu.Lock()
+	e.opened++
+	e.mu.Unlock()
+	return &countedSession{StubEngine: engine.NewStubEngine(nil, "small"), parent: e}, nil
+}
+
+type countedSession struct {
+	*engine.StubEngine
+	parent *sessionCountingEngine
+}
+
+func (s *countedSession) Close() error {
+	s.parent.mu.Lock()
+	s.parent.closed++
+	s.parent.mu.Unlock()
+	return nil
+}
+
+func TestStreamTranscriptionUsesSessionPerStream(t *testing.T) {
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+
+	lis := bufconn.Listen(bufSize)
+	defer lis.Close()
+
+	grpcServer := grpc.NewServer()
+	t.Cleanup(grpcServer.Stop)
+
+	cfg := config.Config{
+		ListenAddr:   "bufconn",
+		ModelVariant: "small",
+		Language:     "pl",
+	}
+	logger := slog.New(slog.NewTextHandler(io.Discard, nil))
+	eng := &sessionCountingEngine{StubEngine: engine.NewStubEngine(logger, cfg.ModelVariant)}
+	napv1.RegisterSpeechToTextServiceServer(grpcServer, server.New(cfg, logger, eng, telemetry.NewRecorder(logger)))
+
+	go func() {
+		_ = grpcServer.Serve(lis)
+	}()
+
+	conn, err := grpc.DialContext(ctx, "bufconn",
+		grpc.WithContextDialer(func(context.Context, string) (net.Conn, error) {
+			return lis.Dial()
+		}),
+		grpc.WithTransportCredentials(insecure.NewCredentials()),
+	)
+	if err != nil {
+		t.Fatalf("DialContext error: %v", err)
+	}
+	t.Cleanup(func() { conn.Close() })
+
+	client := napv1.NewSpeechToTextServiceClient(conn)
+	for i, audio := range [][]byte{[]byte("abcd"), []byte("abcdefgh")} {
+		stream, err := client.StreamTranscription(ctx)
+		if err != nil {
+			t.Fatalf("StreamTranscription error: %v", err)
+		}
+		if err := stream.Send(&napv1.StreamTranscriptionRequest{
+			SessionId: "session-1",
+			StreamId:  "mic",
+			Segment:   &napv1.Segment{Sequence: 1, Audio: audio},
+			Flush:     true,
+		}); err != nil {
+			t.Fatalf("Send error: %v", err)
+		}
+		if err := stream.CloseSend(); err != nil {
+			t.Fatalf("CloseSend error: %v", err)
+		}
+
+		var final string
+		for {
+			resp, err := stream.Recv()
+			if err == io.EOF {
+				break
+			}
+			if err != nil {
+				t.Fatalf("Recv error: %v", err)
+			}
+			if resp.GetFinal() {
+				final = resp.GetText()
+			}
+		}
+		// Each stream sees only its own audio, so totals never accumulate across streams.
+		if want := fmt.Sprintf("[stub:small] total bytes %d", len(audio)); final != want {
+			t.Fatalf("stream %d: unexpected final transcript %q, want %q", i, final, want)
+		}
+	}
+
+	eng.mu.Lock()
+	defer eng.mu.Unlock()
+	if eng.opened != 2 || eng.closed != 2 {
+		t.Fatalf("expected 2 sessions opened and closed, got opened=%d closed=%d", eng.opened, eng.closed)
+	}
+}
+
+type draftingEngine struct {
+	*engine.StubEngine
+}
+
+func (e *draftingEngine) TranscribeSegment(context.Context, []byte, engine.Options) ([]engine.Result, error) {
+	return []engine.Result{
+		{Text: "hel", Draft: true},
+		{Text: "hello"},
+	}, nil
+}
+
+func TestStreamTranscriptionMarksDraftPartials(t *testing.T) {
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+
+	lis := bufconn.Listen(bufSize)
+	defer lis.Close()
+
+	grpcServer := grpc.NewServer()
+	t.Cleanup(grpcServer.Stop)
+
+	cfg := config.Config{
+		ListenAddr:   "bufconn",
+		ModelVariant: "small",
+		Language:     "pl",
+	}
+	logger := slog.New(slog.NewTextHandler(io.Discard, nil))
+	eng := &draftingEngine{StubEngine: engine.NewStubEngine(logger, cfg.ModelVariant)}
+	napv1.RegisterSpeechToTextServiceServer(grpcServer, server.New(cfg, logger, eng, telemetry.NewRecorder(logger)))
+
+	go func() {
+		_ = grpcServer.Serve(lis)
+	}()
+
+	conn, err := grpc.DialContext(ctx, "bufconn",
+		grpc.WithContextDialer(func(context.Context, string) (net.Conn, error) {
+			return lis.Dial()
+		}),
+		grpc.WithTransportCredentials(insecure.NewCredentials()),
+	)
+	if err != nil {
+		t.Fatalf("DialContext error: %v", err)
+	}
+	t.Cleanup(func() { conn.Close() })
+
+	client := napv1.NewSpeechToTextServiceClient(conn)
+	stream, err := client.StreamTranscription(ctx)
+	if err != nil {
+		t.Fatalf("StreamTranscription error: %v", err)
+	}
+	if err := stream.Send(&napv1.StreamTranscriptionRequest{
+		SessionId: "session-1",
+		StreamId:  "mic",
+		Segment:   &napv1.Segment{Sequence: 1, Audio: []byte("abcd")},
+	}); err != nil {
+		t.Fatalf("Send error: %v", err)
+	}
+
+	draft, err := stream.Recv()
+	if err != nil {
+		t.Fatalf("Recv draft error: %v", err)
+	}
+	if draft.GetText() != "hel" || draft.GetMetadata()["stability"] != "draft" {
+		t.Fatalf("expected draft partial, got text=%q metadata=%v", draft.GetText(), draft.GetMetadata())
+	}
+	partial, err := stream.Recv()
+	if err != nil {
+		t.Fatalf("Recv partial error: %v", err)
+	}
+	if _, ok := partial.GetMetadata()["stability"]; ok || partial.GetText() != "hello" {
+		t.Fatalf("expected unmarked stable partial, got text=%q metadata=%v", partial.GetText(), partial.GetMetadata())
+	}
+	if err := stream.CloseSend(); err != nil {
+		t.Fatalf("CloseSend error: %v", err)
+	}
+}
+
+// blockingEngine holds every TranscribeSegment call until unblock is closed.
+type blockingEngine struct {
+	*engine.StubEngine
+	entered chan struct{}
+	unblock chan struct{}
+}
+
+func (e *blockingEngine) TranscribeSegment(ctx context.Context, audio []byte, opts engine.Options) ([]engine.Result, error) {
+	e.entered <- struct{}{}
+	<-e.unblock
+	return e.StubEngine.TranscribeSegment(ctx, audio, opts)
+}
+
+func TestStreamTranscriptionShedsBatchUnderLoad(t *testing.T) {
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+
+	lis := bufconn.Listen(bufSize)
+	defer lis.Close()
+
+	grpcServer := grpc.NewServer()
+	t.Cleanup(grpcServer.Stop)
+
+	maxInflight, maxDelayMs := 1, 20
+	cfg := config.Config{
+		ListenAddr:           "bufconn",
+		ModelVariant:         "small",
+		Language:             "pl",
+		AdmissionMaxInflight: &maxInflight,
+		AdmissionMaxDelayMs:  &maxDelayMs,
+	}
+	logger := slog.New(slog.NewTextHandler(io.Discard, nil))
+	eng := &blockingEngine{
+		StubEngine: engine.NewStubEngine(logger, cfg.ModelVariant),
+		entered:    make(chan struct{}, 2),
+		unblock:    make(chan struct{}),
+	}
+	recorder := telemetry.NewRecorder(logger)
+	napv1.RegisterSpeechToTextServiceServer(grpcServer, server.New(cfg, logger, eng, recorder))
+
+	go func() {
+		_ = grpcServer.Serve(lis)
+	}()
+
+	conn, err := grpc.DialContext(ctx, "bufconn",
+		grpc.WithContextDialer(func(context.Context, string) (net.Conn, error) {
+			return lis.Dial()
+		}),
+		grpc.WithTransportCredentials(insecure.NewCredentials()),
+	)
+	if err != nil {
+		t.Fatalf("DialContext error: %v", err)
+	}
+	t.Cleanup(func() { conn.Close() })
+	client := napv1.NewSpeechToTextServiceClient(conn)
+
+	live, err := client.StreamTranscription(ctx)
+	if err != nil {
+		t.Fatalf("StreamTranscription error: %v", err)
+	}
+	if err := live.Send(&napv1.StreamTranscriptionRequest{
+		SessionId: "session-1",
+		StreamId:  "mic",
+		Segment:   &napv1.Segment{Sequence: 1, Audio: []byte("abcd")},
+	}); err != nil {
+		t.Fatalf("Send live error: %v", err)
+	}
+	<-eng.entered
+
+	batch, err := client.StreamTranscription(ctx)
+	if err != nil {
+		t.Fatalf("StreamTranscription error: %v", err)
+	}
+	if err := batch.Send(&napv1.StreamTranscriptionRequest{
+		SessionId: "session-2",
+		StreamId:  "file",
+		Metadata:  map[string]string{engine.PriorityMetadataKey: "batch"},
+		Segment:   &napv1.Segment{Sequence: 1, Audio: []byte("abcd")},
+	}); err != nil {
+		t.Fatalf("Send batch error: %v", err)
+	}
+	if _, err := batch.Recv(); status.Code(err) != codes.Unavailable {
+		t.Fatalf("expected Unavailable for the queued batch stream, got %v", err)
+	}
+
+	close(eng.unblock)
+	if _, err := live.Recv(); err != nil {
+		t.Fatalf("Recv live error: %v", err)
+	}
+	if err := live.CloseSend(); err != nil {
+		t.Fatalf("CloseSend error: %v", err)
+	}
+	if got := recorder.Snapshot().TotalRejected; got != 1 {
+		t.Fatalf("expected one rejected call, got %d", got)
+	}
+}
+
+// batchEngine records which entry point served a stream.
+type batchEngine struct {
+	*engine.StubEngine
+	mu           sync.Mutex
+	segmentCalls int
+	batchAudio   []byte
+}
+
+func (e *batchEngine) TranscribeSegment(ctx context.Context, audio []byte, opts engine.Options) ([]engine.Result, error) {
+	e.mu.Lock()
+	e.segmentCalls++
+	e.mu.Unlock()
+	return e.StubEngine.TranscribeSegment(ctx, audio, opts)
+}
+
+func (e *batchEngine) TranscribeBatch(ctx context.Context, audio []byte, opts engine.Options) ([]engine.Result, error) {
+	e.mu.Lock()
+	e.batchAudio = append([]byte(nil), audio...)
+	e.mu.Unlock()
+	return []engine.Result{{Text: fmt.Sprintf("batch %d bytes", len(audio)), Confidence: 0.9, Final: true}}, nil
+}
+
+func TestStreamTranscriptionBatchMode(t *testing.T) {
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+
+	lis := bufconn.Listen(bufSize)
+	defer lis.Close()
+
+	grpcServer := grpc.NewServer()
+	t.Cleanup(grpcServer.Stop)
+
+	cfg := config.Config{
+		ListenAddr:   "bufconn",
+		ModelVariant: "small",
+		Language:     "pl",
+	}
+	logger := slog.New(slog.NewTextHandler(io.Discard, nil))
+	eng := &batchEngine{StubEngine: engine.NewStubEngine(logger, cfg.ModelVariant)}
+	napv1.RegisterSpeechToTextServiceServer(grpcServer, server.New(cfg, logger, eng, telemetry.NewRecorder(logger)))
+
+	go func() {
+		_ = grpcServer.Serve(lis)
+	}()
+
+	conn, err := grpc.DialContext(ctx, "bufconn",
+		grpc.WithContextDialer(func(context.Context, string) (net.Conn, error) {
+			return lis.Dial()
+		}),
+		grpc.WithTransportCredentials(insecure.NewCredentials()),
+	)
+	if err != nil {
+		t.Fatalf("DialContext error: %v", err)
+	}
+	t.Cleanup(func() { conn.Close() })
+
+	stream, err := napv1.NewSpeechToTextServiceClient(conn).StreamTranscription(ctx)
+	if err != nil {
+		t.Fatalf("StreamTranscription error: %v", err)
+	}
+	chunks := []string{"abcd", "efgh", "ijkl"}
+	for i, chunk := range chunks {
+		req := &napv1.StreamTranscriptionRequest{
+			SessionId: "session-1",
+			StreamId:  "file",
+			Segment:   &napv1.Segment{Sequence: uint64(i + 1), Audio: []byte(chunk)},
+			Flush:     i == len(chunks)-1,
+		}
+		if i == 0 {
+			req.Metadata = map[string]string{engine.ModeMetadataKey: engine.ModeBatch}
+		}
+		if err := stream.Send(req); err != nil {
+			t.Fatalf("Send error: %v", err)
+		}
+	}
+
+	resp, err := stream.Recv()
+	if err != nil {
+		t.Fatalf("Recv error: %v", err)
+	}
+	if !resp.GetFinal() || resp.GetText() != "batch 12 bytes" {
+		t.Fatalf("unexpected batch transcript: final=%v text=%q", resp.GetFinal(), resp.GetText())
+	}
+	if _, err := stream.Recv(); !errors.Is(err, io.EOF) {
+		t.Fatalf("expected the stream to end after the batch result, got %v", err)
+	}
+
+	eng.mu.Lock()
+	defer eng.mu.Unlock()
+	if eng.segmentCalls != 0 {
+		t.Fatalf("batch stream should not decode segments, got %d calls", eng.segmentCalls)
+	}
+	if string(eng.batchAudio) != strings.Join(chunks, "") {
+		t.Fatalf("batch audio out of order: %q", eng.batchAudio)
+	}
+}
+
+func TestStreamTranscriptionCoalescesBacklog(t *testing.T) {
+	ctx, cancel := context.WithTimeout(context.Background(), 5*time.Second)
+	defer cancel()
+
+	lis := bufconn.Listen(bufSize)
+	defer lis.Close()
+
+	grpcServer := grpc.NewServer()
+	t.Cleanup(grpcServer.Stop)
+
+	maxLagMs := 0
+	cfg := config.Config{
+		ListenAddr:       "bufconn",
+		ModelVariant:     "small",
+		Language:         "pl",
+		PipelineMaxLagMs: &maxLagMs,
+	}
+	logger := slog.New(slog.NewTextHandler(io.Discard, nil))
+	eng := &blockingEngine{
+		StubEngine: engine.NewStubEngine(logger, cfg.ModelVariant),
+		entered:    make(chan struct{}, 4),
+		unblock:    make(chan struct{}),
+	}
+	recorder := telemetry.NewRecorder(logger)
+	napv1.RegisterSpeechToTextServiceServer(grpcServer, server.New(cfg, logger, eng, recorder))
+
+	go func() {
+		_ = grpcServer.Serve(lis)
+	}()
+
+	conn, err := grpc.DialContext(ctx, "bufconn",
+		grpc.WithContextDialer(func(context.Context, string) (net.Conn, error) {
+			return lis.Dial()
+		}),
+		grpc.WithTransportCredentials(insecure.NewCredentials()),
+	)
+	if err != nil {
+		t.Fatalf("DialContext error: %v", err)
+	}
+	t.Cleanup(func() { conn.Close() })
+
+	stream, err := napv1.NewSpeechToTextServiceClient(conn).StreamTranscription(ctx)
+	if err != nil {
+		t.Fatalf("StreamTranscription error: %v", err)
+	}
+	for seq := uint64(1); seq <= 4; seq++ {
+		if err := stream.Send(&napv1.StreamTranscriptionRequest{
+			SessionId: "session-1",
+			StreamId:  "mic",
+			Segment:   &napv1.Segment{Sequence: seq, Audio: []byte("abcd")},
+		}); err != nil {
+			t.Fatalf("Send segment %d error: %v", seq, err)
+		}
+		if seq == 1 {
+			<-eng.entered
+		}
+	}
+	// The first call is still running; the stream must keep taking segments.
+	for recorder.Snapshot().TotalSegments < 4 {
+		select {
+		case <-ctx.Done():
+			t.Fatalf("segments not received while inference was busy: %d", recorder.Snapshot().TotalSegments)
+		case <-time.After(5 * time.Millisecond):
+		}
+	}
+	close(eng.unblock)
+	if err := stream.CloseSend(); err != nil {
+		t.Fatalf("CloseSend error: %v", err)
+	}
+
+	want := []struct {
+		sequence uint64
+		text     string
+	}{
+		{1, "[stub:small] received 4 bytes"},
+		{4, "[stub:small] received 12 bytes"},
+		{4, "[stub:small] total bytes 16"},
+	}
+	for i, w := range want {
+		resp, err := stream.Recv()
+		if err != nil {
+			t.Fatalf("Recv %d error: %v", i, err)
+		}
+		if resp.GetSequence() != w.sequence || resp.GetText() != w.text {
+			t.Fatalf("response %d: got sequence=%d text=%q, want sequence=%d text=%q", i, resp.GetSequence(), resp.GetText(), w.sequence, w.text)
+		}
+	}
+	if _, err := stream.Recv(); !errors.Is(err, io.EOF) {
+		t.Fatalf("expected EOF after the backlog, got %v", err)
+	}
+	if got := len(eng.entered); got != 1 {
+		t.Fatalf("expected the backlog merged into one call, got %d more calls", got)
+	}
+}
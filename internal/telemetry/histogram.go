@@ -0,0 +1,110 @@
+package telemetry
+
+import (
+	"sync/atomic"
+	"time"
+)
+
+// latencyBuckets are the upper bounds shared by every latency histogram.
+var latencyBuckets = [...]time.Duration{
+	time.Millisecond,
+	2 * time.Millisecond,
+	5 * time.Millisecond,
+	10 * time.Millisecond,
+	20 * time.Millisecond,
+	50 * time.Millisecond,
+	100 * time.Millisecond,
+	200 * time.Millisecond,
+	500 * time.Millisecond,
+	time.Second,
+	2 * time.Second,
+	5 * time.Second,
+	10 * time.Second,
+	30 * time.Second,
+}
+
+// Histogram is a fixed-bucket duration histogram safe for concurrent use.
+// The final bucket counts observations above the largest bound.
+type Histogram struct {
+	counts    [len(latencyBuckets) + 1]atomic.Uint64
+	count     atomic.Uint64
+	sumMicros atomic.Uint64
+}
+
+// HistogramSnapshot is an immutable copy of a Histogram. Counts[i] holds
+// observations up to Bounds[i]; the extra last entry holds the overflow.
+type HistogramSnapshot struct {
+	Bounds []time.Duration
+	Counts []uint64
+	Count  uint64
+	Sum    time.Duration
+}
+
+// Observe records one duration; negative values count as zero.
+func (h *Histogram) Observe(d time.Duration) {
+	if d < 0 {
+		d = 0
+	}
+	idx := len(latencyBuckets)
+	for i, bound := range latencyBuckets {
+		if d <= bound {
+			idx = i
+			break
+		}
+	}
+	h.counts[idx].Add(1)
+	h.count.Add(1)
+	h.sumMicros.Add(uint64(d.Microseconds()))
+}
+
+// Snapshot copies the histogram's current state.
+func (h *Histogram) Snapshot() HistogramSnapshot {
+	counts := make([]uint64, len(h.counts))
+	for i := range h.counts {
+		counts[i] = h.counts[i].Load()
+	}
+	return HistogramSnapshot{
+		Bounds: append([]time.Duration(nil), latencyBuckets[:]...),
+		Counts: counts,
+		Count:  h.count.Load(),
+		Sum:    time.Duration(h.sumMicros.Load()) * time.Microsecond,
+	}
+}
+
+// Mean returns the average observation, or zero when empty.
+func (s HistogramSnapshot) Mean() time.Duration {
+	if s.Count == 0 {
+		return 0
+	}
+	return s.Sum / time.Duration(s.Count)
+}
+
+// Quantile returns the upper bound of the bucket holding quantile q (0..1).
+// Observations beyond the largest bound report that bound.
+func (s HistogramSnapshot) Quantile(q float64) time.Duration {
+	var total uint64
+	for _, c := range s.Counts {
+		total += c
+	}
+	if total == 0 || len(s.Bounds) == 0 {
+		return 0
+	}
+	if q < 0 {
+		q = 0
+	}
+	if q > 1 {
+		q = 1
+	}
+	rank := uint64(q*float64(total-1)) + 1
+	var seen uint64
+	for i, c := range s.Counts {
+		seen += c
+		if seen >= rank {
+			if i < len(s.Bounds) {
+				return s.Bounds[i]
+			}
+			break
+		}
+	}
+	return s.Bounds[len(s.Bounds)-1]
+}
@@ -2,6 +2,8 @@ package telemetry
 
 import (
 	"log/slog"
+	"sort"
+	"sync"
 	"sync/atomic"
 	"time"
 	"unicode/utf8"
@@ -19,6 +21,109 @@ type Recorder struct {
 	totalFinalTranscripts atomic.Uint64
 	totalFlushes          atomic.Uint64
 	totalInferenceMillis  atomic.Uint64
+
+	totalMelFramesComputed atomic.Uint64
+	totalMelFramesReused   atomic.Uint64
+	totalMelComputeMicros  atomic.Uint64
+
+	stageAssembly Histogram
+	stageVAD      Histogram
+	stageMel      Histogram
+	stageEncode   Histogram
+	stageDecode   Histogram
+
+	totalInferencePasses atomic.Uint64
+	totalFallbacks       atomic.Uint64
+	totalAudioCtxRetries atomic.Uint64
+	totalTokens          atomic.Uint64
+	totalWindowSamples   atomic.Uint64
+	totalRepetitionLoops atomic.Uint64
+	totalRepetitionCuts  atomic.Uint64
+	totalBeamReruns      atomic.Uint64
+	totalLanguageDetects atomic.Uint64
+	totalLanguageReuses  atomic.Uint64
+	totalSilentWindows   atomic.Uint64
+	totalSilentSamples   atomic.Uint64
+	totalEndpoints       atomic.Uint64
+	totalEndpointSamples atomic.Uint64
+	totalSpeculations    atomic.Uint64
+	totalSpeculationHits atomic.Uint64
+
+	peakStateBytes   atomic.Uint64
+	peakKVSelfBytes  atomic.Uint64
+	peakKVCrossBytes atomic.Uint64
+
+	modelLoadMicros   atomic.Int64
+	modelWarmupMicros atomic.Int64
+	modelMemory       atomic.Pointer[ModelMemory]
+
+	queueDepth           atomic.Int64
+	peakQueueDepth       atomic.Int64
+	totalAdmitted        atomic.Uint64
+	totalStepsSkipped    atomic.Uint64
+	totalRejected        atomic.Uint64
+	queueWaitInteractive Histogram
+	queueWaitBatch       Histogram
+
+	replicasMu sync.Mutex
+	replicas   map[string]*replicaCounters
+}
+
+type replicaCounters struct {
+	activeSessions  atomic.Int64
+	totalSessions   atomic.Uint64
+	inferencePasses atomic.Uint64
+	inferenceMicros atomic.Uint64
+	memory          atomic.Pointer[ModelMemory]
+}
+
+// InferenceStages breaks down the native work behind one inference call.
+type InferenceStages struct {
+	Assembly time.Duration
+	VAD      time.Duration
+	Mel      time.Duration
+	Encode   time.Duration
+	Decode   time.Duration
+
+	Passes          uint64
+	Fallbacks       uint64
+	AudioCtxRetries uint64
+	Tokens          uint64
+	WindowSamples   uint64
+	RepetitionLoops uint64
+	// RepetitionCuts counts decoders the repetition guard stopped mid-loop.
+	RepetitionCuts uint64
+	// BeamReruns counts greedy windows decoded again with beam search; each
+	// rerun is also one of Passes.
+	BeamReruns uint64
+	// LanguageDetects counts language detections on auto-detect windows;
+	// LanguageReuses the windows decoded in a pinned language instead.
+	LanguageDetects uint64
+	LanguageReuses  uint64
+	// SilentWindows were skipped by the speech gate; SilentSamples counts
+	// their audio plus silence trimmed ahead of speech.
+	SilentWindows uint64
+	SilentSamples uint64
+	// Endpoints counts VAD-mode utterances ended by trailing silence and
+	// EndpointSamples the silence they waited for. Speculations are passes
+	// run once silence began; SpeculationHits those whose text was kept.
+	Endpoints       uint64
+	EndpointSamples uint64
+	Speculations    uint64
+	SpeculationHits uint64
+	// StateMemory is the footprint of the stream's whisper_state after the
+	// call, not a per-call count.
+	StateMemory StateMemory
+}
+
+// StateMemory describes the memory one stream's whisper_state holds, sized
+// from the model shape and decoder count whether it lives on the host or a
+// GPU: the text and cross-attention KV caches, and StateBytes, their sum.
+// The backend's compute buffers are not included.
+type StateMemory struct {
+	StateBytes   uint64
+	KVSelfBytes  uint64
+	KVCrossBytes uint64
 }
 
 // Snapshot captures cumulative metrics recorded so far.
@@ -31,6 +136,98 @@ type Snapshot struct {
 	TotalFinalTranscripts uint64
 	TotalFlushes          uint64
 	TotalInferenceMillis  uint64
+
+	// Mel cache: frames reused from earlier windows instead of recomputed.
+	TotalMelFramesComputed uint64
+	TotalMelFramesReused   uint64
+	TotalMelComputeMicros  uint64
+
+	// Per-call stage latency of native inference.
+	StageAssembly HistogramSnapshot
+	StageVAD      HistogramSnapshot
+	StageMel      HistogramSnapshot
+	StageEncode   HistogramSnapshot
+	StageDecode   HistogramSnapshot
+
+	TotalInferencePasses uint64
+	TotalFallbacks       uint64
+	TotalAudioCtxRetries uint64
+	TotalTokens          uint64
+	TotalWindowSamples   uint64
+	TotalRepetitionLoops uint64
+	TotalRepetitionCuts  uint64
+	TotalBeamReruns      uint64
+	TotalLanguageDetects uint64
+	TotalLanguageReuses  uint64
+
+	// Speech gate: windows and samples kept from the model as silence.
+	// TotalWindowSamples is the audio that was decoded.
+	TotalSilentWindows uint64
+	TotalSilentSamples uint64
+
+	// VAD-mode endpointing: utterances ended, the trailing silence they
+	// waited for, and speculative passes run and kept.
+	TotalEndpoints       uint64
+	TotalEndpointSamples uint64
+	TotalSpeculations    uint64
+	TotalSpeculationHits uint64
+
+	// Largest whisper_state footprint reported by any stream, per field.
+	StateMemory StateMemory
+
+	// Startup cost of the native model: weight loading and the warm-up decode.
+	ModelLoad   time.Duration
+	ModelWarmup time.Duration
+	ModelMemory ModelMemory
+
+	// Admission control: calls queued now and at peak, how queued calls
+	// ended, and how long admitted calls waited per priority.
+	QueueDepth           int64
+	PeakQueueDepth       int64
+	TotalAdmitted        uint64
+	TotalStepsSkipped    uint64
+	TotalRejected        uint64
+	QueueWaitInteractive HistogramSnapshot
+	QueueWaitBatch       HistogramSnapshot
+
+	// Replicas holds per-replica load when the engine spreads streams over
+	// several models or GPUs, sorted by name.
+	Replicas []ReplicaStats
+}
+
+// ReplicaStats is the load carried by one model replica of an engine group.
+// InferenceTime is the encode and decode time spent on it.
+type ReplicaStats struct {
+	Name            string
+	ActiveSessions  int64
+	TotalSessions   uint64
+	InferencePasses uint64
+	InferenceTime   time.Duration
+	ModelMemory     ModelMemory
+}
+
+// MelMillisSaved estimates the mel computation avoided by frame reuse, using
+// the measured cost of the frames that were computed.
+func (s Snapshot) MelMillisSaved() float64 {
+	return melSavedMillis(s.TotalMelFramesComputed, s.TotalMelFramesReused, s.TotalMelComputeMicros)
+}
+
+// BeamRerunRate is the share of greedy windows adaptive decoding repeated
+// with beam search, or 0 before any rerun.
+func (s Snapshot) BeamRerunRate() float64 {
+	if s.TotalBeamReruns == 0 || s.TotalInferencePasses <= s.TotalBeamReruns {
+		return 0
+	}
+	return float64(s.TotalBeamReruns) / float64(s.TotalInferencePasses-s.TotalBeamReruns)
+}
+
+// MeanEndpointWait is the average trailing silence an utterance waited for
+// before its final transcript, or 0 before any endpoint.
+func (s Snapshot) MeanEndpointWait() time.Duration {
+	if s.TotalEndpoints == 0 {
+		return 0
+	}
+	return time.Duration(s.TotalEndpointSamples/s.TotalEndpoints) * time.Second / 16000
 }
 
 // NewRecorder constructs a Recorder using the provided logger.
@@ -57,7 +254,298 @@ func (r *Recorder) Snapshot() Snapshot {
 		TotalFinalTranscripts: r.totalFinalTranscripts.Load(),
 		TotalFlushes:          r.totalFlushes.Load(),
 		TotalInferenceMillis:  r.totalInferenceMillis.Load(),
+
+		TotalMelFramesComputed: r.totalMelFramesComputed.Load(),
+		TotalMelFramesReused:   r.totalMelFramesReused.Load(),
+		TotalMelComputeMicros:  r.totalMelComputeMicros.Load(),
+
+		StageAssembly: r.stageAssembly.Snapshot(),
+		StageVAD:      r.stageVAD.Snapshot(),
+		StageMel:      r.stageMel.Snapshot(),
+		StageEncode:   r.stageEncode.Snapshot(),
+		StageDecode:   r.stageDecode.Snapshot(),
+
+		TotalInferencePasses: r.totalInferencePasses.Load(),
+		TotalFallbacks:       r.totalFallbacks.Load(),
+		TotalAudioCtxRetries: r.totalAudioCtxRetries.Load(),
+		TotalTokens:          r.totalTokens.Load(),
+		TotalWindowSamples:   r.totalWindowSamples.Load(),
+		TotalRepetitionLoops: r.totalRepetitionLoops.Load(),
+		TotalRepetitionCuts:  r.totalRepetitionCuts.Load(),
+		TotalBeamReruns:      r.totalBeamReruns.Load(),
+		TotalLanguageDetects: r.totalLanguageDetects.Load(),
+		TotalLanguageReuses:  r.totalLanguageReuses.Load(),
+
+		TotalSilentWindows: r.totalSilentWindows.Load(),
+		TotalSilentSamples: r.totalSilentSamples.Load(),
+
+		TotalEndpoints:       r.totalEndpoints.Load(),
+		TotalEndpointSamples: r.totalEndpointSamples.Load(),
+		TotalSpeculations:    r.totalSpeculations.Load(),
+		TotalSpeculationHits: r.totalSpeculationHits.Load(),
+
+		StateMemory: StateMemory{
+			StateBytes:   r.peakStateBytes.Load(),
+			KVSelfBytes:  r.peakKVSelfBytes.Load(),
+			KVCrossBytes: r.peakKVCrossBytes.Load(),
+		},
+
+		ModelLoad:   time.Duration(r.modelLoadMicros.Load()) * time.Microsecond,
+		ModelWarmup: time.Duration(r.modelWarmupMicros.Load()) * time.Microsecond,
+		ModelMemory: r.loadModelMemory(),
+
+		QueueDepth:           r.queueDepth.Load(),
+		PeakQueueDepth:       r.peakQueueDepth.Load(),
+		TotalAdmitted:        r.totalAdmitted.Load(),
+		TotalStepsSkipped:    r.totalStepsSkipped.Load(),
+		TotalRejected:        r.totalRejected.Load(),
+		QueueWaitInteractive: r.queueWaitInteractive.Snapshot(),
+		QueueWaitBatch:       r.queueWaitBatch.Snapshot(),
+
+		Replicas: r.replicaSnapshots(),
+	}
+}
+
+func (r *Recorder) replicaSnapshots() []ReplicaStats {
+	r.replicasMu.Lock()
+	defer r.replicasMu.Unlock()
+	if len(r.replicas) == 0 {
+		return nil
+	}
+	out := make([]ReplicaStats, 0, len(r.replicas))
+	for name, c := range r.replicas {
+		stats := ReplicaStats{
+			Name:            name,
+			ActiveSessions:  c.activeSessions.Load(),
+			TotalSessions:   c.totalSessions.Load(),
+			InferencePasses: c.inferencePasses.Load(),
+			InferenceTime:   time.Duration(c.inferenceMicros.Load()) * time.Microsecond,
+		}
+		if memory := c.memory.Load(); memory != nil {
+			stats.ModelMemory = *memory
+		}
+		out = append(out, stats)
+	}
+	sort.Slice(out, func(i, j int) bool { return out[i].Name < out[j].Name })
+	return out
+}
+
+func (r *Recorder) replica(name string) *replicaCounters {
+	r.replicasMu.Lock()
+	defer r.replicasMu.Unlock()
+	c, ok := r.replicas[name]
+	if !ok {
+		if r.replicas == nil {
+			r.replicas = make(map[string]*replicaCounters)
+		}
+		c = &replicaCounters{}
+		r.replicas[name] = c
+	}
+	return c
+}
+
+// RecordReplicaStartup stores one replica's load time and memory footprint.
+func (r *Recorder) RecordReplicaStartup(replica string, load, warmup time.Duration, memory ModelMemory) {
+	if r == nil {
+		return
+	}
+	r.replica(replica).memory.Store(&memory)
+
+	r.log.Info("model replica ready",
+		"replica", replica,
+		"load_ms", load.Milliseconds(),
+		"warmup_ms", warmup.Milliseconds(),
+		"format", memory.Format,
+		"weights_mb", memory.WeightBytes>>20,
+	)
+}
+
+// RecordReplicaSession counts a session opened on, or closed from, replica.
+func (r *Recorder) RecordReplicaSession(replica string, opened bool) {
+	if r == nil {
+		return
+	}
+	c := r.replica(replica)
+	if opened {
+		c.totalSessions.Add(1)
+		c.activeSessions.Add(1)
+	} else {
+		c.activeSessions.Add(-1)
+	}
+}
+
+// RecordReplicaStages attributes one inference call to replica. The call is
+// also reported to RecordStages, which keeps the process-wide totals.
+func (r *Recorder) RecordReplicaStages(replica string, stages InferenceStages) {
+	if r == nil || stages.Passes == 0 {
+		return
+	}
+	c := r.replica(replica)
+	c.inferencePasses.Add(stages.Passes)
+	c.inferenceMicros.Add(uint64((stages.Encode + stages.Decode).Microseconds()))
+}
+
+// ModelMemory describes the loaded model's weights: their ggml format (f16,
+// q5_0, ...), the bytes of tensor data, and how much the process's resident
+// set grew while loading (0 where unavailable).
+type ModelMemory struct {
+	Format        string
+	WeightBytes   uint64
+	ResidentBytes uint64
+}
+
+// RecordStartup stores how long the engine took to load its model and run
+// the warm-up decode, and the model's memory footprint. A zero warmup means
+// warm-up was disabled.
+func (r *Recorder) RecordStartup(load, warmup time.Duration, memory ModelMemory) {
+	if r == nil {
+		return
+	}
+	r.modelLoadMicros.Store(load.Microseconds())
+	r.modelWarmupMicros.Store(warmup.Microseconds())
+	r.modelMemory.Store(&memory)
+
+	r.log.Info("model ready",
+		"load_ms", load.Milliseconds(),
+		"warmup_ms", warmup.Milliseconds(),
+		"format", memory.Format,
+		"weights_mb", memory.WeightBytes>>20,
+		"resident_mb", memory.ResidentBytes>>20,
+	)
+}
+
+func (r *Recorder) loadModelMemory() ModelMemory {
+	if memory := r.modelMemory.Load(); memory != nil {
+		return *memory
+	}
+	return ModelMemory{}
+}
+
+// RecordMelCache accumulates mel frame reuse reported after an inference pass.
+func (r *Recorder) RecordMelCache(framesComputed, framesReused uint64, computeTime time.Duration) {
+	if r == nil || framesComputed+framesReused == 0 {
+		return
+	}
+	micros := uint64(0)
+	if computeTime > 0 {
+		micros = uint64(computeTime.Microseconds())
+	}
+	r.totalMelFramesComputed.Add(framesComputed)
+	r.totalMelFramesReused.Add(framesReused)
+	r.totalMelComputeMicros.Add(micros)
+
+	r.log.Debug("mel frames prepared",
+		"computed", framesComputed,
+		"reused", framesReused,
+		"compute_us", micros,
+		"saved_ms", melSavedMillis(framesComputed, framesReused, micros),
+	)
+}
+
+// RecordStages adds one inference call's stage breakdown to the histograms.
+// Calls in which the speech gate skipped every window, or an endpoint kept a
+// speculative pass, only add to the silence and endpoint totals.
+func (r *Recorder) RecordStages(stages InferenceStages) {
+	if r == nil {
+		return
+	}
+	r.totalSilentWindows.Add(stages.SilentWindows)
+	r.totalSilentSamples.Add(stages.SilentSamples)
+	r.totalEndpoints.Add(stages.Endpoints)
+	r.totalEndpointSamples.Add(stages.EndpointSamples)
+	r.totalSpeculations.Add(stages.Speculations)
+	r.totalSpeculationHits.Add(stages.SpeculationHits)
+	if stages.Passes == 0 {
+		return
+	}
+	r.stageAssembly.Observe(stages.Assembly)
+	r.stageVAD.Observe(stages.VAD)
+	r.stageMel.Observe(stages.Mel)
+	r.stageEncode.Observe(stages.Encode)
+	r.stageDecode.Observe(stages.Decode)
+
+	r.totalInferencePasses.Add(stages.Passes)
+	r.totalFallbacks.Add(stages.Fallbacks)
+	r.totalAudioCtxRetries.Add(stages.AudioCtxRetries)
+	r.totalTokens.Add(stages.Tokens)
+	r.totalWindowSamples.Add(stages.WindowSamples)
+	r.totalRepetitionLoops.Add(stages.RepetitionLoops)
+	r.totalRepetitionCuts.Add(stages.RepetitionCuts)
+	r.totalBeamReruns.Add(stages.BeamReruns)
+	r.totalLanguageDetects.Add(stages.LanguageDetects)
+	r.totalLanguageReuses.Add(stages.LanguageReuses)
+	storeMax(&r.peakStateBytes, stages.StateMemory.StateBytes)
+	storeMax(&r.peakKVSelfBytes, stages.StateMemory.KVSelfBytes)
+	storeMax(&r.peakKVCrossBytes, stages.StateMemory.KVCrossBytes)
+
+	r.log.Debug("inference stages recorded",
+		"assembly_us", stages.Assembly.Microseconds(),
+		"vad_us", stages.VAD.Microseconds(),
+		"mel_us", stages.Mel.Microseconds(),
+		"encode_us", stages.Encode.Microseconds(),
+		"decode_us", stages.Decode.Microseconds(),
+		"passes", stages.Passes,
+		"fallbacks", stages.Fallbacks,
+		"audio_ctx_retries", stages.AudioCtxRetries,
+		"tokens", stages.Tokens,
+		"window_samples", stages.WindowSamples,
+		"repetition_loops", stages.RepetitionLoops,
+		"repetition_cuts", stages.RepetitionCuts,
+		"beam_reruns", stages.BeamReruns,
+		"language_detects", stages.LanguageDetects,
+		"language_reuses", stages.LanguageReuses,
+		"silent_windows", stages.SilentWindows,
+		"silent_samples", stages.SilentSamples,
+		"endpoints", stages.Endpoints,
+		"speculations", stages.Speculations,
+		"kv_self_bytes", stages.StateMemory.KVSelfBytes,
+	)
+}
+
+// storeMax raises peak to value when value is larger.
+func storeMax(peak *atomic.Uint64, value uint64) {
+	for cur := peak.Load(); value > cur; cur = peak.Load() {
+		if peak.CompareAndSwap(cur, value) {
+			return
+		}
+	}
+}
+
+// RecordAdmission tracks one admission queue event. outcome is "admitted",
+// "skipped" or "rejected"; depth is the number of calls still queued.
+func (r *Recorder) RecordAdmission(priority, outcome string, wait time.Duration, depth int) {
+	if r == nil {
+		return
+	}
+	r.queueDepth.Store(int64(depth))
+	for peak := r.peakQueueDepth.Load(); int64(depth) > peak; peak = r.peakQueueDepth.Load() {
+		if r.peakQueueDepth.CompareAndSwap(peak, int64(depth)) {
+			break
+		}
+	}
+	switch outcome {
+	case "admitted":
+		r.totalAdmitted.Add(1)
+		if priority == "batch" {
+			r.queueWaitBatch.Observe(wait)
+		} else {
+			r.queueWaitInteractive.Observe(wait)
+		}
+		r.log.Debug("inference call admitted", "priority", priority, "wait_ms", wait.Milliseconds(), "queue_depth", depth)
+	case "skipped":
+		r.totalStepsSkipped.Add(1)
+		r.log.Debug("inference step merged into the next call", "priority", priority, "wait_ms", wait.Milliseconds(), "queue_depth", depth)
+	default:
+		r.totalRejected.Add(1)
+		r.log.Warn("inference call rejected", "priority", priority, "wait_ms", wait.Milliseconds(), "queue_depth", depth)
+	}
+}
+
+func melSavedMillis(computed, reused, computeMicros uint64) float64 {
+	if computed == 0 {
+		return 0
 	}
+	return float64(reused) * float64(computeMicros) / float64(computed) / 1000
 }
 
 // StreamMetrics accumulates statistics for a single transcription stream.
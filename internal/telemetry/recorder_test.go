@@ -83,3 +83,188 @@ func TestStreamFinishWithError(t *testing.T) {
 		t.Fatalf("unexpected TotalInferenceMillis: %d", snapshot.TotalInferenceMillis)
 	}
 }
+
+func TestRecorderMelCacheSavings(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	recorder.RecordMelCache(100, 300, 4*time.Millisecond)
+	recorder.RecordMelCache(0, 0, time.Millisecond)
+
+	snapshot := recorder.Snapshot()
+	if snapshot.TotalMelFramesComputed != 100 || snapshot.TotalMelFramesReused != 300 {
+		t.Fatalf("unexpected mel frame totals: %+v", snapshot)
+	}
+	if snapshot.TotalMelComputeMicros != 4000 {
+		t.Fatalf("unexpected TotalMelComputeMicros: %d", snapshot.TotalMelComputeMicros)
+	}
+	if got := snapshot.MelMillisSaved(); got != 12 {
+		t.Fatalf("unexpected MelMillisSaved: %v", got)
+	}
+}
+
+func TestRecorderStageHistograms(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	for i := 0; i < 9; i++ {
+		recorder.RecordStages(InferenceStages{
+			Encode:        3 * time.Millisecond,
+			Decode:        40 * time.Millisecond,
+			Passes:        1,
+			Tokens:        12,
+			WindowSamples: 16000,
+		})
+	}
+	recorder.RecordStages(InferenceStages{
+		Encode:    900 * time.Millisecond,
+		Decode:    time.Minute,
+		Passes:    2,
+		Fallbacks: 1,
+	})
+	recorder.RecordStages(InferenceStages{Encode: time.Second})
+
+	snapshot := recorder.Snapshot()
+	if snapshot.TotalInferencePasses != 11 || snapshot.TotalFallbacks != 1 {
+		t.Fatalf("unexpected pass totals: %+v", snapshot)
+	}
+	if snapshot.TotalTokens != 108 || snapshot.TotalWindowSamples != 144000 {
+		t.Fatalf("unexpected token/sample totals: %+v", snapshot)
+	}
+	encode := snapshot.StageEncode
+	if encode.Count != 10 {
+		t.Fatalf("expected 10 encode observations, got %d", encode.Count)
+	}
+	if got := encode.Quantile(0.5); got != 5*time.Millisecond {
+		t.Fatalf("unexpected encode p50: %v", got)
+	}
+	if got := encode.Quantile(1); got != time.Second {
+		t.Fatalf("unexpected encode max bucket: %v", got)
+	}
+	if got := snapshot.StageDecode.Quantile(1); got != 30*time.Second {
+		t.Fatalf("overflow should report the largest bound, got %v", got)
+	}
+	if got := encode.Mean(); got != (27*time.Millisecond+900*time.Millisecond)/10 {
+		t.Fatalf("unexpected encode mean: %v", got)
+	}
+}
+
+func TestRecorderBeamRerunRate(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	if rate := recorder.Snapshot().BeamRerunRate(); rate != 0 {
+		t.Fatalf("expected no rerun rate before any pass, got %v", rate)
+	}
+	recorder.RecordStages(InferenceStages{Passes: 3})
+	recorder.RecordStages(InferenceStages{Passes: 2, BeamReruns: 1})
+
+	snapshot := recorder.Snapshot()
+	if snapshot.TotalBeamReruns != 1 {
+		t.Fatalf("unexpected beam rerun total: %d", snapshot.TotalBeamReruns)
+	}
+	if rate := snapshot.BeamRerunRate(); rate != 0.25 {
+		t.Fatalf("expected one rerun per four greedy windows, got %v", rate)
+	}
+}
+
+func TestRecorderSilenceTotals(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	recorder.RecordStages(InferenceStages{VAD: time.Millisecond, SilentWindows: 3, SilentSamples: 48000})
+	recorder.RecordStages(InferenceStages{Passes: 1, WindowSamples: 16000, SilentSamples: 8000})
+
+	snapshot := recorder.Snapshot()
+	if snapshot.TotalSilentWindows != 3 || snapshot.TotalSilentSamples != 56000 {
+		t.Fatalf("unexpected silence totals: %+v", snapshot)
+	}
+	if snapshot.TotalInferencePasses != 1 || snapshot.StageVAD.Count != 1 {
+		t.Fatalf("gated calls without a pass should not record stages: %+v", snapshot)
+	}
+}
+
+func TestRecorderEndpointTotals(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	recorder.RecordStages(InferenceStages{Passes: 1, Speculations: 1})
+	recorder.RecordStages(InferenceStages{Endpoints: 1, EndpointSamples: 16000, SpeculationHits: 1})
+	recorder.RecordStages(InferenceStages{Passes: 1, Endpoints: 1, EndpointSamples: 8000})
+
+	snapshot := recorder.Snapshot()
+	if snapshot.TotalEndpoints != 2 || snapshot.TotalSpeculations != 1 || snapshot.TotalSpeculationHits != 1 {
+		t.Fatalf("unexpected endpoint totals: %+v", snapshot)
+	}
+	if got := snapshot.MeanEndpointWait(); got != 750*time.Millisecond {
+		t.Fatalf("expected a 750ms mean endpoint wait, got %v", got)
+	}
+	if snapshot.TotalInferencePasses != 2 {
+		t.Fatalf("a kept speculation should not count as a pass: %+v", snapshot)
+	}
+}
+
+func TestRecorderStateMemoryPeaks(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	recorder.RecordStages(InferenceStages{Passes: 1, StateMemory: StateMemory{StateBytes: 24 << 20, KVSelfBytes: 6 << 20, KVCrossBytes: 18 << 20}})
+	recorder.RecordStages(InferenceStages{Passes: 1, StateMemory: StateMemory{StateBytes: 60 << 20, KVSelfBytes: 42 << 20, KVCrossBytes: 18 << 20}})
+	recorder.RecordStages(InferenceStages{Passes: 1, StateMemory: StateMemory{KVSelfBytes: 6 << 20, KVCrossBytes: 18 << 20}})
+
+	want := StateMemory{StateBytes: 60 << 20, KVSelfBytes: 42 << 20, KVCrossBytes: 18 << 20}
+	if got := recorder.Snapshot().StateMemory; got != want {
+		t.Fatalf("unexpected StateMemory: got %+v, want %+v", got, want)
+	}
+}
+
+func TestRecorderStartup(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	recorder.RecordStartup(1200*time.Millisecond, 350*time.Millisecond, ModelMemory{Format: "q5_0", WeightBytes: 52 << 20})
+
+	snapshot := recorder.Snapshot()
+	if snapshot.ModelLoad != 1200*time.Millisecond {
+		t.Fatalf("unexpected ModelLoad: %v", snapshot.ModelLoad)
+	}
+	if snapshot.ModelWarmup != 350*time.Millisecond {
+		t.Fatalf("unexpected ModelWarmup: %v", snapshot.ModelWarmup)
+	}
+	if snapshot.ModelMemory.Format != "q5_0" || snapshot.ModelMemory.WeightBytes != 52<<20 {
+		t.Fatalf("unexpected ModelMemory: %+v", snapshot.ModelMemory)
+	}
+}
+
+func TestRecorderAdmission(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	recorder.RecordAdmission("interactive", "admitted", 0, 0)
+	recorder.RecordAdmission("batch", "admitted", 40*time.Millisecond, 3)
+	recorder.RecordAdmission("interactive", "skipped", time.Second, 2)
+	recorder.RecordAdmission("batch", "rejected", time.Second, 1)
+
+	snapshot := recorder.Snapshot()
+	if snapshot.QueueDepth != 1 || snapshot.PeakQueueDepth != 3 {
+		t.Fatalf("unexpected queue depth: now %d, peak %d", snapshot.QueueDepth, snapshot.PeakQueueDepth)
+	}
+	if snapshot.TotalAdmitted != 2 || snapshot.TotalStepsSkipped != 1 || snapshot.TotalRejected != 1 {
+		t.Fatalf("unexpected admission totals: %+v", snapshot)
+	}
+	if snapshot.QueueWaitInteractive.Count != 1 || snapshot.QueueWaitBatch.Count != 1 {
+		t.Fatalf("unexpected wait observations: %+v", snapshot)
+	}
+	if got := snapshot.QueueWaitBatch.Quantile(1); got != 50*time.Millisecond {
+		t.Fatalf("unexpected batch wait bucket: %v", got)
+	}
+}
+
+func TestRecorderReplicas(t *testing.T) {
+	recorder := NewRecorder(slog.New(slog.NewTextHandler(io.Discard, nil)))
+	if replicas := recorder.Snapshot().Replicas; replicas != nil {
+		t.Fatalf("expected no replicas before any report, got %+v", replicas)
+	}
+	recorder.RecordReplicaStartup("base@gpu1", time.Second, 0, ModelMemory{Format: "f16", WeightBytes: 140 << 20})
+	recorder.RecordReplicaSession("base@gpu1", true)
+	recorder.RecordReplicaSession("base@gpu0", true)
+	recorder.RecordReplicaSession("base@gpu0", true)
+	recorder.RecordReplicaSession("base@gpu0", false)
+	recorder.RecordReplicaStages("base@gpu0", InferenceStages{Encode: 3 * time.Millisecond, Decode: 7 * time.Millisecond, Passes: 2})
+	recorder.RecordReplicaStages("base@gpu1", InferenceStages{SilentWindows: 1})
+
+	replicas := recorder.Snapshot().Replicas
+	if len(replicas) != 2 || replicas[0].Name != "base@gpu0" || replicas[1].Name != "base@gpu1" {
+		t.Fatalf("expected replicas sorted by name, got %+v", replicas)
+	}
+	if gpu0 := replicas[0]; gpu0.ActiveSessions != 1 || gpu0.TotalSessions != 2 || gpu0.InferencePasses != 2 || gpu0.InferenceTime != 10*time.Millisecond {
+		t.Fatalf("unexpected gpu0 stats: %+v", gpu0)
+	}
+	if gpu1 := replicas[1]; gpu1.InferencePasses != 0 || gpu1.ModelMemory.WeightBytes != 140<<20 {
+		t.Fatalf("unexpected gpu1 stats: %+v", gpu1)
+	}
+}